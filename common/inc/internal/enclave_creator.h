@@ -82,6 +82,7 @@ public:
     virtual int mktcs(uint64_t tcs_addr) = 0;
     virtual int trim_range(uint64_t fromaddr, uint64_t toaddr) = 0;
     virtual int trim_accept(uint64_t addr) = 0;
+    virtual int trim_accept_range(uint64_t fromaddr, uint64_t toaddr) = 0;
     virtual int remove_range(uint64_t fromaddr, uint64_t numpages) = 0;
     // destructor
     virtual ~EnclaveCreator() {};
@@ -93,16 +93,87 @@ typedef struct _system_features
 #define BUILTIN_OCALL_1  -2
 #define BUILTIN_OCALL_2  -3
 #define BUILTIN_OCALL_3  -4
+#define BUILTIN_OCALL_4  -5
+#define BUILTIN_OCALL_5  -6
+#define BUILTIN_OCALL_6  -7
+#define BUILTIN_OCALL_7  -8
 
 typedef enum
 {
     EDMM_TRIM = BUILTIN_OCALL_1,
     EDMM_TRIM_COMMIT = BUILTIN_OCALL_2,
     EDMM_MODPR = BUILTIN_OCALL_3,
+    EDMM_TRIM_COMMIT_BATCH = BUILTIN_OCALL_6,
 }edmm_ocall_t;
 
 
-#define is_builtin_ocall(ocall_val) (((int)ocall_val >= BUILTIN_OCALL_3) && ((int)ocall_val <= BUILTIN_OCALL_1))
+/* Upper bound of ranges in one EDMM_TRIM_COMMIT_BATCH, it limits the outside stack usage */
+#define EDMM_TRIM_COMMIT_MAX_RANGES 256
+
+/* A [fromaddr, toaddr) range of trimmed pages committed by EDMM_TRIM_COMMIT_BATCH.
+ * EDMM_TRIM_COMMIT keeps its original single page layout for older enclaves.
+ */
+typedef struct _edmm_trim_range_t
+{
+    size_t fromaddr;
+    size_t toaddr;
+} edmm_trim_range_t;
+
+typedef enum
+{
+    ASYNC_OCALL_SETUP = BUILTIN_OCALL_4,
+    ASYNC_OCALL_FLUSH = BUILTIN_OCALL_5,
+    ASYNC_OCALL_TABLE = BUILTIN_OCALL_7,
+}async_ocall_t;
+
+/* Ring of [async] OCALLs, allocated by the uRTS on ASYNC_OCALL_SETUP.
+ * Enclave threads reserve the slots in order, marshal the call into the slot
+ * and mark it ready, a uRTS worker runs the ready slots in the same order.
+ */
+#define ASYNC_OCALL_RING_SLOTS      64
+#define ASYNC_OCALL_SLOT_SIZE       1024
+#define ASYNC_OCALL_SLOT_DATA_SIZE  (ASYNC_OCALL_SLOT_SIZE - 16)
+
+#define ASYNC_OCALL_SLOT_FREE       0
+#define ASYNC_OCALL_SLOT_RESERVED   1
+#define ASYNC_OCALL_SLOT_READY      2
+#define ASYNC_OCALL_SLOT_CANCELLED  3
+#define ASYNC_OCALL_SLOT_RUNNING    4
+
+typedef struct _async_ocall_slot_t
+{
+    volatile uint32_t state;
+    uint32_t index;                 /* index in the OCALL table */
+    uint32_t table;                 /* OCALL table id from ASYNC_OCALL_TABLE */
+    uint32_t reserved;
+    uint8_t data[ASYNC_OCALL_SLOT_DATA_SIZE];   /* the marshaling structure */
+} async_ocall_slot_t;
+
+typedef struct _async_ocall_ring_t
+{
+    volatile uint64_t head;         /* slots drained by the uRTS */
+    uint64_t reserved[7];
+    async_ocall_slot_t slots[ASYNC_OCALL_RING_SLOTS];
+} async_ocall_ring_t;
+
+typedef struct _ms_async_ocall_setup_t
+{
+    async_ocall_ring_t *ring;
+} ms_async_ocall_setup_t;
+
+/* ECALLs may pass different OCALL tables, so each queued OCALL carries the id
+ * of its table. ASYNC_OCALL_TABLE registers the table of the current ECALL
+ * and returns its id, table 0 is the one the ring was set up with.
+ */
+#define ASYNC_OCALL_MAX_TABLES      8
+#define ASYNC_OCALL_TABLE_NONE      0xFFFFFFFF
+
+typedef struct _ms_async_ocall_table_t
+{
+    uint32_t table;
+} ms_async_ocall_table_t;
+
+#define is_builtin_ocall(ocall_val) (((int)ocall_val >= BUILTIN_OCALL_7) && ((int)ocall_val <= BUILTIN_OCALL_1))
 
 #pragma pack(pop)
 
@@ -32,6 +32,7 @@
 #ifndef _SWITCHLESS_ITF_H_
 #define _SWITCHLESS_ITF_H_
 
+#include <stddef.h>
 #include "sgx_eid.h"
 #include "sgx_error.h"
 
@@ -45,7 +46,13 @@ typedef sgx_status_t(*sl_ecall_func_t)(void*, const unsigned int, void*, int*);
 typedef sgx_status_t(*sl_destroy_func_t)(void*);
 typedef void(*sl_ocall_fallback_func_t)(void*);
 typedef sgx_status_t(*sl_on_first_ecall_func_t)(void*, sgx_enclave_id_t, const void*);
+typedef sgx_status_t(*sl_ecall_submit_func_t)(void*, const unsigned int, void*, uint32_t*);
+typedef sgx_status_t(*sl_ecall_complete_func_t)(void*, const uint32_t, int, int*, int*);
+typedef sgx_status_t(*sl_get_call_stats_func_t)(void*, const int, const uint32_t, void*);
+typedef sgx_status_t(*sl_set_call_timing_func_t)(void*, const int);
 
+/* Members are only ever appended, sgx_set_switchless_itf_ex() is passed the size
+ * of the structure the caller was built with and later members are left NULL */
 typedef struct
 {
     sl_init_func_t sl_init_func_ptr;
@@ -53,15 +60,25 @@ typedef struct
     sl_destroy_func_t sl_destroy_func_ptr;
     sl_ocall_fallback_func_t sl_ocall_fallback_func_ptr;
     sl_on_first_ecall_func_t sl_on_first_ecall_func_ptr;
+    sl_ecall_submit_func_t sl_ecall_submit_func_ptr;
+    sl_ecall_complete_func_t sl_ecall_complete_func_ptr;
+    sl_get_call_stats_func_t sl_get_call_stats_func_ptr;
+    sl_set_call_timing_func_t sl_set_call_timing_func_ptr;
 
 } sgx_switchless_funcs_t;
 
+/* size of the table passed to sgx_set_switchless_itf(), before the asynchronous ECall members */
+#define SL_SWITCHLESS_FUNCS_V1_SIZE offsetof(sgx_switchless_funcs_t, sl_ecall_submit_func_ptr)
+
 
 typedef void(*sgx_set_switchless_itf_func_t)(const sgx_switchless_funcs_t*);
+typedef void(*sgx_set_switchless_itf_ex_func_t)(const sgx_switchless_funcs_t*, size_t);
 
 #define SL_SET_SWITCHLESS_INTERFACE_FUNC_NAME "sgx_set_switchless_itf"
+#define SL_SET_SWITCHLESS_INTERFACE_EX_FUNC_NAME "sgx_set_switchless_itf_ex"
 
 void sgx_set_switchless_itf(const sgx_switchless_funcs_t* sl_funcs);
+void sgx_set_switchless_itf_ex(const sgx_switchless_funcs_t* sl_funcs, size_t size);
 
 #ifdef __cplusplus
 }
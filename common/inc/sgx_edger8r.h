@@ -76,6 +76,40 @@ void* SGXAPI sgx_ocalloc(size_t size);
 */
 void SGXAPI sgx_ocfree(void);
 
+/* sgx_ecall_arena_alloc()
+ * Parameters:
+ *     size - bytes to allocate for a trusted bridge buffer
+ * Return Value:
+ *     the pointer to the allocated space in the per-TCS ECALL arena, which
+ *     is released when the ECALL returns, or from malloc() if it is full
+ *     NULL - fail to allocate
+*/
+void* SGXAPI sgx_ecall_arena_alloc(size_t size);
+
+/* sgx_ecall_arena_free()
+ * Parameters:
+ *      ptr - buffer returned by sgx_ecall_arena_alloc()
+ * Return Value:
+ *      N/A
+*/
+void SGXAPI sgx_ecall_arena_free(void *ptr);
+
+/* sgx_ecall_arena_mark()
+ * Return Value:
+ *     the top of the calling thread's ECALL arena, for the runtime to give
+ *     back with sgx_ecall_arena_rewind() what a trusted bridge took from
+ *     the arena once it returns
+*/
+size_t SGXAPI sgx_ecall_arena_mark(void);
+
+/* sgx_ecall_arena_rewind()
+ * Parameters:
+ *      mark - value returned by sgx_ecall_arena_mark(), 0 empties the arena
+ * Return Value:
+ *      N/A
+*/
+void SGXAPI sgx_ecall_arena_rewind(size_t mark);
+
 /* sgx_ecall()
  * Parameters:
  *     eid         - the enclave id
@@ -94,6 +128,48 @@ sgx_status_t SGXAPI sgx_ecall_switchless(const sgx_enclave_id_t eid,
                               const void* ocall_table,
                               void* ms);
 
+typedef struct _sgx_ecall_handle_t* sgx_ecall_handle_t;
+
+/* sgx_ecall_switchless_async()
+ * Parameters:
+ *     eid         - the enclave id
+ *     index       - the index of the trusted function
+ *     ocall_table - the address of the OCALL table
+ *     ms          - the pointer to the marshaling struct, it is copied
+ *     ms_size     - the size of the marshaling struct
+ *     retval      - where the return value is stored when the call completes
+ *     retval_size - the size of the return value, the first member of ms
+ *     handle      - receives the handle of the call
+ * Return Value:
+ *     SGX_SUCCESS when the handle is returned, the status of the ECALL
+ *     is returned by sgx_ecall_wait() or sgx_ecall_poll()
+*/
+sgx_status_t SGXAPI sgx_ecall_switchless_async(const sgx_enclave_id_t eid,
+                              const int index,
+                              const void* ocall_table,
+                              const void* ms,
+                              const size_t ms_size,
+                              void* retval,
+                              const size_t retval_size,
+                              sgx_ecall_handle_t* handle);
+
+/* sgx_ecall_wait()
+ * Parameters:
+ *     handle      - the handle returned by sgx_ecall_switchless_async()
+ * Return Value:
+ *     the status of the ECALL, the handle is released
+*/
+sgx_status_t SGXAPI sgx_ecall_wait(sgx_ecall_handle_t handle);
+
+/* sgx_ecall_poll()
+ * Parameters:
+ *     handle      - the handle returned by sgx_ecall_switchless_async()
+ * Return Value:
+ *     SGX_ERROR_BUSY - the ECALL is still running, the handle stays valid
+ *     otherwise the status of the ECALL, the handle is released
+*/
+sgx_status_t SGXAPI sgx_ecall_poll(sgx_ecall_handle_t handle);
+
 /* sgx_ocall()
  * Parameters:
  *     index       - the index of the untrusted function
@@ -106,6 +182,35 @@ sgx_status_t SGXAPI sgx_ocall(const unsigned int index,
 sgx_status_t SGXAPI sgx_ocall_switchless(const unsigned int index,
                               void* ms);
 
+/* sgx_async_ocalloc()
+ * Parameters:
+ *     size - bytes to allocate for the marshaling struct of an [async] OCALL
+ * Return Value:
+ *     the pointer to a slot of the ring shared with the uRTS, or to space
+ *     on the outside stack when no slot is available
+ *     NULL - fail to allocate
+*/
+void* SGXAPI sgx_async_ocalloc(size_t size);
+
+/* sgx_async_ocfree()
+ * Parameters:
+ *      N/A
+ * Return Value:
+ *      N/A
+*/
+void SGXAPI sgx_async_ocfree(void);
+
+/* sgx_async_ocall()
+ * Parameters:
+ *     index       - the index of the untrusted function
+ *     ms          - the pointer returned by sgx_async_ocalloc()
+ * Return Value:
+ *     SGX_SUCCESS once the OCALL is queued, or the status of the
+ *     synchronous OCALL when it was not allocated in the ring
+*/
+sgx_status_t SGXAPI sgx_async_ocall(const unsigned int index,
+                              void* ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _SGX_TASK_H_
+#define _SGX_TASK_H_
+
+#include <stddef.h>
+#include "sgx_defs.h"
+
+/* Work-stealing task runtime.
+ *
+ * The runtime doesn't create threads. The enclave donates worker threads
+ * by calling sgx_task_worker_run(), from an ECALL made on a dedicated
+ * untrusted thread or from a thread started with pthread_create(). A
+ * worker stays inside the enclave, running tasks from its own deque and
+ * stealing from the others, and only leaves the enclave to sleep after
+ * spinning idle for a while. A thread waiting on a task group runs tasks
+ * too, so the runtime makes progress even without any worker.
+ */
+
+#define SGX_TASK_MAX_WORKERS    16
+
+typedef void (*sgx_task_fn_t)(void *arg);
+typedef void (*sgx_task_range_fn_t)(size_t begin, size_t end, void *arg);
+
+typedef struct _sgx_task_group_t
+{
+    volatile size_t     m_pending;  /* tasks spawned and not finished yet */
+} sgx_task_group_t;
+
+#define SGX_TASK_GROUP_INITIALIZER  {0}
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* spin_count: idle rounds before a worker or a group waiter sleeps, 0 keeps
+ * the default. */
+int SGXAPI sgx_task_runtime_init(unsigned int spin_count);
+int SGXAPI sgx_task_runtime_shutdown(void);
+
+/* Turns the calling thread into a worker until sgx_task_runtime_shutdown(). */
+int SGXAPI sgx_task_worker_run(void);
+
+int SGXAPI sgx_task_spawn(sgx_task_group_t *group, sgx_task_fn_t fn, void *arg);
+int SGXAPI sgx_task_group_wait(sgx_task_group_t *group);
+
+/* Calls body on chunks of at most grain items covering [begin, end). */
+int SGXAPI sgx_task_parallel_for(size_t begin, size_t end, size_t grain, sgx_task_range_fn_t body, void *arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !_SGX_TASK_H_ */
@@ -102,6 +102,7 @@ typedef void* sgx_hmac_state_handle_t;
 typedef void* sgx_cmac_state_handle_t;
 typedef void* sgx_ecc_state_handle_t;
 typedef void* sgx_aes_state_handle_t;
+typedef void* sgx_rsa3072_state_handle_t;
 
 typedef uint8_t sgx_sha1_hash_t[SGX_SHA1_HASH_SIZE];
 typedef uint8_t sgx_sha256_hash_t[SGX_SHA256_HASH_SIZE];
@@ -456,6 +457,9 @@ extern "C" {
     * calls of the encryption/decryption process for that given stream.  However for
     * new or different datasets/streams, the same counter should not be reused, instead
     * intialize the counter for the new data set.
+    * On success the counter block is advanced by the ceil(src_len / 16) blocks consumed,
+    * so a stream split into calls whose lengths are multiples of 16 bytes gives the
+    * same output as a single call.
     * Note: SGXSSL based version doesn't support user given ctr_inc_bits. It use OpenSSL's implementation
     * which divide the counter block into two parts ([IV][counter])
     *
@@ -504,6 +508,69 @@ extern "C" {
                         const uint32_t ctr_inc_bits,
                         uint8_t *p_dst);
 
+    /** Keyed AES-CTR 128-bit context.
+    *
+    * sgx_aes_ctr_init expands the key once into a context which can then be used
+    * by any number of sgx_aes_ctr_encrypt_ctx/sgx_aes_ctr_decrypt_ctx calls, avoiding
+    * the key expansion the one-shot functions perform on every call. The counter
+    * block stays with the caller and is advanced in place exactly as by
+    * sgx_aes_ctr_encrypt/sgx_aes_ctr_decrypt, so consecutive calls with the same
+    * p_ctr continue the stream. A context must not be used by more than one thread
+    * at a time, and must be released with sgx_aes_ctr_close.
+    *
+    * sgx_aes_ctr_init
+    *      Return: If key or handle pointer is NULL, SGX_ERROR_INVALID_PARAMETER is returned.
+    *              If out of enclave memory, SGX_ERROR_OUT_OF_MEMORY is returned.
+    *              If the key expansion fails then SGX_ERROR_UNEXPECTED is returned.
+    * sgx_aes_ctr_encrypt_ctx/sgx_aes_ctr_decrypt_ctx
+    *      Return: If handle, source, counter, or destination pointer is NULL,
+    *                            SGX_ERROR_INVALID_PARAMETER is returned.
+    *              If the encryption/decryption process fails then SGX_ERROR_UNEXPECTED is returned.
+    *
+    * Parameters:
+    *   Return:
+    *     sgx_status_t - SGX_SUCCESS or failure as defined
+    *                    in sgx_error.h
+    *   Inputs:
+    *     sgx_aes_128bit_key_t *p_key - Pointer to the key used in
+    *                                   encryption/decryption operation
+    *     sgx_aes_state_handle_t aes_ctr_handle - Handle returned by sgx_aes_ctr_init
+    *     uint8_t *p_src, uint32_t src_len, uint8_t *p_ctr, uint32_t ctr_inc_bits -
+    *                      see sgx_aes_ctr_encrypt
+    *   Output:
+    *     sgx_aes_state_handle_t *p_aes_ctr_handle - Handle to the keyed context
+    *     uint8_t *p_dst - Pointer to the cipher text.
+    *                      Size of buffer should be >= src_len.
+    */
+    sgx_status_t SGXAPI sgx_aes_ctr_init(
+                        const sgx_aes_ctr_128bit_key_t *p_key,
+                        sgx_aes_state_handle_t *p_aes_ctr_handle);
+
+    sgx_status_t SGXAPI sgx_aes_ctr_encrypt_ctx(
+                        sgx_aes_state_handle_t aes_ctr_handle,
+                        const uint8_t *p_src,
+                        const uint32_t src_len,
+                        uint8_t *p_ctr,
+                        const uint32_t ctr_inc_bits,
+                        uint8_t *p_dst);
+
+    sgx_status_t SGXAPI sgx_aes_ctr_decrypt_ctx(
+                        sgx_aes_state_handle_t aes_ctr_handle,
+                        const uint8_t *p_src,
+                        const uint32_t src_len,
+                        uint8_t *p_ctr,
+                        const uint32_t ctr_inc_bits,
+                        uint8_t *p_dst);
+
+    /** Clear and free a keyed AES-CTR context.
+    *
+    * Parameters:
+    *   Return: sgx_status_t - SGX_SUCCESS or failure as defined in sgx_error.h
+    *   Input: aes_ctr_handle - Handle returned by sgx_aes_ctr_init.
+    *
+    */
+    sgx_status_t SGXAPI sgx_aes_ctr_close(sgx_aes_state_handle_t aes_ctr_handle);
+
 
 
    /**
@@ -786,6 +853,94 @@ extern "C" {
         const sgx_rsa3072_signature_t *p_signature,
 		sgx_rsa_result_t *p_result);
 
+    /** Imports an RSA 3072 private key into a signing context.
+    *
+    * The context keeps the imported key and the scratch buffer used by the
+    * signing primitive, so that signing many messages with the same key avoids
+    * re-importing the key on every call. A context must not be used by more
+    * than one thread at a time.
+    *
+    * Return: If private key or context pointer is NULL, SGX_ERROR_INVALID_PARAMETER is returned.
+    *         If out of enclave memory, SGX_ERROR_OUT_OF_MEMORY is returned.
+    *         If the key import fails then SGX_ERROR_UNEXPECTED is returned.
+    * Parameters:
+    *   Return: sgx_status_t  - SGX_SUCCESS or failure as defined in sgx_error.h
+    *   Inputs: sgx_rsa3072_key_t *p_key - Pointer to the RSA key.
+    *				Note: In IPP based version p_key->e is unused, hence it can be NULL.
+    *   Output: sgx_rsa3072_state_handle_t *p_rsa_handle - Handle to the signing context
+    */
+    sgx_status_t sgx_rsa3072_sign_ctx_init(const sgx_rsa3072_key_t *p_key,
+        sgx_rsa3072_state_handle_t *p_rsa_handle);
+
+    /** Computes signature for a given data using a signing context, see sgx_rsa3072_sign.
+    *
+    * Return: If context, signature or data pointer is NULL, or the context was not
+    *                    created by sgx_rsa3072_sign_ctx_init, SGX_ERROR_INVALID_PARAMETER is returned.
+    *         If the signing process fails then SGX_ERROR_UNEXPECTED is returned.
+    * Parameters:
+    *   Return: sgx_status_t  - SGX_SUCCESS or failure as defined in sgx_error.h
+    *   Inputs: uint8_t *p_data - Pointer to the data to be signed
+    *           uint32_t data_size - Size of the data to be signed
+    *           sgx_rsa3072_state_handle_t rsa_handle - Handle to the signing context
+    *   Output: sgx_rsa3072_signature_t *p_signature - Pointer to the signature output
+    */
+    sgx_status_t sgx_rsa3072_sign_ctx(const uint8_t *p_data,
+        uint32_t data_size,
+        sgx_rsa3072_state_handle_t rsa_handle,
+        sgx_rsa3072_signature_t *p_signature);
+
+    /** Cleans up and deallocates a signing context, clearing the key material.
+    *
+    * Return: If the context is NULL or not a signing context, SGX_ERROR_INVALID_PARAMETER is returned.
+    * Parameters:
+    *   Return: sgx_status_t  - SGX_SUCCESS or failure as defined in sgx_error.h
+    *   Inputs: sgx_rsa3072_state_handle_t rsa_handle - Handle to the signing context
+    */
+    sgx_status_t sgx_rsa3072_sign_ctx_close(sgx_rsa3072_state_handle_t rsa_handle);
+
+    /** Imports an RSA 3072 public key into a verification context.
+    *
+    * Same as sgx_rsa3072_sign_ctx_init, for verifying many signatures with one public key.
+    *
+    * Return: If public key or context pointer is NULL, SGX_ERROR_INVALID_PARAMETER is returned.
+    *         If out of enclave memory, SGX_ERROR_OUT_OF_MEMORY is returned.
+    *         If the key import fails then SGX_ERROR_UNEXPECTED is returned.
+    * Parameters:
+    *   Return: sgx_status_t  - SGX_SUCCESS or failure as defined in sgx_error.h
+    *   Inputs: sgx_rsa3072_public_key_t *p_public - Pointer to the public key
+    *   Output: sgx_rsa3072_state_handle_t *p_rsa_handle - Handle to the verification context
+    */
+    sgx_status_t sgx_rsa3072_verify_ctx_init(const sgx_rsa3072_public_key_t *p_public,
+        sgx_rsa3072_state_handle_t *p_rsa_handle);
+
+    /** Verifies the signature for the given data using a verification context, see sgx_rsa3072_verify.
+    *
+    * Return: If context, signature, result or data pointer is NULL, or the context was not
+    *                    created by sgx_rsa3072_verify_ctx_init, SGX_ERROR_INVALID_PARAMETER is returned.
+    *         If the verification process fails then SGX_ERROR_UNEXPECTED is returned.
+    * Parameters:
+    *   Return: sgx_status_t  - SGX_SUCCESS or failure as defined in sgx_error.h
+    *   Inputs: uint8_t *p_data - Pointer to the data to be verified
+    *           uint32_t data_size - Size of the data to be verified
+    *           sgx_rsa3072_state_handle_t rsa_handle - Handle to the verification context
+    *           sgx_rsa3072_signature_t *p_signature - Pointer to the signature
+    *   Output: sgx_rsa_result_t *p_result - Pointer to the result of verification check
+    */
+    sgx_status_t sgx_rsa3072_verify_ctx(const uint8_t *p_data,
+        uint32_t data_size,
+        sgx_rsa3072_state_handle_t rsa_handle,
+        const sgx_rsa3072_signature_t *p_signature,
+        sgx_rsa_result_t *p_result);
+
+    /** Cleans up and deallocates a verification context.
+    *
+    * Return: If the context is NULL or not a verification context, SGX_ERROR_INVALID_PARAMETER is returned.
+    * Parameters:
+    *   Return: sgx_status_t  - SGX_SUCCESS or failure as defined in sgx_error.h
+    *   Inputs: sgx_rsa3072_state_handle_t rsa_handle - Handle to the verification context
+    */
+    sgx_status_t sgx_rsa3072_verify_ctx_close(sgx_rsa3072_state_handle_t rsa_handle);
+
     /** Create RSA key pair with <n_byte_size> key size and <e_byte_size> public exponent.
     *
     * Parameters:
@@ -65,6 +65,19 @@ typedef struct _sgx_thread_mutex_t
 #define SGX_THREAD_MUTEX_INITIALIZER \
             SGX_THREAD_NONRECURSIVE_MUTEX_INITIALIZER
 
+/* The upper half of m_control holds the number of iterations a contended
+ * locker spins for the owner to release the mutex before it leaves the
+ * enclave to sleep. 0 parks the locker right away. It is set with
+ * SGX_THREAD_ADAPTIVE_MUTEX_INITIALIZER or sgx_thread_mutex_setspin().
+ */
+#define SGX_THREAD_MUTEX_TYPE_MASK      0x0000FFFF
+#define SGX_THREAD_MUTEX_SPIN_SHIFT     16
+#define SGX_THREAD_MUTEX_SPIN_MAX       0xFFFF
+#define SGX_THREAD_ADAPTIVE_MUTEX_INITIALIZER(spin) \
+            {0, SGX_THREAD_MUTEX_NONRECURSIVE | \
+                (((uint32_t)(spin) & SGX_THREAD_MUTEX_SPIN_MAX) << SGX_THREAD_MUTEX_SPIN_SHIFT), \
+             0, SGX_THREAD_T_NULL, {SGX_THREAD_T_NULL, SGX_THREAD_T_NULL}}
+
 typedef struct _sgx_thread_mutex_attr_t
 {
     unsigned char       m_dummy;  /* for C syntax check */
@@ -84,6 +97,24 @@ typedef struct _sgx_thread_cond_attr_t
     unsigned char       m_dummy;  /* for C syntax check */
 } sgx_thread_condattr_t;
 
+/* Reader-writer lock, waiting writers block new readers */
+typedef struct _sgx_thread_rwlock_t
+{
+    uint32_t            m_reader_count; /* number of readers holding the lock */
+    volatile uint32_t   m_lock;         /* use sgx_spinlock_t */
+    sgx_thread_t        m_owner;        /* writer holding the lock */
+    sgx_thread_queue_t  m_reader_queue;
+    sgx_thread_queue_t  m_writer_queue;
+} sgx_thread_rwlock_t;
+
+#define SGX_THREAD_RWLOCK_INITIALIZER \
+            {0, 0, SGX_THREAD_T_NULL, {SGX_THREAD_T_NULL, SGX_THREAD_T_NULL}, {SGX_THREAD_T_NULL, SGX_THREAD_T_NULL}}
+
+typedef struct _sgx_thread_rwlock_attr_t
+{
+    unsigned char       m_dummy;  /* for C syntax check */
+} sgx_thread_rwlockattr_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -95,15 +126,31 @@ int SGXAPI sgx_thread_mutex_destroy(sgx_thread_mutex_t *mutex);
 int SGXAPI sgx_thread_mutex_lock(sgx_thread_mutex_t *mutex);
 int SGXAPI sgx_thread_mutex_trylock(sgx_thread_mutex_t *mutex);
 int SGXAPI sgx_thread_mutex_unlock(sgx_thread_mutex_t *mutex);
+int SGXAPI sgx_thread_mutex_setspin(sgx_thread_mutex_t *mutex, uint32_t spin_count);
+/* Returns ETIMEDOUT if the mutex could not be locked within timeout_us microseconds.
+ * The timed waits need sgx_thread_wait_untrusted_event_timeout_ocall imported from sgx_tstdc.edl. */
+int SGXAPI sgx_thread_mutex_timedlock(sgx_thread_mutex_t *mutex, uint64_t timeout_us);
 
 /* Condition Variable */
 int SGXAPI sgx_thread_cond_init(sgx_thread_cond_t *cond, const sgx_thread_condattr_t *unused);
 int SGXAPI sgx_thread_cond_destroy(sgx_thread_cond_t *cond);
 
 int SGXAPI sgx_thread_cond_wait(sgx_thread_cond_t *cond, sgx_thread_mutex_t *mutex);
+/* Returns ETIMEDOUT if not signaled within timeout_us microseconds, the mutex is reacquired in both cases */
+int SGXAPI sgx_thread_cond_timedwait(sgx_thread_cond_t *cond, sgx_thread_mutex_t *mutex, uint64_t timeout_us);
 int SGXAPI sgx_thread_cond_signal(sgx_thread_cond_t *cond);
 int SGXAPI sgx_thread_cond_broadcast(sgx_thread_cond_t *cond);
 
+/* Reader-writer lock */
+int SGXAPI sgx_thread_rwlock_init(sgx_thread_rwlock_t *rwlock, const sgx_thread_rwlockattr_t *unused);
+int SGXAPI sgx_thread_rwlock_destroy(sgx_thread_rwlock_t *rwlock);
+
+int SGXAPI sgx_thread_rwlock_rdlock(sgx_thread_rwlock_t *rwlock);
+int SGXAPI sgx_thread_rwlock_tryrdlock(sgx_thread_rwlock_t *rwlock);
+int SGXAPI sgx_thread_rwlock_wrlock(sgx_thread_rwlock_t *rwlock);
+int SGXAPI sgx_thread_rwlock_trywrlock(sgx_thread_rwlock_t *rwlock);
+int SGXAPI sgx_thread_rwlock_unlock(sgx_thread_rwlock_t *rwlock);
+
 sgx_thread_t SGXAPI sgx_thread_self(void);
 int sgx_thread_equal(sgx_thread_t a, sgx_thread_t b);
 
@@ -63,6 +63,40 @@ int SGXAPI sgx_is_within_enclave(const void *addr, size_t size);
 int SGXAPI sgx_is_outside_enclave(const void *addr, size_t size);
 
 
+/* sgx_register_shared_region()
+ * Parameters:
+ *      addr - the start address of an untrusted region
+ *      size - the size of the region
+ * Return Value:
+ *      SGX_SUCCESS - the region is registered, [shared] ECALL parameters
+ *          inside it are passed to the enclave without copying
+ *      SGX_ERROR_INVALID_PARAMETER - the region is empty, not strictly outside
+ *          the enclave, or overlaps a registered region
+ *      SGX_ERROR_OUT_OF_MEMORY - too many regions are registered
+*/
+sgx_status_t SGXAPI sgx_register_shared_region(const void *addr, size_t size);
+
+/* sgx_unregister_shared_region()
+ * Parameters:
+ *      addr - the start address of a registered region
+ * Return Value:
+ *      SGX_SUCCESS - the region is removed
+ *      SGX_ERROR_INVALID_PARAMETER - no region starts at addr
+*/
+sgx_status_t SGXAPI sgx_unregister_shared_region(const void *addr);
+
+/* sgx_is_within_shared_region()
+ * Parameters:
+ *      addr - the start address of the buffer
+ *      size - the size of the buffer
+ * Return Value:
+ *      1 - the buffer is within a single registered shared region
+ *      0 - the buffer is not covered by a registered region,
+ *          or the buffer is wrap around
+*/
+int SGXAPI sgx_is_within_shared_region(const void *addr, size_t size);
+
+
 /* sgx_is_enclave_crashed()
  * Return Value:
  *      1 - the enclave state is crashed.
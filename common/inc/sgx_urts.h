@@ -132,6 +132,58 @@ sgx_status_t SGXAPI sgx_get_target_info(
 	const sgx_enclave_id_t enclave_id,
 	sgx_target_info_t* target_info);
 
+/* By default an ECALL fails with SGX_ERROR_OUT_OF_TCS when every TCS is busy.
+ * With a non-zero timeout_ms it waits, in arrival order, up to timeout_ms
+ * milliseconds (or forever with SGX_TCS_WAIT_INFINITE) for a TCS instead.
+ */
+#define SGX_TCS_WAIT_INFINITE   0xFFFFFFFF
+
+sgx_status_t SGXAPI sgx_set_tcs_wait(
+	const sgx_enclave_id_t enclave_id,
+	const uint32_t timeout_ms);
+
+/* Runtime counters of an enclave, accumulated since it was created. */
+typedef struct _sgx_enclave_stats_t
+{
+    uint64_t ecall_count;               /* ECALLs which entered the enclave */
+    uint64_t ecall_time_ns;             /* time spent in them while timing is enabled, see
+                                           sgx_enable_ecall_timing(). Nested OCALLs are
+                                           included, nested ECALLs are counted once */
+    uint64_t ocall_count;
+    uint64_t exception_count;           /* AEXs handed to the enclave exception handlers */
+    uint64_t out_of_tcs_count;          /* ECALLs failed with SGX_ERROR_OUT_OF_TCS */
+    uint64_t tcs_wait_count;            /* ECALLs which waited for a TCS, see sgx_set_tcs_wait() */
+    uint64_t switchless_fallback_count; /* switchless ECALLs run as regular ECALLs */
+} sgx_enclave_stats_t;
+
+/* ECALLs with an index from SGX_STATS_MAX_ECALLS up are only in the totals. */
+#define SGX_STATS_MAX_ECALLS    256
+
+/* Time the ECALLs of all enclaves and keep the per-index counters read by
+ * sgx_get_enclave_ecall_stats(). Disabled by default, as it reads the clock
+ * twice per ECALL. The time of an ECALL excludes the ECALLs nested in it. */
+sgx_status_t SGXAPI sgx_enable_ecall_timing(const int enable);
+
+sgx_status_t SGXAPI sgx_get_enclave_stats(
+	const sgx_enclave_id_t enclave_id,
+	sgx_enclave_stats_t *stats);
+
+sgx_status_t SGXAPI sgx_get_enclave_ecall_stats(
+	const sgx_enclave_id_t enclave_id,
+	const uint32_t ecall_index,
+	uint64_t *count,
+	uint64_t *time_ns);
+
+/* sgx_get_switchless_call_stats() is declared in sgx_uswitchless.h. */
+
+/* Record ECALL/OCALL entries and exits of all enclaves into per-thread rings
+ * of fixed size. Setting SGX_URTS_TRACE=<file> enables tracing at load time
+ * and writes the trace to <file> on SIGUSR2 and at exit. */
+sgx_status_t SGXAPI sgx_enable_transition_trace(const int enable);
+
+/* Write the recorded transitions as Chrome trace-event JSON. */
+sgx_status_t SGXAPI sgx_dump_transition_trace(const char *filename);
+
 #ifdef __cplusplus
 }
 #endif
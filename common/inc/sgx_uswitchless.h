@@ -140,5 +140,55 @@ typedef struct
 
 #define SGX_USWITCHLESS_CONFIG_INITIALIZER    {0, 1, 1, 0, 0, { 0 } }
 
+/*
+ * Per-function statistics of switchless calls
+ */
+typedef enum {
+    SGX_USWITCHLESS_CALL_OCALL,
+    SGX_USWITCHLESS_CALL_ECALL
+} sgx_uswitchless_call_type_t;
+
+#define SGX_USWITCHLESS_STATS_MAX_FUNCS    256  //functions with a higher index are not recorded
+#define SGX_USWITCHLESS_HIST_BUCKETS       32   //bucket i counts latencies in [2^i, 2^(i+1)) ns
+
+/*
+ * The histograms are only filled while timing is enabled with
+ * sgx_enable_switchless_call_timing(). Trusted workers have no clock, so a
+ * switchless ECall is only timed when its caller is already waiting when a
+ * worker accepts it. The enclave can't timestamp the submission of an OCall.
+ */
+typedef struct
+{
+    uint64_t    calls;      //switchless calls requested, including those that fell back
+    uint64_t    fallbacks;  //calls made as regular ECalls/OCalls instead
+    uint64_t    queue_wait_hist[SGX_USWITCHLESS_HIST_BUCKETS]; //from submission until a worker accepts the call,
+                                                                //only recorded for switchless ECalls
+    uint64_t    exec_hist[SGX_USWITCHLESS_HIST_BUCKETS];       //from acceptance until the call is done
+} sgx_uswitchless_call_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Statistics of the switchless ECALL or OCALL func_index, implemented by the uRTS.
+ * Fails with SGX_ERROR_FEATURE_NOT_SUPPORTED unless the enclave was created
+ * with SGX_CREATE_ENCLAVE_EX_SWITCHLESS and sgx_uswitchless is linked. */
+sgx_status_t SGXAPI sgx_get_switchless_call_stats(
+	const sgx_enclave_id_t enclave_id,
+	const sgx_uswitchless_call_type_t call_type,
+	const uint32_t func_index,
+	sgx_uswitchless_call_stats_t *stats);
+
+/* Fill the latency histograms of the enclave's switchless calls. Disabled by
+ * default, as it reads the clock up to three times per call. The call and
+ * fallback counters are always kept. */
+sgx_status_t SGXAPI sgx_enable_switchless_call_timing(
+	const sgx_enclave_id_t enclave_id,
+	const int enable);
+
+#ifdef __cplusplus
+}
+#endif
+
 
 #endif /* _SGX_USWITCHLESS_H_ */
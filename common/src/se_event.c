@@ -82,6 +82,29 @@ int se_event_wait_timeout(se_handle_t se_event, uint64_t timeout)
     return SE_MUTEX_SUCCESS;
 }
 
+/*
+ * timeout_us: Microsecond
+ * Returns SE_MUTEX_TIMEOUT only when the event was not set in time.
+*/
+int se_event_wait_timeout_us(se_handle_t se_event, uint64_t timeout_us)
+{
+    if (se_event == NULL)
+        return SE_MUTEX_INVALID;
+
+    if (__sync_fetch_and_add((int*)se_event, -1) == 0)
+    {
+        struct timespec time;
+        time.tv_sec = (time_t)(timeout_us / 1000000);
+        time.tv_nsec = (long)(timeout_us % 1000000) * 1000;
+        syscall(__NR_futex, se_event, FUTEX_WAIT, -1, &time, NULL, 0);
+        //Same as se_event_wait_timeout(). If the reset fails, the event was set
+        //between the futex timeout and here, and that wake up is consumed now.
+        if (__sync_bool_compare_and_swap((int*)se_event, -1, 0))
+            return SE_MUTEX_TIMEOUT;
+    }
+
+    return SE_MUTEX_SUCCESS;
+}
 
 int se_event_wake(se_handle_t se_event)
 {
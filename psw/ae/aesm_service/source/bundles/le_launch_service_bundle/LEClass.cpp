@@ -30,6 +30,10 @@
  */
 
 
+// Need this macro definition before inttypes.h to use printing format
+// specifiers(PRIu64 used below) in C++
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
 #include <assert.h>
 #include "LEClass.h"
 #include "aeerror.h"
@@ -155,13 +159,25 @@ int CLEClass::white_list_register(
             AESM_DBG_WARN("Fail to save white list cert in persistent storage");
         }
     }
+    if(AE_SUCCESS == status){
+#ifdef REF_LE
+        uint32_t wl_version = _ntohl(p_white_list->wl_version);
+#else
+        uint32_t wl_version = _ntohl(reinterpret_cast<const wl_cert_chain_t*>(white_list_cert)->wl_cert.wl_version);
+#endif
+        //tokens approved under the previous white list may no longer be granted
+        if(wl_version != m_wl_version){
+            m_token_cache.flush();
+            m_wl_version = wl_version;
+            AESM_DBG_TRACE("launch token cache flushed for white list version %u", wl_version);
+        }
+    }
     if (LE_WHITE_LIST_ALREADY_UPDATED == status) {
                 status = AE_SUCCESS;
     }
     return status;
 }
 
-
 void CLEClass::load_white_cert_list()
 {
     load_verified_white_cert_list();
@@ -302,6 +318,8 @@ ae_error_t CLEClass::load_white_cert_list_to_be_verify()
 ae_error_t CLEClass::load_enclave_only()
 {
     before_enclave_load();
+    //a reloaded LE may be signed differently, don't hand out its predecessor's tokens
+    m_token_cache.flush();
 
     assert(m_enclave_id==0);
     sgx_status_t ret;
@@ -429,6 +447,14 @@ int CLEClass::get_launch_token_internal(
     AESM_DBG_INFO("try to load Enclave with mrsigner:%s , attr %llx, xfrm %llx", mrsigner_info, attr->flags, attr->xfrm);
 #endif
 
+    if(m_token_cache.lookup(reinterpret_cast<sgx_measurement_t*>(mrenclave), &mrsigner,
+        reinterpret_cast<sgx_attributes_t*>(se_attributes), reinterpret_cast<token_t*>(lictoken))){
+        uint64_t hits = 0, misses = 0;
+        m_token_cache.get_stats(&hits, &misses);
+        AESM_DBG_TRACE("launch token cache hit (hits %" PRIu64 ", misses %" PRIu64 ")", hits, misses);
+        return AE_SUCCESS;
+    }
+
     // the interface of the get token API is identical, only the name is different
 #ifdef REF_LE
 #define le_get_launch_token_wrapper ref_le_get_launch_token
@@ -462,5 +488,9 @@ int CLEClass::get_launch_token_internal(
     if(is_ufd()){
         reinterpret_cast<token_t*>(lictoken)->body.valid = 0;
     }
+    if(AE_SUCCESS == status){
+        m_token_cache.insert(reinterpret_cast<sgx_measurement_t*>(mrenclave), &mrsigner,
+            reinterpret_cast<sgx_attributes_t*>(se_attributes), reinterpret_cast<token_t*>(lictoken));
+    }
     return status;
 }
@@ -35,6 +35,7 @@
 #include "AEClass.h"
 #include "ae_debug_flag.hh"
 #include "network_service.h"
+#include "LETokenCache.h"
 
 class CLEClass: public SingletonEnclave<CLEClass>
 {
@@ -42,7 +43,7 @@ class CLEClass: public SingletonEnclave<CLEClass>
     friend class SingletonEnclave<CLEClass>;
     static aesm_enclave_id_t get_enclave_fid(){return LE_ENCLAVE_FID;}
 protected:
-    CLEClass(){};
+    CLEClass():m_ufd(false),m_wl_version(0){};
     ~CLEClass(){};
     virtual int get_debug_flag() { return LE_DEBUG_FLAG;}
     void load_white_cert_list();
@@ -50,6 +51,10 @@ protected:
     ae_error_t load_verified_white_cert_list();
     ae_error_t load_white_cert_list_to_be_verify();
     bool m_ufd; // if LEClass considers the platform ufd
+
+    /* token cache, all accesses are protected by _le_mutex */
+    CLETokenCache m_token_cache;
+    uint32_t m_wl_version; // white list version the cached tokens were approved under
 public:
     virtual ae_error_t load_enclave();/*overload LE load enclave function since i) we have two different LE SigStruct now, ii) we need load white list*/
 	int get_launch_token_internal(
@@ -65,6 +70,10 @@ public:
         bool save_to_persistent_storage=true);
     static ae_error_t update_white_list_by_url(void);
     bool is_ufd() { return m_ufd; }
+    void get_token_cache_stats(uint64_t *hits, uint64_t *misses)
+    {
+        m_token_cache.get_stats(hits, misses);
+    }
 };
 #endif
 
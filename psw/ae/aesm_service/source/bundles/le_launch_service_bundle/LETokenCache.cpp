@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <string.h>
+#include "LETokenCache.h"
+
+bool CLETokenCache::lookup(const sgx_measurement_t *mrenclave, const sgx_measurement_t *mrsigner,
+    const sgx_attributes_t *attributes, token_t *token)
+{
+    for(uint32_t i=0;i<LE_TOKEN_CACHE_SIZE;i++){
+        le_token_cache_entry_t *entry = &m_entries[i];
+        if(entry->last_used != 0 &&
+            memcmp(&entry->mrenclave, mrenclave, sizeof(*mrenclave)) == 0 &&
+            memcmp(&entry->mrsigner, mrsigner, sizeof(*mrsigner)) == 0 &&
+            memcmp(&entry->attributes, attributes, sizeof(*attributes)) == 0){
+            entry->last_used = ++m_tick;
+            memcpy(token, &entry->token, sizeof(*token));
+            m_hits++;
+            return true;
+        }
+    }
+    m_misses++;
+    return false;
+}
+
+void CLETokenCache::insert(const sgx_measurement_t *mrenclave, const sgx_measurement_t *mrsigner,
+    const sgx_attributes_t *attributes, const token_t *token)
+{
+    //reuse an empty slot or evict the least recently used one
+    le_token_cache_entry_t *victim = &m_entries[0];
+    for(uint32_t i=0;i<LE_TOKEN_CACHE_SIZE;i++){
+        if(m_entries[i].last_used < victim->last_used)
+            victim = &m_entries[i];
+        if(victim->last_used == 0)
+            break;
+    }
+    memcpy(&victim->mrenclave, mrenclave, sizeof(*mrenclave));
+    memcpy(&victim->mrsigner, mrsigner, sizeof(*mrsigner));
+    memcpy(&victim->attributes, attributes, sizeof(*attributes));
+    memcpy(&victim->token, token, sizeof(*token));
+    victim->last_used = ++m_tick;
+}
+
+void CLETokenCache::flush()
+{
+    memset(m_entries, 0, sizeof(m_entries));
+}
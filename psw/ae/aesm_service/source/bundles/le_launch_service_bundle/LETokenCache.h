@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _LE_TOKEN_CACHE_H_
+#define _LE_TOKEN_CACHE_H_
+#include "arch.h"
+
+/* Number of launch tokens kept by CLEClass to avoid entering the LE again */
+#define LE_TOKEN_CACHE_SIZE 64
+
+typedef struct _le_token_cache_entry_t{
+    sgx_measurement_t mrenclave;
+    sgx_measurement_t mrsigner;
+    sgx_attributes_t attributes;
+    uint64_t last_used;      /* 0 for an empty slot */
+    token_t token;
+}le_token_cache_entry_t;
+
+/* Launch tokens by enclave identity, the least recently used one is evicted
+ * when full. Not thread safe, CLEClass only uses it under _le_mutex. */
+class CLETokenCache
+{
+public:
+    CLETokenCache():m_tick(0),m_hits(0),m_misses(0){
+        flush();
+    };
+    bool lookup(const sgx_measurement_t *mrenclave, const sgx_measurement_t *mrsigner,
+        const sgx_attributes_t *attributes, token_t *token);
+    void insert(const sgx_measurement_t *mrenclave, const sgx_measurement_t *mrsigner,
+        const sgx_attributes_t *attributes, const token_t *token);
+    void flush();
+    void get_stats(uint64_t *hits, uint64_t *misses)
+    {
+        if(hits != NULL) *hits = m_hits;
+        if(misses != NULL) *misses = m_misses;
+    }
+private:
+    le_token_cache_entry_t m_entries[LE_TOKEN_CACHE_SIZE];
+    uint64_t m_tick;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+#endif
@@ -1,3 +1,7 @@
+// Need this macro definition before inttypes.h to use printing format
+// specifiers(PRIu64 used below) in C++
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
 #include <launch_service.h>
 
 #include "uae_service_internal.h"
@@ -183,7 +187,13 @@ private:
     void stop()
     {
         uint64_t stop_tick_count = se_get_tick_count()+500/1000;
+        uint64_t token_cache_hits = 0, token_cache_misses = 0;
         white_list_thread.stop_thread(stop_tick_count);
+        {
+            AESMLogicLock lock(_le_mutex);
+            CLEClass::instance().get_token_cache_stats(&token_cache_hits, &token_cache_misses);
+        }
+        AESM_DBG_INFO("launch token cache hits %" PRIu64 ", misses %" PRIu64, token_cache_hits, token_cache_misses);
         CLEClass::instance().unload_enclave();
         initialized = false;
         AESM_DBG_INFO("le bundle stopped");
@@ -194,7 +194,8 @@ void AESMQueue<T>::close()
     }
 
     m_events |= QUEUE_EVENT_CLOSE;
-    rc = pthread_cond_signal(&m_queueCond);
+    // the queue may be shared by a pool of workers, wake all of them
+    rc = pthread_cond_broadcast(&m_queueCond);
     if (rc != 0)
     {
         aesm_log_report(AESM_LOG_REPORT_ERROR, "Failed to signal a condition");
@@ -32,16 +32,16 @@
 #define AESM_QUEUE_MANAGER_H
 
 #include "RequestData.h"
-#include "AESMWorkerThread.h"
+#include "AESMWorkerPool.h"
 #include <vector>
 
 class AESMQueueManager 
 {
     public:
         AESMQueueManager(
-                AESMWorkerThread *quotingThread,
-                AESMWorkerThread *launchThread,
-                AESMWorkerThread *platformServiceThread
+                AESMWorkerPool *quotingPool,
+                AESMWorkerPool *launchPool,
+                AESMWorkerPool *platformServicePool
                 );
 
         ~AESMQueueManager();
@@ -54,9 +54,9 @@ class AESMQueueManager
         AESMQueueManager(const AESMQueueManager&);
         void startQueueThreads();
 
-        AESMWorkerThread*   m_quotingThread;
-        AESMWorkerThread*   m_launchThread;
-        AESMWorkerThread*   m_platformServiceThread;
+        AESMWorkerPool*     m_quotingPool;
+        AESMWorkerPool*     m_launchPool;
+        AESMWorkerPool*     m_platformServicePool;
 };
 
 #endif //AESM_QUEUE_MANAGER_H
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef AESM_WORKER_POOL_H
+#define AESM_WORKER_POOL_H
+
+#include "AESMWorkerThread.h"
+#include "IAESMQueue.h"
+#include "RequestData.h"
+#include <vector>
+
+/*
+ * A fixed set of worker threads serving one request class. All workers pop
+ * from the same queue, so a slow request only occupies one of them.
+ */
+class AESMWorkerPool
+{
+    public:
+        AESMWorkerPool(IAESMLogic& aesmLogic, ITransporter& transporter, IAESMQueue<RequestData>* queue, unsigned int size);
+        ~AESMWorkerPool();
+
+        void start();
+        void enqueue(RequestData* request);
+        void shutDown();
+
+    private:
+        AESMWorkerPool& operator=(const AESMWorkerPool&);
+        AESMWorkerPool(const AESMWorkerPool&);
+
+        IAESMQueue<RequestData>*        m_queue;
+        std::vector<AESMWorkerThread*>  m_workers;
+        bool                            m_shutDown;
+};
+
+#endif //AESM_WORKER_POOL_H
@@ -38,6 +38,10 @@
 #include "RequestData.h"
 
 
+/*
+ * The queue is owned by the AESMWorkerPool, it may be shared by several
+ * workers of the same request class.
+ */
 class AESMWorkerThread : public Thread 
 {
     public:
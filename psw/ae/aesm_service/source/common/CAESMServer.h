@@ -39,6 +39,11 @@
 #include "AESMQueueManager.h"
 #include <stdexcept>
 
+/* Number of worker threads serving each request class */
+#define AESM_QUOTING_WORKERS    4
+#define AESM_LAUNCH_WORKERS     2
+#define AESM_PLATFORM_WORKERS   1
+
 /*
  * Encapsulates all AESM server logic
  */
@@ -52,7 +57,7 @@ public:
     void shutDown();
     void init();
 
-    //creates an AESMQueueManager instance with three queues and three work threads (one for each event class) 
+    //creates an AESMQueueManager instance with three queues and a pool of worker threads for each event class
     static AESMQueueManager* constructAESMQueueManager(IAESMLogic& aesmLogic, ITransporter& transporter);
 
 protected:
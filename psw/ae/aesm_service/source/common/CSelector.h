@@ -34,10 +34,18 @@
 #include <list>
 #include "IServerSocket.h"
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+
+#define SELECTOR_MAX_EVENTS 64
 
 class ICommunicationSocket;
 
+/*
+ * Waits for new connections and for requests on connected client sockets.
+ * The listening socket and the termination pipe are level-triggered; client
+ * sockets are registered edge-triggered and are dropped from the epoll set
+ * as soon as they are handed out by getSocsWithNewContent().
+ */
 class CSelector
 {
 public:
@@ -56,9 +64,15 @@ private:
     CSelector& operator=(const CSelector&);
     CSelector(const CSelector&);
 
+    void registerFd(int fd, uint32_t events, void* tag);
+
     IServerSocket* m_serverSock;
-    std::list<ICommunicationSocket*> m_connectedSockets;
-    fd_set m_workingSet;
+    int m_epoll;
+    int m_fdTerm;
+    bool m_serverRegistered;
+    bool m_canAccept;
+    struct epoll_event m_events[SELECTOR_MAX_EVENTS];
+    int m_eventCount;
 };
 
 #endif
@@ -34,29 +34,29 @@
 #include <oal/error_report.h>
 
 AESMQueueManager::AESMQueueManager(
-        AESMWorkerThread *quotingThread,
-        AESMWorkerThread *launchThread,
-        AESMWorkerThread *platformServiceThread
+        AESMWorkerPool *quotingPool,
+        AESMWorkerPool *launchPool,
+        AESMWorkerPool *platformServicePool
         ) :
-    m_quotingThread(quotingThread),
-    m_launchThread(launchThread),
-    m_platformServiceThread(platformServiceThread)
+    m_quotingPool(quotingPool),
+    m_launchPool(launchPool),
+    m_platformServicePool(platformServicePool)
 {
     startQueueThreads();
 }
 
 AESMQueueManager::~AESMQueueManager()
 {
-    delete  m_quotingThread;
-    delete  m_launchThread;
-    delete  m_platformServiceThread;
+    delete  m_quotingPool;
+    delete  m_launchPool;
+    delete  m_platformServicePool;
 }
 
 void AESMQueueManager::startQueueThreads()
 {
-    m_launchThread->start();
-    m_quotingThread->start();
-    m_platformServiceThread->start();
+    m_launchPool->start();
+    m_quotingPool->start();
+    m_platformServicePool->start();
 }
 
 void AESMQueueManager::enqueue(RequestData* requestData)
@@ -65,13 +65,13 @@ void AESMQueueManager::enqueue(RequestData* requestData)
     {
         switch (requestData->getRequest()->getRequestClass()) {
             case IAERequest::QUOTING_CLASS:
-                m_quotingThread->enqueue(requestData);
+                m_quotingPool->enqueue(requestData);
                 break;
             case IAERequest::LAUNCH_CLASS:
-                m_launchThread->enqueue(requestData);
+                m_launchPool->enqueue(requestData);
                 break;
             case IAERequest::PLATFORM_CLASS:
-                m_platformServiceThread->enqueue(requestData);
+                m_platformServicePool->enqueue(requestData);
                 break;
             default:   //if we reach this point, this could only mean a corrupted or a forged message. In any case, close the connection
                        // Closing the connection will translate in an IPC error on the client side in case of corruption (and we would be correct), or in unexpected manner for forged messages (the case of an attacker client)
@@ -88,7 +88,7 @@ void AESMQueueManager::enqueue(RequestData* requestData)
 
 void AESMQueueManager::shutDown()
 {
-    m_launchThread->shutDown();
-    m_quotingThread->shutDown();
-    m_platformServiceThread->shutDown();
+    m_launchPool->shutDown();
+    m_quotingPool->shutDown();
+    m_platformServicePool->shutDown();
 }
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include "AESMWorkerPool.h"
+
+AESMWorkerPool::AESMWorkerPool(IAESMLogic& aesmLogic, ITransporter& transporter, IAESMQueue<RequestData>* queue, unsigned int size)
+    : m_queue(queue),
+    m_workers(),
+    m_shutDown(false)
+{
+    if (size == 0)
+        size = 1;
+    for (unsigned int i = 0; i < size; i++)
+        m_workers.push_back(new AESMWorkerThread(aesmLogic, transporter, queue));
+}
+
+AESMWorkerPool::~AESMWorkerPool()
+{
+    shutDown();
+    for (std::vector<AESMWorkerThread*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+        delete *it;
+    delete m_queue;
+}
+
+void AESMWorkerPool::start()
+{
+    for (std::vector<AESMWorkerThread*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+        (*it)->start();
+}
+
+void AESMWorkerPool::enqueue(RequestData* requestData)
+{
+    if (m_shutDown) {
+        delete requestData;
+        return;
+    }
+    m_queue->push(requestData);
+}
+
+void AESMWorkerPool::shutDown()
+{
+    if (m_shutDown)
+        return;
+    m_shutDown = true;
+
+    std::vector<AESMWorkerThread*>::iterator it;
+    for (it = m_workers.begin(); it != m_workers.end(); ++it)
+        (*it)->stop();
+    // wakes up every worker blocked on the queue
+    m_queue->close();
+    for (it = m_workers.begin(); it != m_workers.end(); ++it)
+        (*it)->join();
+}
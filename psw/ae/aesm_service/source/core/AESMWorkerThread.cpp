@@ -41,7 +41,6 @@ AESMWorkerThread::AESMWorkerThread(IAESMLogic& aesmLogic, ITransporter& transpor
 AESMWorkerThread::~AESMWorkerThread()
 {
     shutDown();
-    delete m_queue;
 }
 
 /*override*/
@@ -49,7 +48,7 @@ void AESMWorkerThread::run()
 {
     while (!isStopped()) {
         RequestData* requestData = m_queue->blockingPop();
-        if (isStopped())
+        if (isStopped() || requestData == NULL)
             break;
         IAEResponse *response = requestData->getRequest()->execute(&m_aesmLogic);
         m_transporter.sendResponse(response, requestData->getSocket());
@@ -33,7 +33,7 @@
 #include "ProtobufSerializer.h"
 #include "RequestData.h"
 #include "AESMQueue.h"
-#include "AESMWorkerThread.h"
+#include "AESMWorkerPool.h"
 
 #include <string>
 #include <aesm_exception.h>
@@ -45,9 +45,9 @@
 AESMQueueManager* CAESMServer::constructAESMQueueManager(IAESMLogic& aesmLogic, ITransporter& transporter)
 {
   return new AESMQueueManager(
-                new AESMWorkerThread(aesmLogic, transporter, new AESMQueue<RequestData>()),
-                new AESMWorkerThread(aesmLogic, transporter, new AESMQueue<RequestData>()),
-                new AESMWorkerThread(aesmLogic, transporter, new AESMQueue<RequestData>())
+                new AESMWorkerPool(aesmLogic, transporter, new AESMQueue<RequestData>(), AESM_QUOTING_WORKERS),
+                new AESMWorkerPool(aesmLogic, transporter, new AESMQueue<RequestData>(), AESM_LAUNCH_WORKERS),
+                new AESMWorkerPool(aesmLogic, transporter, new AESMQueue<RequestData>(), AESM_PLATFORM_WORKERS)
         );
 }
 
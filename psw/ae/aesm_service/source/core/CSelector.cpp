@@ -36,84 +36,103 @@
 #include <unistd.h>
 
 CSelector::CSelector(IServerSocket* serverSock) :
-    m_serverSock(serverSock)
+    m_serverSock(serverSock),
+    m_epoll(-1),
+    m_fdTerm(-1),
+    m_serverRegistered(false),
+    m_canAccept(false),
+    m_eventCount(0)
 {
-    m_connectedSockets.clear();
-    FD_ZERO(&m_workingSet);
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0) {
+        throw "Failed to create epoll instance";
+    }
 }
 
 
 CSelector::~CSelector()
 {
+    if (m_epoll >= 0)
+        close(m_epoll);
+}
+
+void CSelector::registerFd(int fd, uint32_t events, void* tag)
+{
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = tag;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0 && errno != EEXIST) {
+        throw "Failed to add descriptor to epoll set";
+    }
 }
 
 void CSelector::addSocket(ICommunicationSocket* socket)
 {
-    m_connectedSockets.push_back(socket);
+    // a client sends exactly one request per connection, so a single edge
+    // notification is enough to hand the socket over to a worker thread
+    registerFd(socket->getSockDescriptor(), EPOLLIN | EPOLLRDHUP | EPOLLET, socket);
 }
 
 void CSelector::removeSocket(ICommunicationSocket* socket)
 {
-    m_connectedSockets.remove(socket);
+    // the kernel ignores the event argument for EPOLL_CTL_DEL, but kernels
+    // older than 2.6.9 require it to be non-NULL
+    struct epoll_event ev = {};
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket->getSockDescriptor(), &ev);
 }
 
 bool CSelector::select(int fd_term)
 {
-    int max_sd;
-    std::list<ICommunicationSocket*>::const_iterator it = m_connectedSockets.begin();
-
-    FD_ZERO(&m_workingSet);
-    FD_SET(m_serverSock->getSockDescriptor(), &m_workingSet);
-    max_sd = m_serverSock->getSockDescriptor();
-
-    if (fd_term != -1) {
-        // a pipe is setup to prevent select from blocking current thread
-        FD_SET(fd_term, &m_workingSet);
-        if (fd_term > max_sd)
-            max_sd = fd_term;
+    if (!m_serverRegistered) {
+        // the server socket descriptor only exists once the server is
+        // initialized. It is accepted once per wakeup, so keep it
+        // level-triggered to not lose pending connections
+        registerFd(m_serverSock->getSockDescriptor(), EPOLLIN, m_serverSock);
+        m_serverRegistered = true;
     }
 
-    for(; it!=m_connectedSockets.end(); ++it) {
-        int sock_fd = (*it)->getSockDescriptor();
-        if (sock_fd > max_sd)
-            max_sd = sock_fd;
-
-        FD_SET(sock_fd, &m_workingSet);
+    if (fd_term != -1 && fd_term != m_fdTerm) {
+        // a pipe is setup to prevent epoll_wait from blocking current thread
+        registerFd(fd_term, EPOLLIN, &m_fdTerm);
+        m_fdTerm = fd_term;
     }
 
-    int rc = (int) TEMP_FAILURE_RETRY(::select(max_sd + 1, &m_workingSet, NULL, NULL, NULL));
+    m_canAccept = false;
+    m_eventCount = 0;
+    int rc = (int) TEMP_FAILURE_RETRY(epoll_wait(m_epoll, m_events, SELECTOR_MAX_EVENTS, -1));
     if (rc < 0) {
         throw "Select failed"; 
     }
+    m_eventCount = rc;
 
-    if (fd_term != -1 && FD_ISSET(fd_term, &m_workingSet))
-        return false;
+    for (int i = 0; i < rc; i++) {
+        if (m_events[i].data.ptr == &m_fdTerm)
+            return false;
+        if (m_events[i].data.ptr == m_serverSock)
+            m_canAccept = true;
+    }
 
     return true;
 }
 
 bool CSelector::canAcceptConnection()
 {
-    if (FD_ISSET(m_serverSock->getSockDescriptor(), &m_workingSet)) {
-        return true;
-    } else {
-        return false;
-    }
+    return m_canAccept;
 }
 
 std::list<ICommunicationSocket*> CSelector::getSocsWithNewContent()
 {
     std::list<ICommunicationSocket*> socketswithContent;
-    std::list<ICommunicationSocket*>::iterator it = m_connectedSockets.begin();
 
-    while( it!=m_connectedSockets.end())
+    for (int i = 0; i < m_eventCount; i++)
     {
-        if (FD_ISSET((*it)->getSockDescriptor(), &m_workingSet)) {
-            socketswithContent.push_back(*it);
-            m_connectedSockets.erase(it++);
-        } else {
-            ++it;
-        }
+        void* tag = m_events[i].data.ptr;
+        if (tag == &m_fdTerm || tag == m_serverSock)
+            continue;
+
+        ICommunicationSocket* sock = static_cast<ICommunicationSocket*>(tag);
+        removeSocket(sock);
+        socketswithContent.push_back(sock);
     }
 
     return socketswithContent;
@@ -97,7 +97,10 @@ void* Thread::doWork(void* param)
 void Thread::join()
 {
     void* res;
+    if (m_thread == 0)
+        return;
     pthread_join(m_thread, &res);
+    m_thread = 0;
 }
 
 /*--------------------------------------------------------------------------------------------------*/
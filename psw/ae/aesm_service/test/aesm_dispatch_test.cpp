@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Load test of the AESM request dispatch, with the worker pools set up the
+ * way CAESMServer does it and requests that only record what ran them:
+ *  - AESM_QUOTING_WORKERS quotes run at the same time, one more waits;
+ *  - launch and platform requests are all served while every quoting worker
+ *    is blocked, a slow class does not hold up the others;
+ *  - every request gets exactly one response, and the requests enqueued
+ *    after shutting down are deleted without running.
+ * The launch request rate is only printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "AESMQueueManager.h"
+#include "AESMQueue.h"
+#include "CAESMServer.h"
+#include "IAESMLogic.h"
+#include "IAEResponse.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define LOAD_REQUESTS   20000
+#define WAIT_MS         10000
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static bool g_gate_open = false;                /* blocked quotes may finish */
+static unsigned int g_quotes_running = 0;
+static unsigned int g_responses[3] = { 0 };     /* per IAERequest::RequestClass */
+static unsigned int g_live_requests = 0;
+
+void aesm_log_report(int level, const char *format, ...)
+{
+    (void)level;
+    (void)format;
+}
+
+/* waits for cond() under g_lock, fails after WAIT_MS */
+template <typename F>
+static bool wait_for(F cond)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += WAIT_MS / 1000;
+    bool ok = true;
+
+    pthread_mutex_lock(&g_lock);
+    while (!cond() && ok)
+        ok = (pthread_cond_timedwait(&g_cond, &g_lock, &deadline) == 0);
+    ok = cond();
+    pthread_mutex_unlock(&g_lock);
+    return ok;
+}
+
+class MockResponse : public IAEResponse
+{
+public:
+    explicit MockResponse(IAERequest::RequestClass requestClass) : m_class(requestClass) {}
+    AEMessage* serialize() { return NULL; }
+    bool inflateWithMessage(AEMessage*) { return false; }
+    IAERequest::RequestClass m_class;
+};
+
+class MockRequest : public IAERequest
+{
+public:
+    MockRequest(RequestClass requestClass, bool gated) : m_class(requestClass), m_gated(gated)
+    {
+        __atomic_add_fetch(&g_live_requests, 1, __ATOMIC_RELAXED);
+    }
+    ~MockRequest() { __atomic_sub_fetch(&g_live_requests, 1, __ATOMIC_RELAXED); }
+    AEMessage* serialize() { return NULL; }
+    RequestClass getRequestClass() { return m_class; }
+    IAEResponse* execute(IAESMLogic*)
+    {
+        if (m_gated) {
+            pthread_mutex_lock(&g_lock);
+            g_quotes_running++;
+            pthread_cond_broadcast(&g_cond);
+            while (!g_gate_open)
+                pthread_cond_wait(&g_cond, &g_lock);
+            g_quotes_running--;
+            pthread_mutex_unlock(&g_lock);
+        }
+        return new MockResponse(m_class);
+    }
+private:
+    RequestClass m_class;
+    bool m_gated;
+};
+
+class MockTransporter : public ITransporter
+{
+public:
+    uae_oal_status_t transact(IAERequest*, IAEResponse*, uint32_t) { return UAE_OAL_ERROR_UNEXPECTED; }
+    IAERequest* receiveRequest(ICommunicationSocket*) { return NULL; }
+    void sendResponse(IAEResponse* response, ICommunicationSocket*)
+    {
+        MockResponse* mock = static_cast<MockResponse*>(response);
+        pthread_mutex_lock(&g_lock);
+        g_responses[mock->m_class]++;
+        pthread_cond_broadcast(&g_cond);
+        pthread_mutex_unlock(&g_lock);
+    }
+};
+
+/* the requests above never call into the logic */
+class MockLogic : public IAESMLogic
+{
+public:
+    aesm_error_t getLaunchToken(const uint8_t*, uint32_t, const uint8_t*, uint32_t, const uint8_t*, uint32_t,
+                                uint8_t**, uint32_t*) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t initQuote(uint8_t**, uint32_t*, uint8_t**, uint32_t*) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t getQuote(uint32_t, const uint8_t*, uint32_t, uint32_t, const uint8_t*, uint32_t, const uint8_t*,
+                          uint32_t, const uint8_t*, uint32_t, uint8_t**, bool, uint32_t*, uint8_t**) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t select_att_key_id(uint32_t, const uint8_t*, uint32_t*, uint8_t**) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t init_quote_ex(uint32_t, const uint8_t*, uint8_t**, uint32_t*, bool, size_t*, uint8_t**) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t get_quote_size_ex(uint32_t, const uint8_t*, uint32_t*) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t get_quote_ex(uint32_t, const uint8_t*, uint32_t, const uint8_t*, uint32_t, uint8_t*,
+                              uint32_t, uint8_t**) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t reportAttestationStatus(uint8_t*, uint32_t, uint32_t, uint8_t**, uint32_t) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t checkUpdateStatus(uint8_t*, uint32_t, uint8_t**, uint32_t, uint32_t, uint32_t*) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t getWhiteListSize(uint32_t*) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t getWhiteList(uint8_t**, uint32_t) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t sgxGetExtendedEpidGroupId(uint32_t*) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t sgxSwitchExtendedEpidGroup(uint32_t) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t sgxRegister(uint8_t*, uint32_t, uint32_t) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t get_supported_att_key_id_num(uint32_t*) { return AESM_UNEXPECTED_ERROR; }
+    aesm_error_t get_supported_att_key_ids(uint8_t**, uint32_t) { return AESM_UNEXPECTED_ERROR; }
+    void service_stop() {}
+};
+
+static void enqueue(AESMQueueManager* manager, IAERequest::RequestClass requestClass, bool gated)
+{
+    manager->enqueue(new RequestData(NULL, new MockRequest(requestClass, gated)));
+}
+
+static double elapsed_s(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main()
+{
+    MockLogic logic;
+    MockTransporter transporter;
+    AESMQueueManager* manager = new AESMQueueManager(
+        new AESMWorkerPool(logic, transporter, new AESMQueue<RequestData>(), AESM_QUOTING_WORKERS),
+        new AESMWorkerPool(logic, transporter, new AESMQueue<RequestData>(), AESM_LAUNCH_WORKERS),
+        new AESMWorkerPool(logic, transporter, new AESMQueue<RequestData>(), AESM_PLATFORM_WORKERS));
+
+    /* one blocked quote per quoting worker, plus one that has to wait */
+    for (unsigned int i = 0; i <= AESM_QUOTING_WORKERS; i++)
+        enqueue(manager, IAERequest::QUOTING_CLASS, true);
+    CHECK(wait_for([] { return g_quotes_running == AESM_QUOTING_WORKERS; }));
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int i = 0; i < LOAD_REQUESTS; i++)
+        enqueue(manager, (i % 8) ? IAERequest::LAUNCH_CLASS : IAERequest::PLATFORM_CLASS, false);
+    CHECK(wait_for([] {
+        return g_responses[IAERequest::LAUNCH_CLASS] + g_responses[IAERequest::PLATFORM_CLASS] == LOAD_REQUESTS;
+    }));
+    double seconds = elapsed_s(&start);
+
+    pthread_mutex_lock(&g_lock);
+    CHECK(g_responses[IAERequest::QUOTING_CLASS] == 0);
+    CHECK(g_quotes_running == AESM_QUOTING_WORKERS);
+    CHECK(g_responses[IAERequest::PLATFORM_CLASS] == LOAD_REQUESTS / 8);
+    g_gate_open = true;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+    CHECK(wait_for([] { return g_responses[IAERequest::QUOTING_CLASS] == AESM_QUOTING_WORKERS + 1; }));
+    CHECK(wait_for([] { return g_quotes_running == 0; }));
+
+    /* nothing runs after the shut down, late requests are deleted */
+    manager->shutDown();
+    enqueue(manager, IAERequest::QUOTING_CLASS, true);
+    enqueue(manager, IAERequest::LAUNCH_CLASS, false);
+    delete manager;
+    CHECK(g_live_requests == 0);
+    CHECK(g_responses[IAERequest::QUOTING_CLASS] == AESM_QUOTING_WORKERS + 1);
+    CHECK(g_responses[IAERequest::LAUNCH_CLASS] + g_responses[IAERequest::PLATFORM_CLASS] == LOAD_REQUESTS);
+
+    printf("aesm_dispatch_test: %d launch and platform requests in %.3f s (%.0f/s) behind %d blocked quotes\n",
+           LOAD_REQUESTS, seconds, LOAD_REQUESTS / seconds, AESM_QUOTING_WORKERS);
+    return 0;
+}
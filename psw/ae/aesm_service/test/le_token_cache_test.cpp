@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* The launch token cache of the LE service:
+ *  - a token is only returned for the same MRENCLAVE, MRSIGNER and
+ *    attributes it was inserted with;
+ *  - when full, the least recently used token is evicted, a lookup counts
+ *    as a use;
+ *  - flush() drops every token;
+ *  - hits and misses are counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LETokenCache.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+typedef struct _identity_t
+{
+    sgx_measurement_t mrenclave;
+    sgx_measurement_t mrsigner;
+    sgx_attributes_t attributes;
+} identity_t;
+
+/* enclave n of signer n % 4 */
+static identity_t make_identity(uint32_t n)
+{
+    identity_t id;
+    memset(&id, 0, sizeof(id));
+    memcpy(id.mrenclave.m, &n, sizeof(n));
+    id.mrsigner.m[0] = (uint8_t)(n % 4 + 1);
+    id.attributes.flags = SGX_FLAGS_INITTED | SGX_FLAGS_DEBUG | SGX_FLAGS_MODE64BIT;
+    id.attributes.xfrm = 3;
+    return id;
+}
+
+static token_t make_token(uint32_t n)
+{
+    token_t token;
+    memset(&token, 0, sizeof(token));
+    token.body.valid = 1;
+    memcpy(token.mac, &n, sizeof(n));
+    return token;
+}
+
+static bool lookup(CLETokenCache &cache, const identity_t &id, token_t *token)
+{
+    return cache.lookup(&id.mrenclave, &id.mrsigner, &id.attributes, token);
+}
+
+static void insert(CLETokenCache &cache, const identity_t &id, const token_t &token)
+{
+    cache.insert(&id.mrenclave, &id.mrsigner, &id.attributes, &token);
+}
+
+static void check_stats(CLETokenCache &cache, uint64_t hits, uint64_t misses)
+{
+    uint64_t h = 0, m = 0;
+    cache.get_stats(&h, &m);
+    CHECK(h == hits && m == misses);
+}
+
+int main()
+{
+    static CLETokenCache cache;
+    token_t token, expected;
+    uint64_t hits = 0, misses = 0;
+
+    /* exact identity match only */
+    identity_t id = make_identity(1);
+    CHECK(!lookup(cache, id, &token)); misses++;
+    expected = make_token(1);
+    insert(cache, id, expected);
+    CHECK(lookup(cache, id, &token)); hits++;
+    CHECK(memcmp(&token, &expected, sizeof(token)) == 0);
+
+    identity_t other = id;
+    other.mrenclave.m[31] ^= 1;
+    CHECK(!lookup(cache, other, &token)); misses++;
+    other = id;
+    other.mrsigner.m[31] ^= 1;
+    CHECK(!lookup(cache, other, &token)); misses++;
+    other = id;
+    other.attributes.flags &= ~SGX_FLAGS_DEBUG;
+    CHECK(!lookup(cache, other, &token)); misses++;
+    other = id;
+    other.attributes.xfrm = 7;
+    CHECK(!lookup(cache, other, &token)); misses++;
+    check_stats(cache, hits, misses);
+
+    /* fill it up, 1 is already in */
+    for (uint32_t n = 2; n <= LE_TOKEN_CACHE_SIZE; n++)
+        insert(cache, make_identity(n), make_token(n));
+    for (uint32_t n = 1; n <= LE_TOKEN_CACHE_SIZE; n++) {
+        CHECK(lookup(cache, make_identity(n), &token)); hits++;
+        expected = make_token(n);
+        CHECK(memcmp(&token, &expected, sizeof(token)) == 0);
+    }
+
+    /* 1 and 2 are the least recently used, using 1 leaves 2 to be evicted */
+    CHECK(lookup(cache, make_identity(1), &token)); hits++;
+    insert(cache, make_identity(LE_TOKEN_CACHE_SIZE + 1), make_token(LE_TOKEN_CACHE_SIZE + 1));
+    CHECK(!lookup(cache, make_identity(2), &token)); misses++;
+    CHECK(lookup(cache, make_identity(1), &token)); hits++;
+    CHECK(lookup(cache, make_identity(LE_TOKEN_CACHE_SIZE + 1), &token)); hits++;
+    expected = make_token(LE_TOKEN_CACHE_SIZE + 1);
+    CHECK(memcmp(&token, &expected, sizeof(token)) == 0);
+    /* then 3 */
+    insert(cache, make_identity(2), make_token(2));
+    CHECK(!lookup(cache, make_identity(3), &token)); misses++;
+    CHECK(lookup(cache, make_identity(2), &token)); hits++;
+    check_stats(cache, hits, misses);
+
+    /* a flush drops everything, the counters are kept */
+    cache.flush();
+    for (uint32_t n = 1; n <= LE_TOKEN_CACHE_SIZE + 1; n++) {
+        CHECK(!lookup(cache, make_identity(n), &token)); misses++;
+    }
+    insert(cache, make_identity(5), make_token(5));
+    CHECK(lookup(cache, make_identity(5), &token)); hits++;
+    check_stats(cache, hits, misses);
+
+    printf("le_token_cache_test: %d entries, %llu hits, %llu misses\n", LE_TOKEN_CACHE_SIZE,
+           (unsigned long long)hits, (unsigned long long)misses);
+    return 0;
+}
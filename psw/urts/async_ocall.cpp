@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "async_ocall.h"
+#include "se_memory.h"
+#include "tcs.h"
+#include "se_trace.h"
+#include <sched.h>
+#include <string.h>
+
+/* How long an idle worker sleeps before polling the ring again */
+#define ASYNC_OCALL_IDLE_SPIN       64
+#define ASYNC_OCALL_IDLE_SLEEP_US   1000
+
+/* How many times a flush yields for a slot still being marshaled */
+#define ASYNC_OCALL_RESERVED_SPIN   10000
+
+CAsyncOcall::CAsyncOcall(const sgx_ocall_table_t *ocall_table)
+    : m_ring(NULL)
+    , m_table_count(1)
+    , m_event(NULL)
+    , m_worker_valid(false)
+    , m_stop(false)
+{
+    memset(m_ocall_tables, 0, sizeof(m_ocall_tables));
+    m_ocall_tables[0] = ocall_table;
+    se_mutex_init(&m_table_mutex);
+    se_mutex_init(&m_drain_mutex);
+}
+
+CAsyncOcall::~CAsyncOcall()
+{
+    stop();
+    if (m_ring)
+    {
+        // OCALLs queued after the worker stopped, the enclave is gone by now
+        // so a slot still reserved is never going to be ready.
+        drain(false);
+        se_virtual_free(m_ring, sizeof(async_ocall_ring_t), MEM_RELEASE);
+        m_ring = NULL;
+    }
+    if (m_event)
+    {
+        se_event_destroy(m_event);
+        m_event = NULL;
+    }
+    se_mutex_destroy(&m_drain_mutex);
+    se_mutex_destroy(&m_table_mutex);
+}
+
+sgx_status_t CAsyncOcall::start()
+{
+    m_ring = reinterpret_cast<async_ocall_ring_t *>(se_virtual_alloc(NULL, sizeof(async_ocall_ring_t), MEM_COMMIT));
+    if (m_ring == NULL)
+        return SGX_ERROR_OUT_OF_MEMORY;
+    // se_virtual_alloc() returns zeroed pages, every slot is ASYNC_OCALL_SLOT_FREE.
+
+    m_event = se_event_init();
+    if (m_event == NULL)
+        return SGX_ERROR_OUT_OF_MEMORY;
+
+    if (pthread_create(&m_worker, NULL, worker_proc, this) != 0)
+        return SGX_ERROR_UNEXPECTED;
+    m_worker_valid = true;
+    return SGX_SUCCESS;
+}
+
+// Run the queued OCALLs still in the ring, then join the worker. The ring is
+// kept, an enclave thread may still queue OCALLs until the enclave is gone,
+// those are run by the flush of the synchronous fallback.
+void CAsyncOcall::stop()
+{
+    if (!m_worker_valid)
+        return;
+    m_stop = true;
+    se_event_wake(m_event);
+    pthread_join(m_worker, NULL);
+    m_worker_valid = false;
+}
+
+// Called for ASYNC_OCALL_FLUSH, before an [async] OCALL falls back to a
+// synchronous one, so that it does not overtake the OCALLs already queued.
+void CAsyncOcall::flush()
+{
+    drain(true);
+}
+
+// Called for ASYNC_OCALL_TABLE, returns the id the enclave stores in the
+// slots it queues during the current ECALL.
+sgx_status_t CAsyncOcall::register_table(const sgx_ocall_table_t *ocall_table, uint32_t *table)
+{
+    sgx_status_t status = SGX_ERROR_OUT_OF_MEMORY;
+
+    se_mutex_lock(&m_table_mutex);
+    uint32_t count = m_table_count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (m_ocall_tables[i] == ocall_table)
+        {
+            *table = i;
+            status = SGX_SUCCESS;
+            break;
+        }
+    }
+    if (status != SGX_SUCCESS && count < ASYNC_OCALL_MAX_TABLES)
+    {
+        m_ocall_tables[count] = ocall_table;
+        // the worker reads the table once it sees the new count
+        __atomic_store_n(&m_table_count, count + 1, __ATOMIC_RELEASE);
+        *table = count;
+        status = SGX_SUCCESS;
+    }
+    se_mutex_unlock(&m_table_mutex);
+    return status;
+}
+
+size_t CAsyncOcall::drain(bool wait_reserved)
+{
+    size_t count = 0;
+    unsigned int spin = 0;
+
+    se_mutex_lock(&m_drain_mutex);
+    for (;;)
+    {
+        async_ocall_slot_t *slot = &m_ring->slots[m_ring->head % ASYNC_OCALL_RING_SLOTS];
+        uint32_t state = slot->state;
+
+        if (state == ASYNC_OCALL_SLOT_RESERVED && wait_reserved && spin++ < ASYNC_OCALL_RESERVED_SPIN)
+        {
+            sched_yield();
+            continue;
+        }
+        // A slot RUNNING at the head means this is a nested flush from inside
+        // that OCALL, the rest of the ring is run once it returns.
+        if (state != ASYNC_OCALL_SLOT_READY && state != ASYNC_OCALL_SLOT_CANCELLED)
+            break;
+        __sync_synchronize();
+
+        if (state == ASYNC_OCALL_SLOT_READY)
+        {
+            slot->state = ASYNC_OCALL_SLOT_RUNNING;
+            uint32_t table = slot->table;
+            const sgx_ocall_table_t *ocall_table = NULL;
+            if (table < __atomic_load_n(&m_table_count, __ATOMIC_ACQUIRE))
+                ocall_table = m_ocall_tables[table];
+            if (ocall_table != NULL && slot->index < ocall_table->count)
+            {
+                bridge_fn_t bridge = reinterpret_cast<bridge_fn_t>(ocall_table->ocall[slot->index]);
+                bridge(slot->data);
+            }
+            else
+            {
+                SE_TRACE(SE_TRACE_WARNING, "async ocall index %u is out of the ocall table %u\n", slot->index, table);
+            }
+        }
+        __sync_synchronize();
+        slot->state = ASYNC_OCALL_SLOT_FREE;
+        m_ring->head++;
+        spin = 0;
+        count++;
+    }
+    se_mutex_unlock(&m_drain_mutex);
+    return count;
+}
+
+void *CAsyncOcall::worker_proc(void *param)
+{
+    CAsyncOcall *async_ocall = reinterpret_cast<CAsyncOcall *>(param);
+    unsigned int idle = 0;
+
+    while (!async_ocall->m_stop)
+    {
+        if (async_ocall->drain(false))
+        {
+            idle = 0;
+            continue;
+        }
+        // The enclave cannot wake the worker without an OCALL, so an idle
+        // worker backs off to polling the ring every ASYNC_OCALL_IDLE_SLEEP_US.
+        if (++idle < ASYNC_OCALL_IDLE_SPIN)
+            sched_yield();
+        else
+            se_event_wait_timeout_us(async_ocall->m_event, ASYNC_OCALL_IDLE_SLEEP_US);
+    }
+    async_ocall->drain(true);
+    return NULL;
+}
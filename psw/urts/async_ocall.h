@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _ASYNC_OCALL_H_
+#define _ASYNC_OCALL_H_
+
+#include "se_wrapper.h"
+#include "sgx_urts.h"
+#include "routine.h"
+#include "rts.h"
+#include "uncopyable.h"
+#include <pthread.h>
+
+/* The untrusted side of [async] OCALLs: it owns the ring shared with the
+ * enclave and a worker thread running the queued OCALLs in order. Each
+ * queued OCALL runs with the OCALL table registered for its ECALL.
+ */
+class CAsyncOcall: private Uncopyable
+{
+public:
+    explicit CAsyncOcall(const sgx_ocall_table_t *ocall_table);
+    ~CAsyncOcall();
+    sgx_status_t start();
+    void stop();
+    void flush();
+    sgx_status_t register_table(const sgx_ocall_table_t *ocall_table, uint32_t *table);
+    async_ocall_ring_t *get_ring() { return m_ring; }
+private:
+    static void *worker_proc(void *param);
+    size_t drain(bool wait_reserved);
+
+    async_ocall_ring_t          *m_ring;
+    const sgx_ocall_table_t     *m_ocall_tables[ASYNC_OCALL_MAX_TABLES];
+    volatile uint32_t           m_table_count;
+    se_mutex_t                  m_table_mutex;
+    se_mutex_t                  m_drain_mutex;
+    se_handle_t                 m_event;
+    pthread_t                   m_worker;
+    bool                        m_worker_valid;
+    volatile bool               m_stop;
+};
+
+#endif
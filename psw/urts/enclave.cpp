@@ -45,6 +45,9 @@
 #include "rts.h"
 #include "get_thread_id.h"
 #include "sgx_switchless_itf.h"
+#include "urts_trace.h"
+#include "urts_probes.h"
+#include "async_ocall.h"
 
 
 int do_ecall(const int fn, const void *ocall_table, const void *ms, CTrustThread *trust_thread);
@@ -66,12 +69,18 @@ CEnclave::CEnclave()
     , m_new_thread_event(NULL)
     , m_sealed_key(NULL)
     , m_switchless(NULL)
+    , m_switchless_destroyed(false)
     , m_first_ecall(true)
     , m_dynamic_tcs_list_size(0)
+    , m_out_of_tcs_count(0)
+    , m_switchless_fallback_count(0)
+    , m_async_ocall(NULL)
 {
     memset(&m_enclave_info, 0, sizeof(debug_enclave_info_t));
     memset(&m_target_info, 0, sizeof(sgx_target_info_t));
     se_init_rwlock(&m_rwlock);
+    se_init_rwlock(&m_switchless_rwlock);
+    se_mutex_init(&m_async_ocall_mutex);
 #ifdef SE_SIM
     m_global_data_sim_ptr = NULL;
 #endif
@@ -79,11 +88,21 @@ CEnclave::CEnclave()
 }
 
 // global for all the enclaves in application
-sgx_switchless_funcs_t g_sl_funcs = { NULL, NULL, NULL, NULL, NULL };
+sgx_switchless_funcs_t g_sl_funcs = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
 
+// Older sgx_uswitchless libraries call this one, their table ends with sl_on_first_ecall_func_ptr.
 void sgx_set_switchless_itf(const sgx_switchless_funcs_t* sl_funcs)
 {
-    g_sl_funcs = *sl_funcs;
+    sgx_set_switchless_itf_ex(sl_funcs, SL_SWITCHLESS_FUNCS_V1_SIZE);
+}
+
+// Copy only the members the caller knows about, the others stay NULL.
+void sgx_set_switchless_itf_ex(const sgx_switchless_funcs_t* sl_funcs, size_t size)
+{
+    sgx_switchless_funcs_t funcs;
+    memset(&funcs, 0, sizeof(funcs));
+    memcpy(&funcs, sl_funcs, size < sizeof(funcs) ? size : sizeof(funcs));
+    g_sl_funcs = funcs;
 }
 
 
@@ -118,12 +137,85 @@ on_exit:
 
 void CEnclave::destroy_uswitchless(void)
 {
+    // Wait for the ecall_async_complete() in progress and fail the later ones.
+    // m_rwlock can't be taken for write here, the trusted workers hold it for read until sl_destroy_func_ptr() stops them.
+    se_wtlock(&m_switchless_rwlock);
+    m_switchless_destroyed = true;
+    se_wtunlock(&m_switchless_rwlock);
+
     if (m_switchless)
     {
         g_sl_funcs.sl_destroy_func_ptr(m_switchless);
     }
 }
 
+void CEnclave::destroy_async_ocall(void)
+{
+    se_mutex_lock(&m_async_ocall_mutex);
+    if (m_async_ocall)
+    {
+        m_async_ocall->stop();
+    }
+    se_mutex_unlock(&m_async_ocall_mutex);
+}
+
+// The ring of [async] OCALLs is created on the first [async] OCALL of the
+// enclave. The OCALL table of that ECALL is table 0 of the ring, the one
+// used by enclaves which don't ask for ASYNC_OCALL_TABLE.
+int CEnclave::ocall_async_setup(const sgx_ocall_table_t *ocall_table, void *ms)
+{
+    ms_async_ocall_setup_t *pms = reinterpret_cast<ms_async_ocall_setup_t *>(ms);
+    int error = SGX_SUCCESS;
+
+    if (pms == NULL || ocall_table == NULL)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    se_mutex_lock(&m_async_ocall_mutex);
+    if (m_async_ocall == NULL)
+    {
+        CAsyncOcall *async_ocall = new CAsyncOcall(ocall_table);
+        error = async_ocall->start();
+        if (error == SGX_SUCCESS)
+            m_async_ocall = async_ocall;
+        else
+            delete async_ocall;
+    }
+    pms->ring = m_async_ocall ? m_async_ocall->get_ring() : NULL;
+    se_mutex_unlock(&m_async_ocall_mutex);
+    return error;
+}
+
+int CEnclave::ocall_async_table(const sgx_ocall_table_t *ocall_table, void *ms)
+{
+    ms_async_ocall_table_t *pms = reinterpret_cast<ms_async_ocall_table_t *>(ms);
+    int error = SGX_ERROR_UNEXPECTED;
+
+    if (pms == NULL || ocall_table == NULL)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    se_mutex_lock(&m_async_ocall_mutex);
+    if (m_async_ocall)
+    {
+        uint32_t table = ASYNC_OCALL_TABLE_NONE;
+        error = m_async_ocall->register_table(ocall_table, &table);
+        pms->table = table;
+    }
+    se_mutex_unlock(&m_async_ocall_mutex);
+    return error;
+}
+
+int CEnclave::ocall_async_flush()
+{
+    se_mutex_lock(&m_async_ocall_mutex);
+    CAsyncOcall *async_ocall = m_async_ocall;
+    se_mutex_unlock(&m_async_ocall_mutex);
+
+    if (async_ocall == NULL)
+        return SGX_ERROR_UNEXPECTED;
+    async_ocall->flush();
+    return SGX_SUCCESS;
+}
+
 
 sgx_status_t CEnclave::initialize(const se_file_t& file,  CLoader &ldr, const uint64_t enclave_size, const uint32_t tcs_policy, const uint32_t enclave_version, const uint32_t tcs_min_pool)
 {
@@ -213,10 +305,18 @@ CEnclave::~CEnclave()
         m_thread_pool = NULL;
     }
 
+    if (m_async_ocall)
+    {
+        delete m_async_ocall;
+        m_async_ocall = NULL;
+    }
+    se_mutex_destroy(&m_async_ocall_mutex);
+
     m_ocall_table = NULL;
 
 
     destory_debug_info(&m_enclave_info);
+    se_fini_rwlock(&m_switchless_rwlock);
     se_fini_rwlock(&m_rwlock);
         
     se_event_destroy(m_new_thread_event);
@@ -292,6 +392,82 @@ sgx_status_t CEnclave::error_trts2urts(unsigned int trts_error)
     return (sgx_status_t)trts_error;
 }
 
+void CEnclave::on_first_ecall(const void *ocall_table)
+{
+    // we need to pass ocall_table pointer to the enclave when initializing switchless on trusted side.
+    if (m_first_ecall && ocall_table)
+    {
+        // can create race condition here if we have several threads initiating "first" ecall
+        // so it is possible the first switchless ecall will fallback
+        m_first_ecall = false;
+        // we are setting the flag here, cause otherwise it will create deadlock in sl_on_first_ecall_func_ptr()
+        g_sl_funcs.sl_on_first_ecall_func_ptr(m_switchless, m_enclave_id, ocall_table);
+    }
+}
+
+// Queue a switchless ECall without waiting for it. SGX_ERROR_BUSY means no
+// trusted worker took it and the caller has to make an ordinary ECall.
+sgx_status_t CEnclave::ecall_async_submit(const int proc, const void *ocall_table, void *ms, uint32_t *line)
+{
+    if(!se_try_rdlock(&m_rwlock))
+        return SGX_ERROR_ENCLAVE_LOST;
+    se_rdlock(&m_switchless_rwlock);
+
+    sgx_status_t ret = SGX_ERROR_BUSY;
+    if(m_destroyed)
+    {
+        ret = SGX_ERROR_ENCLAVE_LOST;
+    }
+    else if (m_switchless && !m_switchless_destroyed && g_sl_funcs.sl_ecall_submit_func_ptr && g_sl_funcs.sl_ecall_complete_func_ptr)
+    {
+        on_first_ecall(ocall_table);
+        ret = g_sl_funcs.sl_ecall_submit_func_ptr(m_switchless, proc, ms, line);
+    }
+    if (ret == SGX_ERROR_BUSY)
+    {
+        __atomic_add_fetch(&m_switchless_fallback_count, 1, __ATOMIC_RELAXED);
+        URTS_PROBE2(switchless_fallback, m_enclave_id, proc);
+    }
+
+    se_rdunlock(&m_switchless_rwlock);
+    se_rdunlock(&m_rwlock);
+    return ret;
+}
+
+// SGX_ERROR_ENCLAVE_LOST with *done set means the switchless handle or the enclave
+// was destroyed while the call was queued, the call must not be retried.
+sgx_status_t CEnclave::ecall_async_complete(const uint32_t line, const bool wait, bool *done, bool *need_fallback)
+{
+    *done = true;
+    *need_fallback = false;
+    if(!se_try_rdlock(&m_rwlock))
+        return SGX_ERROR_ENCLAVE_LOST;
+    se_rdlock(&m_switchless_rwlock);
+
+    int is_done = 1;
+    int fallback = 0;
+    sgx_status_t ret = SGX_ERROR_ENCLAVE_LOST;
+
+    //Maybe the enclave has been destroyed after acquire/release m_rwlock. See CEnclave::destroy()
+    if (m_destroyed || m_switchless_destroyed)
+        goto on_exit;
+
+    ret = g_sl_funcs.sl_ecall_complete_func_ptr(m_switchless, line, wait ? 1 : 0, &is_done, &fallback);
+
+    *done = (is_done != 0);
+    *need_fallback = (fallback != 0);
+    if (*need_fallback)
+    {
+        __atomic_add_fetch(&m_switchless_fallback_count, 1, __ATOMIC_RELAXED);
+        URTS_PROBE2(switchless_fallback, m_enclave_id, -1);
+    }
+
+on_exit:
+    se_rdunlock(&m_switchless_rwlock);
+    se_rdunlock(&m_rwlock);
+    return ret;
+}
+
 sgx_status_t CEnclave::ecall(const int proc, const void *ocall_table, void *ms, const bool is_switchless)
 {
     if(se_try_rdlock(&m_rwlock))
@@ -305,15 +481,7 @@ sgx_status_t CEnclave::ecall(const int proc, const void *ocall_table, void *ms,
 
         if (m_switchless)
         {
-            // we need to pass ocall_table pointer to the enclave when initializing switchless on trusted side.
-            if (m_first_ecall && ocall_table)
-            {
-                // can create race condition here if we have several threads initiating "first" ecall
-                // so it is possible the first switchless ecall will fallback
-                m_first_ecall = false;
-                // we are setting the flag here, cause otherwise it will create deadlock in sl_on_first_ecall_func_ptr()
-                g_sl_funcs.sl_on_first_ecall_func_ptr(m_switchless, m_enclave_id, ocall_table);
-            }
+            on_first_ecall(ocall_table);
 
             //Do switchless ECall in a switchless way
             if (is_switchless)
@@ -328,7 +496,8 @@ sgx_status_t CEnclave::ecall(const int proc, const void *ocall_table, void *ms,
                     se_rdunlock(&m_rwlock);
                     return ret;
                 }
-
+                __atomic_add_fetch(&m_switchless_fallback_count, 1, __ATOMIC_RELAXED);
+                URTS_PROBE2(switchless_fallback, m_enclave_id, proc);
             }
 
         }
@@ -385,12 +554,33 @@ sgx_status_t CEnclave::ecall(const int proc, const void *ocall_table, void *ms,
                 }
             }
 
+            bool timed = proc >= 0 && __builtin_expect(g_ecall_timing_enabled, 0);
+            uint64_t start = 0, saved_nested_ns = 0;
+            if(timed)
+                start = trust_thread->begin_timed_ecall(&saved_nested_ns);
+            if(ECMD_EXCEPT == proc)
+                URTS_PROBE2(exception_ecall, m_enclave_id, trust_thread->get_tcs());
+            URTS_PROBE2(ecall_entry, m_enclave_id, proc);
+            urts_trace(URTS_TRACE_ECALL_ENTER, proc);
             ret = do_ecall(proc, m_ocall_table, ms, trust_thread);
+            urts_trace(URTS_TRACE_ECALL_EXIT, proc);
+            URTS_PROBE3(ecall_return, m_enclave_id, proc, ret);
+            if(ECMD_EXCEPT == proc)
+                trust_thread->count_exception();
+            else if(timed)
+                trust_thread->end_timed_ecall(proc, start, saved_nested_ns);
+            else if(proc >= 0)
+                trust_thread->count_ecall();
             if(SGX_PTHREAD_EXIT == ret)
                 //If the ECALL exists by pthread_exit(), then reset the tcs's reference to "0" directly.
                 trust_thread->reset_ref();
             else
                 trust_thread->decrease_ref();
+            m_thread_pool->release_thread(trust_thread);
+        }
+        else
+        {
+            __atomic_add_fetch(&m_out_of_tcs_count, 1, __ATOMIC_RELAXED);
         }
 
         //release the read/write lock, the only exception is enclave already be removed in ocall
@@ -406,10 +596,14 @@ sgx_status_t CEnclave::ecall(const int proc, const void *ocall_table, void *ms,
     }
 }
 
-int CEnclave::ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_table, void *ms)
+int CEnclave::ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_table, void *ms, CTrustThread *trust_thread)
 {
     int error = SGX_ERROR_UNEXPECTED;
 
+    trust_thread->count_ocall();
+    URTS_PROBE2(ocall_entry, m_enclave_id, proc);
+    urts_trace(URTS_TRACE_OCALL_ENTER, (int)proc);
+
     if (is_builtin_ocall(proc))
     {
         se_rdunlock(&m_rwlock);
@@ -417,8 +611,16 @@ int CEnclave::ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_tabl
 			error = ocall_trim_range(ms);
 		else if ((int)proc == EDMM_TRIM_COMMIT)
 			error = ocall_trim_accept(ms);
+		else if ((int)proc == EDMM_TRIM_COMMIT_BATCH)
+			error = ocall_trim_accept_batch(ms);
 		else if ((int)proc == EDMM_MODPR)
 			error = ocall_emodpr(ms);
+		else if ((int)proc == ASYNC_OCALL_SETUP)
+			error = ocall_async_setup(ocall_table, ms);
+		else if ((int)proc == ASYNC_OCALL_FLUSH)
+			error = ocall_async_flush();
+		else if ((int)proc == ASYNC_OCALL_TABLE)
+			error = ocall_async_table(ocall_table, ms);
     }
     else 
     {
@@ -426,6 +628,8 @@ int CEnclave::ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_tabl
         if(NULL == ocall_table ||
                 (proc >= ocall_table->count))
         {
+            urts_trace(URTS_TRACE_OCALL_EXIT, (int)proc);
+            URTS_PROBE3(ocall_return, m_enclave_id, proc, SGX_ERROR_INVALID_FUNCTION);
             return SGX_ERROR_INVALID_FUNCTION;
         }
 
@@ -438,6 +642,8 @@ int CEnclave::ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_tabl
         bridge_fn_t bridge = reinterpret_cast<bridge_fn_t>(ocall_table->ocall[proc]);
         error = do_ocall(bridge, ms);
     }
+    urts_trace(URTS_TRACE_OCALL_EXIT, (int)proc);
+    URTS_PROBE3(ocall_return, m_enclave_id, proc, error);
 
     if (!se_try_rdlock(&m_rwlock))
     {
@@ -454,6 +660,66 @@ int CEnclave::ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_tabl
     return error;
 }
 
+void CEnclave::get_stats(sgx_enclave_stats_t *stats)
+{
+    memset(stats, 0, sizeof(sgx_enclave_stats_t));
+
+    std::vector<CTrustThread *> threads = m_thread_pool->get_thread_list();
+    for (unsigned idx = 0; idx < threads.size(); ++idx)
+    {
+        tcs_stats_t *tcs_stats = threads[idx]->get_stats();
+        stats->ecall_count += TCS_STATS_GET(tcs_stats->ecall_count);
+        stats->ecall_time_ns += TCS_STATS_GET(tcs_stats->ecall_time_ns);
+        stats->ocall_count += TCS_STATS_GET(tcs_stats->ocall_count);
+        stats->exception_count += TCS_STATS_GET(tcs_stats->exception_count);
+    }
+    stats->out_of_tcs_count = __atomic_load_n(&m_out_of_tcs_count, __ATOMIC_RELAXED);
+    stats->tcs_wait_count = m_thread_pool->get_wait_count();
+    stats->switchless_fallback_count = __atomic_load_n(&m_switchless_fallback_count, __ATOMIC_RELAXED);
+}
+
+sgx_status_t CEnclave::get_ecall_stats(const uint32_t ecall_index, uint64_t *count, uint64_t *time_ns)
+{
+    if (ecall_index >= SGX_STATS_MAX_ECALLS)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    uint64_t total_count = 0, total_time_ns = 0;
+    std::vector<CTrustThread *> threads = m_thread_pool->get_thread_list();
+    for (unsigned idx = 0; idx < threads.size(); ++idx)
+    {
+        tcs_ecall_stats_t *ecall_stats = __atomic_load_n(&threads[idx]->get_stats()->ecall_index, __ATOMIC_ACQUIRE);
+        if (ecall_stats == NULL)
+            continue;
+        total_count += TCS_STATS_GET(ecall_stats->count[ecall_index]);
+        total_time_ns += TCS_STATS_GET(ecall_stats->time_ns[ecall_index]);
+    }
+    *count = total_count;
+    *time_ns = total_time_ns;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t CEnclave::get_switchless_call_stats(const sgx_uswitchless_call_type_t call_type, const uint32_t func_index, sgx_uswitchless_call_stats_t *stats)
+{
+    sgx_status_t ret = SGX_ERROR_FEATURE_NOT_SUPPORTED;
+
+    se_rdlock(&m_switchless_rwlock);
+    if (m_switchless != NULL && !m_switchless_destroyed && g_sl_funcs.sl_get_call_stats_func_ptr != NULL)
+        ret = g_sl_funcs.sl_get_call_stats_func_ptr(m_switchless, call_type, func_index, stats);
+    se_rdunlock(&m_switchless_rwlock);
+    return ret;
+}
+
+sgx_status_t CEnclave::set_switchless_call_timing(const int enable)
+{
+    sgx_status_t ret = SGX_ERROR_FEATURE_NOT_SUPPORTED;
+
+    se_rdlock(&m_switchless_rwlock);
+    if (m_switchless != NULL && !m_switchless_destroyed && g_sl_funcs.sl_set_call_timing_func_ptr != NULL)
+        ret = g_sl_funcs.sl_set_call_timing_func_ptr(m_switchless, enable);
+    se_rdunlock(&m_switchless_rwlock);
+    return ret;
+}
+
 const debug_enclave_info_t* CEnclave::get_debug_info()
 {
     return &m_enclave_info;
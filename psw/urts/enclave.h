@@ -37,6 +37,7 @@
 #include "tcs.h"
 #include "create_param.h"
 #include "sgx_eid.h"
+#include "sgx_uswitchless.h"
 #include "routine.h"
 #include "loader.h"
 #include "file.h"
@@ -44,6 +45,7 @@
 #include "node.h"
 
 class CLoader;
+class CAsyncOcall;
 
 class CEnclave: private Uncopyable
 {
@@ -57,7 +59,9 @@ public:
     CTrustThreadPool * get_thread_pool() { return m_thread_pool; }
     uint64_t get_size() { return m_size; };
     sgx_status_t ecall(const int proc, const void *ocall_table, void *ms, const bool is_fast = false);
-    int ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_table, void *ms);
+    sgx_status_t ecall_async_submit(const int proc, const void *ocall_table, void *ms, uint32_t *line);
+    sgx_status_t ecall_async_complete(const uint32_t line, const bool wait, bool *done, bool *need_fallback);
+    int ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_table, void *ms, CTrustThread *trust_thread);
     void destroy();
     uint32_t atomic_inc_ref() { return se_atomic_inc(&m_ref); }
     uint32_t atomic_dec_ref() { return se_atomic_dec(&m_ref); }
@@ -83,7 +87,12 @@ public:
     void set_sealed_key(uint8_t *sealed_key);
     sgx_status_t init_uswitchless(const void* config);
     void destroy_uswitchless(void);
+    void destroy_async_ocall(void);
     sgx_target_info_t get_target_info();
+    void get_stats(sgx_enclave_stats_t *stats);
+    sgx_status_t get_ecall_stats(const uint32_t ecall_index, uint64_t *count, uint64_t *time_ns);
+    sgx_status_t get_switchless_call_stats(const sgx_uswitchless_call_type_t call_type, const uint32_t func_index, sgx_uswitchless_call_stats_t *stats);
+    sgx_status_t set_switchless_call_timing(const int enable);
 #ifdef SE_SIM
     void *get_global_data_sim_ptr();
 #endif 
@@ -91,7 +100,11 @@ public:
 
 private:
     CTrustThread * get_tcs(int ecall_cmd);
+    void on_first_ecall(const void *ocall_table);
     sgx_status_t error_trts2urts(unsigned int trts_error);
+    int ocall_async_setup(const sgx_ocall_table_t *ocall_table, void *ms);
+    int ocall_async_flush();
+    int ocall_async_table(const sgx_ocall_table_t *ocall_table, void *ms);
 
     void set_dynamic_tcs_list_size(CLoader &ldr);
 #ifdef SE_SIM    
@@ -116,9 +129,15 @@ private:
     se_handle_t             m_new_thread_event;
     uint8_t                 *m_sealed_key;
     void*                   m_switchless;
+    se_rwlock_t             m_switchless_rwlock;
+    bool                    m_switchless_destroyed;
     bool                    m_first_ecall;
     sgx_target_info_t       m_target_info;
     size_t                  m_dynamic_tcs_list_size;
+    uint64_t                m_out_of_tcs_count;
+    uint64_t                m_switchless_fallback_count;
+    CAsyncOcall             *m_async_ocall;
+    se_mutex_t              m_async_ocall_mutex;
 #ifdef SE_SIM    
     void                    *m_global_data_sim_ptr;
 #endif
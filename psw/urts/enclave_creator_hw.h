@@ -63,6 +63,7 @@ public:
     int mktcs(uint64_t tcs_addr);
     int trim_range(uint64_t fromaddr, uint64_t toaddr);
     int trim_accept(uint64_t addr);
+    int trim_accept_range(uint64_t fromaddr, uint64_t toaddr);
     int remove_range(uint64_t fromaddr, uint64_t numpages);
 private:
     virtual bool open_device();
@@ -33,6 +33,7 @@
 #include "sgx_defs.h"
 #include "enclave.h"
 #include "se_event.h"
+#include <time.h>
 
 #include "se_error_internal.h"
 
@@ -52,6 +53,35 @@ extern "C" int sgx_thread_wait_untrusted_event_ocall(const void *self)
     return SGX_SUCCESS;
 }
 
+/* wait on untrusted event with a relative timeout */
+extern "C" int sgx_thread_wait_untrusted_event_timeout_ocall(const void *self, uint64_t timeout_us, uint64_t *remaining_us)
+{
+    if (self == NULL || remaining_us == NULL)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    *remaining_us = 0;
+    se_handle_t hevent = CEnclavePool::instance()->get_event(self);
+    if (hevent == NULL)
+        return SE_ERROR_MUTEX_GET_EVENT;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ret = se_event_wait_timeout_us(hevent, timeout_us);
+    if (ret == SE_MUTEX_TIMEOUT)
+        return SGX_SUCCESS;
+    if (ret != SE_MUTEX_SUCCESS)
+        return SE_ERROR_MUTEX_WAIT_EVENT;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    //report the time left so a thread woken up for nothing keeps its deadline
+    uint64_t elapsed_us = (uint64_t)(((int64_t)(end.tv_sec - start.tv_sec) * 1000000000
+        + (end.tv_nsec - start.tv_nsec)) / 1000);
+    //a wake up in time always leaves some time, 0 is reserved for timeout
+    *remaining_us = elapsed_us < timeout_us ? timeout_us - elapsed_us : 1;
+
+    return SGX_SUCCESS;
+}
+
 /* set untrusted event */
 extern "C" int sgx_thread_set_untrusted_event_ocall(const void *waiter)
 {
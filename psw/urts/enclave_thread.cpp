@@ -40,21 +40,35 @@
 #include <pthread.h>
 #include <unistd.h>
 #include "get_thread_id.h"
+#include "se_lock.hpp"
+#include <vector>
 
-static void* pthread_create_routine(void* arg)
+/*
+ * Host threads which served an in-enclave pthread are parked here for a
+ * while instead of exiting, so the next pthread_create_ocall() can hand its
+ * TCS to one of them rather than creating a new host thread.
+ */
+#define PTHREAD_MAX_IDLE_HOST_THREADS   16
+#define PTHREAD_IDLE_TIMEOUT_SECONDS    2
+
+typedef struct _pthread_host_thread_t
 {
-    if(NULL == arg)
-        //It's a critial error.
-        abort();
+    se_handle_t     event;          //set when trust_thread is handed over
+    CTrustThread    *trust_thread;  //NULL while the thread is parked
+} pthread_host_thread_t;
 
-    CTrustThread * trust_thread = (CTrustThread *)arg;
-    CEnclave *enclave = ((CTrustThread *)trust_thread)->get_enclave();
+static Mutex g_idle_host_thread_mutex;
+static std::vector<pthread_host_thread_t *> g_idle_host_threads;
+
+static void run_trust_thread(CTrustThread *trust_thread)
+{
+    CEnclave *enclave = trust_thread->get_enclave();
     if(NULL == enclave) {
          //It's a critial error.
          abort();
     }
     enclave->atomic_inc_ref(); 
-    //bind the trust_thread with this new thread's thread_id
+    //bind the trust_thread with this thread's thread_id
     se_thread_id_t thread_id = get_thread_id();
     enclave->get_thread_pool()->bind_pthread(thread_id, trust_thread);
 
@@ -68,7 +82,69 @@ static void* pthread_create_routine(void* arg)
             se_event_wake(hevent);  //Needn't check it's return value
         }
     }
+    //the host thread outlives the enclave thread, give the tcs back right away
+    enclave->get_thread_pool()->unbind_pthread(thread_id);
     CEnclavePool::instance()->unref_enclave(enclave);
+}
+
+//Returns true if another trust_thread was handed over while the thread was parked.
+static bool park_host_thread(pthread_host_thread_t *self)
+{
+    {
+        LockGuard lock(&g_idle_host_thread_mutex);
+        if(g_idle_host_threads.size() >= PTHREAD_MAX_IDLE_HOST_THREADS)
+            return false;
+        g_idle_host_threads.push_back(self);
+    }
+
+    se_event_wait_timeout(self->event, PTHREAD_IDLE_TIMEOUT_SECONDS);
+
+    LockGuard lock(&g_idle_host_thread_mutex);
+    if(self->trust_thread != NULL)
+        return true;
+    //timed out, make sure nobody can pick this thread any more
+    for(std::vector<pthread_host_thread_t *>::iterator it = g_idle_host_threads.begin(); it != g_idle_host_threads.end(); it++)
+    {
+        if(*it == self)
+        {
+            g_idle_host_threads.erase(it);
+            break;
+        }
+    }
+    return false;
+}
+
+static bool unpark_host_thread(CTrustThread *trust_thread)
+{
+    pthread_host_thread_t *host_thread = NULL;
+    {
+        LockGuard lock(&g_idle_host_thread_mutex);
+        if(g_idle_host_threads.empty())
+            return false;
+        host_thread = g_idle_host_threads.back();
+        g_idle_host_threads.pop_back();
+        host_thread->trust_thread = trust_thread;
+    }
+    se_event_wake(host_thread->event);
+    return true;
+}
+
+static void* pthread_create_routine(void* arg)
+{
+    if(NULL == arg)
+        //It's a critial error.
+        abort();
+
+    pthread_host_thread_t self;
+    self.trust_thread = (CTrustThread *)arg;
+    self.event = se_event_init();
+
+    do {
+        run_trust_thread(self.trust_thread);
+        self.trust_thread = NULL;
+    } while(self.event != NULL && park_host_thread(&self));
+
+    se_event_destroy(self.event);
     return NULL;
 }
 
@@ -86,6 +162,10 @@ extern "C" sgx_status_t pthread_create_ocall(unsigned long long self)
     if(NULL == trust_thread)
         return SGX_ERROR_OUT_OF_TCS;
 
+    //reuse a parked host thread if there is one
+    if(unpark_host_thread(trust_thread))
+        return SGX_SUCCESS;
+
     pthread_attr_t attr;
     if(pthread_attr_init(&attr) != 0)
         return SGX_ERROR_UNEXPECTED;
@@ -352,6 +352,19 @@ int EnclaveCreatorHW::trim_accept(uint64_t addr)
     return SGX_SUCCESS;
 }
  
+int EnclaveCreatorHW::trim_accept_range(uint64_t fromaddr, uint64_t toaddr)
+{
+    //the driver removes one page per NOTIFY_ACCEPT, but the enclave only pays one OCALL for the whole range
+    for(uint64_t addr = fromaddr; addr < toaddr; addr += SE_PAGE_SIZE)
+    {
+        int ret = trim_accept(addr);
+        if(ret != SGX_SUCCESS)
+            return ret;
+    }
+
+    return SGX_SUCCESS;
+}
+
 int EnclaveCreatorHW::remove_range(uint64_t fromaddr, uint64_t numpages)
 {
     int ret = -1;
@@ -40,6 +40,9 @@
 #include <signal.h>
 #include <string.h>
 #include <errno.h>
+#ifdef SE_SIM
+#include "sim_transition.h"
+#endif
 
 
 typedef struct _ecall_param_t
@@ -238,6 +241,9 @@ int do_ecall(const int fn, const void *ocall_table, const void *ms, CTrustThread
     tcs_t *tcs = trust_thread->get_tcs();
 
     status = enter_enclave(tcs, fn, ocall_table, ms, trust_thread);
+#ifdef SE_SIM
+    sim_transition_cost();  // EEXIT
+#endif
 
     return status;
 }
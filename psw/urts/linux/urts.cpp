@@ -39,6 +39,7 @@
 #include <limits.h>
 
 #include "urts_com.h"
+#include "urts_trace.h"
 
 static bool inline _check_ex_params_(const uint32_t ex_features, const void* ex_features_p[32])
 {
@@ -149,6 +150,101 @@ extern "C" sgx_status_t sgx_get_target_info(
     return SGX_SUCCESS;
 }
 
+extern "C" sgx_status_t sgx_set_tcs_wait(
+	const sgx_enclave_id_t enclave_id,
+	const uint32_t timeout_ms)
+{
+    CEnclave* enclave = CEnclavePool::instance()->ref_enclave(enclave_id);
+    if (!enclave) {
+        return SGX_ERROR_INVALID_ENCLAVE_ID;
+    }
+    enclave->get_thread_pool()->set_wait_timeout(timeout_ms);
+    CEnclavePool::instance()->unref_enclave(enclave);
+    return SGX_SUCCESS;
+}
+
+extern "C" sgx_status_t sgx_get_enclave_stats(
+	const sgx_enclave_id_t enclave_id,
+	sgx_enclave_stats_t *stats)
+{
+    if (!stats)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    CEnclave* enclave = CEnclavePool::instance()->ref_enclave(enclave_id);
+    if (!enclave) {
+        return SGX_ERROR_INVALID_ENCLAVE_ID;
+    }
+    enclave->get_stats(stats);
+    CEnclavePool::instance()->unref_enclave(enclave);
+    return SGX_SUCCESS;
+}
+
+extern "C" sgx_status_t sgx_get_enclave_ecall_stats(
+	const sgx_enclave_id_t enclave_id,
+	const uint32_t ecall_index,
+	uint64_t *count,
+	uint64_t *time_ns)
+{
+    if (!count || !time_ns)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    CEnclave* enclave = CEnclavePool::instance()->ref_enclave(enclave_id);
+    if (!enclave) {
+        return SGX_ERROR_INVALID_ENCLAVE_ID;
+    }
+    sgx_status_t ret = enclave->get_ecall_stats(ecall_index, count, time_ns);
+    CEnclavePool::instance()->unref_enclave(enclave);
+    return ret;
+}
+
+extern "C" sgx_status_t sgx_get_switchless_call_stats(
+	const sgx_enclave_id_t enclave_id,
+	const sgx_uswitchless_call_type_t call_type,
+	const uint32_t func_index,
+	sgx_uswitchless_call_stats_t *stats)
+{
+    if (!stats)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    CEnclave* enclave = CEnclavePool::instance()->ref_enclave(enclave_id);
+    if (!enclave) {
+        return SGX_ERROR_INVALID_ENCLAVE_ID;
+    }
+    sgx_status_t ret = enclave->get_switchless_call_stats(call_type, func_index, stats);
+    CEnclavePool::instance()->unref_enclave(enclave);
+    return ret;
+}
+
+extern "C" sgx_status_t sgx_enable_switchless_call_timing(
+	const sgx_enclave_id_t enclave_id,
+	const int enable)
+{
+    CEnclave* enclave = CEnclavePool::instance()->ref_enclave(enclave_id);
+    if (!enclave) {
+        return SGX_ERROR_INVALID_ENCLAVE_ID;
+    }
+    sgx_status_t ret = enclave->set_switchless_call_timing(enable);
+    CEnclavePool::instance()->unref_enclave(enclave);
+    return ret;
+}
+
+extern "C" sgx_status_t sgx_enable_ecall_timing(const int enable)
+{
+    __atomic_store_n(&g_ecall_timing_enabled, enable ? 1 : 0, __ATOMIC_RELAXED);
+    return SGX_SUCCESS;
+}
+
+extern "C" sgx_status_t sgx_enable_transition_trace(const int enable)
+{
+    urts_trace_enable(enable != 0);
+    return SGX_SUCCESS;
+}
+
+extern "C" sgx_status_t sgx_dump_transition_trace(const char *filename)
+{
+    return urts_trace_dump(filename);
+}
+
 
 extern "C" sgx_status_t sgx_create_enclave_from_buffer_ex(uint8_t *buffer,
                                                           uint64_t buffer_size,
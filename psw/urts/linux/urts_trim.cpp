@@ -31,6 +31,8 @@
 
 #include "urts_trim.h"
 #include "enclave_creator.h"
+#include "rts.h"
+#include "arch.h"
 
 typedef struct ms_trim_range_ocall_t {
     size_t ms_fromaddr;
@@ -41,6 +43,11 @@ typedef struct ms_trim_accept_ocall_t {
     size_t ms_addr;
 } ms_trim_accept_ocall_t;
 
+typedef struct ms_trim_accept_batch_ocall_t {
+    size_t ms_count;
+    /* followed by ms_count edmm_trim_range_t */
+} ms_trim_accept_batch_ocall_t;
+
 sgx_status_t ocall_trim_range(void* pms)
 {
     int ret = 0;
@@ -66,11 +73,47 @@ sgx_status_t ocall_trim_accept(void* pms)
     {
         return SGX_ERROR_UNEXPECTED;
     }
-
     ret = enclave_creator->trim_accept(ms->ms_addr);
 
     return (sgx_status_t)ret; 
 
 }
 
+sgx_status_t ocall_trim_accept_batch(void* pms)
+{
+    int ret = 0;
+    ms_trim_accept_batch_ocall_t* ms = SGX_CAST(ms_trim_accept_batch_ocall_t*, pms);
+
+    EnclaveCreator *enclave_creator = get_enclave_creator();
+    if(NULL == enclave_creator)
+    {
+        return SGX_ERROR_UNEXPECTED;
+    }
+
+    size_t count = ms->ms_count;
+    if(count == 0 || count > EDMM_TRIM_COMMIT_MAX_RANGES)
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    edmm_trim_range_t* ranges = SGX_CAST(edmm_trim_range_t*, ms + 1);
+    for(size_t i = 0; i < count; i++)
+    {
+        size_t fromaddr = ranges[i].fromaddr;
+        size_t toaddr = ranges[i].toaddr;
+        if((fromaddr & (SE_PAGE_SIZE - 1)) || (toaddr & (SE_PAGE_SIZE - 1)) || fromaddr >= toaddr)
+        {
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        ret = enclave_creator->trim_accept_range(fromaddr, toaddr);
+        if(ret != SGX_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    return (sgx_status_t)ret; 
+
+}
+
 
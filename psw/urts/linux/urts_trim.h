@@ -50,6 +50,8 @@ sgx_status_t SGX_CDECL ocall_trim_range(void* pms);
 
 sgx_status_t SGX_CDECL ocall_trim_accept(void* pms);
 
+sgx_status_t SGX_CDECL ocall_trim_accept_batch(void* pms);
+
 
 #ifdef __cplusplus
 }
@@ -346,11 +346,8 @@ int CLoader::post_init_action_commit(layout_t *layout_start, layout_t *layout_en
             uint64_t start_addr = layout->entry.rva + delta + (uint64_t)get_start_addr();
             uint64_t page_count = (uint64_t)layout->entry.page_count;
 
-            for (uint64_t i = 0; i < page_count; i++)
-            {
-                if (SGX_SUCCESS != (ret = get_enclave_creator()->trim_accept(start_addr + (i << SE_PAGE_SHIFT))))
-                    return ret;
-            }
+            if (SGX_SUCCESS != (ret = get_enclave_creator()->trim_accept_range(start_addr, start_addr + (page_count << SE_PAGE_SHIFT))))
+                return ret;
         }
         else if (IS_GROUP_ID(layout->group.id))
         {
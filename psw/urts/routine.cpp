@@ -35,6 +35,11 @@
 #include "se_error_internal.h"
 #include "xsave.h"
 #include "rts_cmd.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef SE_SIM
+#include "sim_transition.h"
+#endif
 
 static
 sgx_status_t _sgx_ecall(const sgx_enclave_id_t enclave_id, const int proc, const void *ocall_table, void *ms, const bool is_switchless)
@@ -74,11 +79,124 @@ sgx_status_t sgx_ecall_switchless(const sgx_enclave_id_t enclave_id, const int p
     return _sgx_ecall(enclave_id, proc, ocall_table, ms, true);
 }
 
+// A switchless ECall in flight, `sgx_ecall_handle_t' in sgx_edger8r.h. The
+// marshaling structure is copied after it, so the caller only has to keep
+// the buffers the structure points to.
+typedef struct _sgx_ecall_handle_t* sgx_ecall_handle_t;
+
+struct _sgx_ecall_handle_t
+{
+    CEnclave        *enclave;       // referenced until the call completes
+    int             proc;
+    const void      *ocall_table;
+    void            *retval;
+    size_t          retval_size;
+    uint32_t        line;
+    bool            pending;        // queued to the trusted workers
+    sgx_status_t    status;         // result once it is not pending
+    size_t          ms_size;
+};
+
+static void *ecall_handle_ms(sgx_ecall_handle_t handle)
+{
+    return handle->ms_size ? reinterpret_cast<void *>(handle + 1) : NULL;
+}
+
+extern "C"
+sgx_status_t sgx_ecall_switchless_async(const sgx_enclave_id_t enclave_id, const int proc, const void *ocall_table,
+                                        const void *ms, const size_t ms_size, void *retval, const size_t retval_size,
+                                        sgx_ecall_handle_t *handle)
+{
+    if (proc < 0)
+        return SGX_ERROR_INVALID_FUNCTION;
+    if (handle == NULL || (ms == NULL) != (ms_size == 0) || retval_size > ms_size)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    sgx_ecall_handle_t h = reinterpret_cast<sgx_ecall_handle_t>(malloc(sizeof(struct _sgx_ecall_handle_t) + ms_size));
+    if (h == NULL)
+        return SGX_ERROR_OUT_OF_MEMORY;
+    memset(h, 0, sizeof(struct _sgx_ecall_handle_t));
+    h->proc = proc;
+    h->ocall_table = ocall_table;
+    h->retval = retval;
+    h->retval_size = retval_size;
+    h->ms_size = ms_size;
+    if (ms_size)
+        memcpy(ecall_handle_ms(h), ms, ms_size);
+
+    CEnclave* enclave = CEnclavePool::instance()->ref_enclave(enclave_id);
+    if (!enclave)
+    {
+        free(h);
+        return SGX_ERROR_INVALID_ENCLAVE_ID;
+    }
+
+    sgx_status_t ret = enclave->ecall_async_submit(proc, ocall_table, ecall_handle_ms(h), &h->line);
+    if (ret == SGX_SUCCESS)
+    {
+        h->enclave = enclave;
+        h->pending = true;
+    }
+    else
+    {
+        // No trusted worker took it, make it now as an ordinary ECall.
+        h->status = (ret == SGX_ERROR_BUSY) ? enclave->ecall(proc, ocall_table, ecall_handle_ms(h), false) : ret;
+        CEnclavePool::instance()->unref_enclave(enclave);
+    }
+    *handle = h;
+    return SGX_SUCCESS;
+}
+
+static sgx_status_t ecall_complete(sgx_ecall_handle_t handle, const bool wait)
+{
+    if (handle == NULL)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    if (handle->pending)
+    {
+        bool done = true;
+        bool need_fallback = false;
+        CEnclave *enclave = handle->enclave;
+
+        // SGX_ERROR_ENCLAVE_LOST comes back done once the enclave or its switchless handle is destroyed
+        sgx_status_t ret = enclave->ecall_async_complete(handle->line, wait, &done, &need_fallback);
+        if (!done)
+            return SGX_ERROR_BUSY;
+        if (need_fallback)
+            ret = enclave->ecall(handle->proc, handle->ocall_table, ecall_handle_ms(handle), false);
+        handle->status = ret;
+        handle->pending = false;
+        CEnclavePool::instance()->unref_enclave(enclave);
+    }
+
+    sgx_status_t status = handle->status;
+    // The return value is the first member of the marshaling structure.
+    if (status == SGX_SUCCESS && handle->retval)
+        memcpy(handle->retval, ecall_handle_ms(handle), handle->retval_size);
+    free(handle);
+    return status;
+}
+
+extern "C"
+sgx_status_t sgx_ecall_wait(sgx_ecall_handle_t handle)
+{
+    return ecall_complete(handle, true);
+}
+
+extern "C"
+sgx_status_t sgx_ecall_poll(sgx_ecall_handle_t handle)
+{
+    return ecall_complete(handle, false);
+}
+
 extern "C"
 int sgx_ocall(const unsigned int proc, const sgx_ocall_table_t *ocall_table, void *ms, CTrustThread *trust_thread)
 {
     assert(trust_thread != NULL);
+#ifdef SE_SIM
+    sim_transition_cost();  // EEXIT
+#endif
     CEnclave* enclave = trust_thread->get_enclave();
     assert(enclave != NULL);
-    return enclave->ocall(proc, ocall_table, ms);
+    return enclave->ocall(proc, ocall_table, ms, trust_thread);
 }
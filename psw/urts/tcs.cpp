@@ -41,9 +41,75 @@
 #include "rts.h"
 #include "enclave.h"
 #include "get_thread_id.h"
+#include "urts_probes.h"
+#include <pthread.h>
+#include <time.h>
+#include <algorithm>
+#include <new>
 
 int do_ecall(const int fn, const void *ocall_table, const void *ms, CTrustThread *trust_thread);
 
+//A host thread bound to a tcs records the enclave under this key, the destructor
+//gives the tcs back when the thread exits, so garbage_collect() rarely needs to scan /proc.
+static pthread_key_t g_binding_key;
+static pthread_once_t g_binding_key_once = PTHREAD_ONCE_INIT;
+static bool g_binding_key_created = false;
+
+static void release_thread_bindings(void *arg)
+{
+    std::vector<sgx_enclave_id_t> *enclaves = reinterpret_cast<std::vector<sgx_enclave_id_t> *>(arg);
+    se_thread_id_t thread_id = get_thread_id();
+
+    for(std::vector<sgx_enclave_id_t>::iterator it = enclaves->begin(); it != enclaves->end(); it++)
+    {
+        //the enclave may have been destroyed in between
+        CEnclave *enclave = CEnclavePool::instance()->ref_enclave(*it);
+        if(NULL == enclave)
+            continue;
+        enclave->get_thread_pool()->release_exited_thread(thread_id);
+        CEnclavePool::instance()->unref_enclave(enclave);
+    }
+    delete enclaves;
+}
+
+static void create_binding_key()
+{
+    g_binding_key_created = (0 == pthread_key_create(&g_binding_key, release_thread_bindings));
+}
+
+//Give the key back when the library is unloaded, the process only has
+//PTHREAD_KEYS_MAX of them and the destructor would point into unmapped code.
+//The lists of threads which are still running are not freed.
+__attribute__((destructor)) static void delete_binding_key()
+{
+    if(!g_binding_key_created)
+        return;
+    g_binding_key_created = false;
+    pthread_key_delete(g_binding_key);
+}
+
+static void register_thread_binding(sgx_enclave_id_t enclave_id)
+{
+    pthread_once(&g_binding_key_once, create_binding_key);
+    if(!g_binding_key_created)
+        return;
+
+    std::vector<sgx_enclave_id_t> *enclaves = reinterpret_cast<std::vector<sgx_enclave_id_t> *>(pthread_getspecific(g_binding_key));
+    if(NULL == enclaves)
+    {
+        enclaves = new (std::nothrow) std::vector<sgx_enclave_id_t>();
+        if(NULL == enclaves)
+            return;
+        if(0 != pthread_setspecific(g_binding_key, enclaves))
+        {
+            delete enclaves;
+            return;
+        }
+    }
+    if(std::find(enclaves->begin(), enclaves->end(), enclave_id) == enclaves->end())
+        enclaves->push_back(enclave_id);
+}
+
 
 
 CTrustThread::CTrustThread(tcs_t *tcs, CEnclave* enclave)
@@ -51,8 +117,10 @@ CTrustThread::CTrustThread(tcs_t *tcs, CEnclave* enclave)
     , m_enclave(enclave)
     , m_reference(0)
     , m_event(NULL)
+    , m_nested_ns(0)
 {
     memset(&m_tcs_info, 0, sizeof(debug_tcs_info_t));
+    memset(&m_stats, 0, sizeof(tcs_stats_t));
     m_tcs_info.TCS_address = reinterpret_cast<void*>(tcs);
     m_tcs_info.ocall_frame = 0;
     m_tcs_info.thread_id = 0;
@@ -62,6 +130,8 @@ CTrustThread::~CTrustThread()
 {
     se_event_destroy(m_event);
     m_event = NULL;
+    delete m_stats.ecall_index;
+    m_stats.ecall_index = NULL;
 }
 
 se_handle_t CTrustThread::get_event()
@@ -80,6 +150,49 @@ void CTrustThread::push_ocall_frame(ocall_frame_t* frame_point)
     m_tcs_info.thread_id = get_thread_id();
 }
 
+volatile int g_ecall_timing_enabled = 0;
+
+static inline uint64_t get_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//Start timing an ECALL, returns the start time. Both values go back to
+//end_timed_ecall() when the ECALL returns.
+uint64_t CTrustThread::begin_timed_ecall(uint64_t *saved_nested_ns)
+{
+    *saved_nested_ns = m_nested_ns;
+    m_nested_ns = 0;
+    return get_time_ns();
+}
+
+void CTrustThread::end_timed_ecall(const int proc, const uint64_t start_ns, const uint64_t saved_nested_ns)
+{
+    uint64_t elapsed = get_time_ns() - start_ns;
+    uint64_t time_ns = elapsed - m_nested_ns;
+
+    //the outer ECALL doesn't count this one again
+    m_nested_ns = saved_nested_ns + elapsed;
+
+    TCS_STATS_ADD(m_stats.ecall_count, 1);
+    TCS_STATS_ADD(m_stats.ecall_time_ns, time_ns);
+    if(proc < 0 || proc >= SGX_STATS_MAX_ECALLS)
+        return;
+
+    tcs_ecall_stats_t *ecall_index = m_stats.ecall_index;
+    if(ecall_index == NULL)
+    {
+        ecall_index = new (std::nothrow) tcs_ecall_stats_t();
+        if(ecall_index == NULL)
+            return;
+        __atomic_store_n(&m_stats.ecall_index, ecall_index, __ATOMIC_RELEASE);
+    }
+    TCS_STATS_ADD(ecall_index->count[proc], 1);
+    TCS_STATS_ADD(ecall_index->time_ns[proc], time_ns);
+}
+
 void CTrustThread::pop_ocall_frame()
 {
     ocall_frame_t* last_ocall_frame = reinterpret_cast<ocall_frame_t*>(m_tcs_info.ocall_frame);
@@ -96,6 +209,9 @@ CTrustThreadPool::CTrustThreadPool(uint32_t tcs_min_pool)
     m_utility_thread = NULL;
     m_tcs_min_pool = tcs_min_pool;
     m_need_to_wait_for_new_thread = false;
+    m_waiter_count = 0;
+    m_wait_count = 0;
+    m_wait_timeout_ms = 0;
 }
 
 CTrustThreadPool::~CTrustThreadPool()
@@ -170,6 +286,9 @@ int CTrustThreadPool::bind_thread(const se_thread_id_t thread_id,  CTrustThread
             return FALSE;
         }
     }
+    //bindings are always made by the thread itself
+    if(thread_id == get_thread_id())
+        register_thread_binding(trust_thread->get_enclave()->get_enclave_id());
     return TRUE;
 }
 
@@ -180,6 +299,24 @@ int CTrustThreadPool::bind_pthread(const se_thread_id_t thread_id,  CTrustThread
     return bind_thread(thread_id, trust_thread);
 }
 
+void CTrustThreadPool::unbind_pthread(const se_thread_id_t thread_id)
+{
+    //This is used by host threads which served sgx pthread_create() and are reused
+    LockGuard lock(&m_thread_mutex);
+    unbind_thread(thread_id);
+}
+
+void CTrustThreadPool::release_exited_thread(const se_thread_id_t thread_id)
+{
+    LockGuard lock(&m_thread_mutex);
+    CTrustThread *trust_thread = get_bound_thread(thread_id);
+    //a tcs which is still referenced is left to garbage_collect(), see the comment there
+    if(NULL != trust_thread && 0 == trust_thread->get_reference() && m_utility_thread != trust_thread)
+    {
+        unbind_thread(thread_id);
+    }
+}
+
 void CTrustThreadPool::unbind_thread(const se_thread_id_t thread_id)
 {
     CTrustThread *trust_thread = nullptr;
@@ -381,7 +518,113 @@ CTrustThread * CTrustThreadPool::_acquire_thread()
     return trust_thread;
 }
 
+bool CTrustThreadPool::has_bound_thread()
+{
+    LockGuard lock(&m_thread_mutex);
+    CTrustThread *trust_thread = get_bound_thread(get_thread_id());
+    return (NULL != trust_thread && m_utility_thread != trust_thread);
+}
+
 CTrustThread * CTrustThreadPool::acquire_thread(int ecall_cmd)
+{
+    uint32_t timeout_ms = m_wait_timeout_ms;
+    //When waiting is enabled, don't overtake the ECALLs already waiting for a
+    //free tcs, unless this thread holds its own tcs and won't take any from them.
+    if(0 == timeout_ms || 0 == m_waiter_count || has_bound_thread())
+    {
+        CTrustThread *trust_thread = try_acquire_thread(ecall_cmd);
+        if(NULL != trust_thread || 0 == timeout_ms)
+        {
+            URTS_PROBE3(tcs_acquire, ecall_cmd, trust_thread ? trust_thread->get_tcs() : NULL, 0);
+            return trust_thread;
+        }
+    }
+    CTrustThread *trust_thread = wait_for_thread(ecall_cmd, timeout_ms);
+    URTS_PROBE3(tcs_acquire, ecall_cmd, trust_thread ? trust_thread->get_tcs() : NULL, 1);
+    return trust_thread;
+}
+
+static uint64_t get_monotonic_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+//A waiter retries at least this often, a tcs may come back without any wake up,
+//e.g. found by the garbage_collect() scan after its thread exited.
+#define TCS_WAIT_SLICE_US   100000
+
+CTrustThread * CTrustThreadPool::wait_for_thread(int ecall_cmd, uint32_t timeout_ms)
+{
+    se_handle_t event = se_event_init();
+    if(NULL == event)
+        return NULL;
+
+    {
+        LockGuard lock(&m_waiter_mutex);
+        m_waiters.push_back(event);
+        m_waiter_count = m_waiters.size();
+        TCS_STATS_ADD(m_wait_count, 1);
+    }
+
+    bool infinite = (SGX_TCS_WAIT_INFINITE == timeout_ms);
+    uint64_t deadline = get_monotonic_us() + (uint64_t)timeout_ms * 1000;
+    CTrustThread *trust_thread = NULL;
+    while(true)
+    {
+        bool is_first = false;
+        {
+            LockGuard lock(&m_waiter_mutex);
+            is_first = (m_waiters.front() == event);
+        }
+        //only the head of the queue takes a tcs, which keeps the order fair
+        if(is_first && NULL != (trust_thread = try_acquire_thread(ecall_cmd)))
+            break;
+
+        uint64_t wait_us = TCS_WAIT_SLICE_US;
+        if(!infinite)
+        {
+            uint64_t now = get_monotonic_us();
+            if(now >= deadline)
+                break;
+            if(deadline - now < wait_us)
+                wait_us = deadline - now;
+        }
+        se_event_wait_timeout_us(event, wait_us);
+    }
+
+    {
+        LockGuard lock(&m_waiter_mutex);
+        bool was_first = (m_waiters.front() == event);
+        for(std::deque<se_handle_t>::iterator it = m_waiters.begin(); it != m_waiters.end(); it++)
+        {
+            if(*it == event)
+            {
+                m_waiters.erase(it);
+                break;
+            }
+        }
+        m_waiter_count = m_waiters.size();
+        //more tcs may be free, let the next waiter check
+        if(was_first && !m_waiters.empty())
+            se_event_wake(m_waiters.front());
+    }
+    se_event_destroy(event);
+    return trust_thread;
+}
+
+void CTrustThreadPool::wake_first_waiter()
+{
+    if(0 == m_waiter_count)
+        return;
+
+    LockGuard lock(&m_waiter_mutex);
+    if(!m_waiters.empty())
+        se_event_wake(m_waiters.front());
+}
+
+CTrustThread * CTrustThreadPool::try_acquire_thread(int ecall_cmd)
 {
     LockGuard lock(&m_thread_mutex);
     CTrustThread *trust_thread = NULL;
@@ -531,8 +774,11 @@ sgx_status_t CTrustThreadPool::new_thread()
 
 void CTrustThreadPool::add_to_free_thread_vector(CTrustThread* it)
 {
-    LockGuard lock(&m_free_thread_mutex);
-    m_free_thread_vector.push_back(it);
+    {
+        LockGuard lock(&m_free_thread_mutex);
+        m_free_thread_vector.push_back(it);
+    }
+    wake_first_waiter();
 }
 
 sgx_status_t CTrustThreadPool::fill_tcs_mini_pool()
@@ -574,6 +820,8 @@ int CThreadPoolBindMode::garbage_collect()
     int nr_free = 0;
 
     //if free list is NULL, recycle tcs.
+    //Exited threads normally gave their tcs back in release_thread_bindings(),
+    //this scan is the fallback for the ones which didn't run the key destructor.
     //get thread id set of current process
     std::vector<se_thread_id_t> thread_vector;
     get_thread_set(thread_vector);
@@ -627,6 +875,14 @@ int CThreadPoolBindMode::garbage_collect()
     return nr_free;
 }
 
+//In unbind mode garbage_collect() reclaims any tcs which isn't referenced,
+//so a waiter may get this one.
+void CThreadPoolUnBindMode::release_thread(CTrustThread * const trust_thread)
+{
+    if(0 == trust_thread->get_reference())
+        wake_first_waiter();
+}
+
 int CThreadPoolUnBindMode::garbage_collect()
 {
     int nr_free = 0;
@@ -36,15 +36,42 @@
 #include "se_wrapper.h"
 #include "util.h"
 #include "sgx_error.h"
+#include "sgx_urts.h"
 #include "se_debugger_lib.h"
 #include "se_lock.hpp"
 #include <vector>
+#include <deque>
 #include "node.h"
 
 typedef int (*bridge_fn_t)(const void*);
 
 class CEnclave;
 
+//Per ECALL index counters, only allocated once an ECALL is timed on the tcs.
+typedef struct _tcs_ecall_stats_t
+{
+    uint64_t count[SGX_STATS_MAX_ECALLS];
+    uint64_t time_ns[SGX_STATS_MAX_ECALLS];
+} tcs_ecall_stats_t;
+
+//Only the thread running on the tcs updates the counters, so they need no
+//atomic read-modify-write. Readers sum them up over all the tcs.
+typedef struct _tcs_stats_t
+{
+    uint64_t ecall_count;
+    uint64_t ecall_time_ns;
+    uint64_t ocall_count;
+    uint64_t exception_count;
+    tcs_ecall_stats_t *ecall_index;     //published with release, read with acquire
+} tcs_stats_t;
+
+//set by sgx_enable_ecall_timing()
+extern volatile int g_ecall_timing_enabled;
+
+#define TCS_STATS_ADD(field, n) \
+    __atomic_store_n(&(field), __atomic_load_n(&(field), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#define TCS_STATS_GET(field)    __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
 class CTrustThread: private Uncopyable
 {
 public:
@@ -60,12 +87,20 @@ public:
     debug_tcs_info_t* get_debug_info(){return &m_tcs_info;}
     void push_ocall_frame(ocall_frame_t* frame_point);
     void pop_ocall_frame();
+    void count_ecall() { TCS_STATS_ADD(m_stats.ecall_count, 1); }
+    uint64_t begin_timed_ecall(uint64_t *saved_nested_ns);
+    void end_timed_ecall(const int proc, const uint64_t start_ns, const uint64_t saved_nested_ns);
+    void count_ocall() { TCS_STATS_ADD(m_stats.ocall_count, 1); }
+    void count_exception() { TCS_STATS_ADD(m_stats.exception_count, 1); }
+    tcs_stats_t *get_stats() { return &m_stats; }
 private:
     tcs_t               *m_tcs;
     CEnclave            *m_enclave;
     int                 m_reference;  //it will increase by 1 before ecall, and decrease after ecall.
     se_handle_t         m_event;
     debug_tcs_info_t    m_tcs_info;
+    tcs_stats_t         m_stats;
+    uint64_t            m_nested_ns;  //time of the timed ECALLs nested in the current one
 };
 
 class CTrustThreadPool: private Uncopyable
@@ -85,11 +120,17 @@ public:
     bool need_to_new_thread();
     bool is_dynamic_thread_exist();
     int bind_pthread(const se_thread_id_t thread_id,  CTrustThread * const trust_thread);
+    void unbind_pthread(const se_thread_id_t thread_id);
+    void release_exited_thread(const se_thread_id_t thread_id);
     void add_to_free_thread_vector(CTrustThread* it);
+    virtual void release_thread(CTrustThread * const trust_thread) { UNUSED(trust_thread); }
+    void set_wait_timeout(uint32_t timeout_ms) { m_wait_timeout_ms = timeout_ms; }
+    uint64_t get_wait_count() { return TCS_STATS_GET(m_wait_count); }
 protected:
     virtual int garbage_collect() = 0;
     inline int find_thread(std::vector<se_thread_id_t> &thread_vector, se_thread_id_t thread_id);
     inline CTrustThread * get_free_thread();
+    void wake_first_waiter();
     int bind_thread(const se_thread_id_t thread_id, CTrustThread * const trust_thread);
     void unbind_thread(const se_thread_id_t thread_id);
     CTrustThread * get_bound_thread(const se_thread_id_t thread_id);
@@ -101,9 +142,17 @@ protected:
                                                             //Thread can operate the list when it get the mutex
     Mutex                                   m_free_thread_mutex; //protect free threads.
     Cond                                    m_need_to_wait_for_new_thread_cond;
+    std::deque<se_handle_t>                 m_waiters;      //ECALLs waiting for a tcs, in arrival order
+    volatile size_t                         m_waiter_count;
+    uint64_t                                m_wait_count;   //ECALLs which have waited, updated under m_waiter_mutex
+    Mutex                                   m_waiter_mutex; //protect m_waiters, never held while taking other locks
 private:
     CTrustThread * _acquire_free_thread();
     CTrustThread * _acquire_thread();
+    CTrustThread * try_acquire_thread(int ecall_cmd);
+    CTrustThread * wait_for_thread(int ecall_cmd, uint32_t timeout_ms);
+    bool has_bound_thread();
+    volatile uint32_t m_wait_timeout_ms;
     CTrustThread *m_utility_thread;
     uint64_t     m_tcs_min_pool;
     bool         m_need_to_wait_for_new_thread;
@@ -121,6 +170,7 @@ class CThreadPoolUnBindMode : public CTrustThreadPool
 {
 public:
     CThreadPoolUnBindMode(uint32_t tcs_min_pool):CTrustThreadPool(tcs_min_pool){}
+    virtual void release_thread(CTrustThread * const trust_thread);
 private:
     virtual int garbage_collect();
 };
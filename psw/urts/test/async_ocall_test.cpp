@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Runs the [async] OCALL worker of the uRTS against a ring filled the way
+ * the tRTS does it, and checks that:
+ *  - queued OCALLs run once each, in the order they were queued, with the
+ *    OCALL table registered for them, skipping the cancelled slots;
+ *  - stop() runs what is still queued before the worker exits, and OCALLs
+ *    queued after that are run when the ring is destroyed, none is dropped;
+ *  - a flush waits for a slot that is being marshaled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "async_ocall.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define MAX_EVENTS  4096
+
+static uint32_t g_events[MAX_EVENTS];
+static volatile uint32_t g_event_count = 0;
+static unsigned int g_ocall_delay_us = 0;
+
+typedef struct _ms_seq_t
+{
+    uint32_t seq;
+} ms_seq_t;
+
+/* the untrusted bridges, only the worker thread calls them */
+static int ocall_seq(const void *pms)
+{
+    const ms_seq_t *ms = reinterpret_cast<const ms_seq_t *>(pms);
+    CHECK(g_event_count < MAX_EVENTS);
+    if (g_ocall_delay_us)
+        usleep(g_ocall_delay_us);
+    g_events[g_event_count] = ms->seq;
+    __atomic_store_n(&g_event_count, g_event_count + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int ocall_seq_table2(const void *pms)
+{
+    const ms_seq_t *ms = reinterpret_cast<const ms_seq_t *>(pms);
+    ms_seq_t tagged = { ms->seq | 0x80000000 };
+    return ocall_seq(&tagged);
+}
+
+static struct { uint32_t count; void *ocall[1]; } g_table1 = { 1, { reinterpret_cast<void *>(ocall_seq) } };
+static struct { uint32_t count; void *ocall[1]; } g_table2 = { 1, { reinterpret_cast<void *>(ocall_seq_table2) } };
+
+/* plays the tRTS side of the ring */
+class ring_writer_t
+{
+public:
+    explicit ring_writer_t(async_ocall_ring_t *ring) : m_ring(ring), m_tail(0) {}
+
+    async_ocall_slot_t *reserve()
+    {
+        async_ocall_slot_t *slot = &m_ring->slots[m_tail % ASYNC_OCALL_RING_SLOTS];
+        if (slot->state != ASYNC_OCALL_SLOT_FREE)
+            return NULL;
+        slot->state = ASYNC_OCALL_SLOT_RESERVED;
+        m_tail++;
+        return slot;
+    }
+
+    static void ready(async_ocall_slot_t *slot, uint32_t seq, uint32_t table)
+    {
+        slot->index = 0;
+        slot->table = table;
+        reinterpret_cast<ms_seq_t *>(slot->data)->seq = seq;
+        __sync_synchronize();
+        slot->state = ASYNC_OCALL_SLOT_READY;
+    }
+
+    void queue(uint32_t seq, uint32_t table = 0)
+    {
+        async_ocall_slot_t *slot = NULL;
+        while ((slot = reserve()) == NULL)
+            sched_yield();
+        ready(slot, seq, table);
+    }
+
+    void cancel()
+    {
+        async_ocall_slot_t *slot = reserve();
+        CHECK(slot != NULL);
+        slot->state = ASYNC_OCALL_SLOT_CANCELLED;
+    }
+
+    uint64_t tail() const { return m_tail; }
+
+private:
+    async_ocall_ring_t *m_ring;
+    uint64_t m_tail;
+};
+
+static void wait_events(uint32_t count)
+{
+    for (int i = 0; __atomic_load_n(&g_event_count, __ATOMIC_ACQUIRE) < count; i++) {
+        CHECK(i < 10000);
+        usleep(1000);
+    }
+}
+
+static void check_events(uint32_t first, uint32_t count)
+{
+    CHECK(g_event_count == count);
+    for (uint32_t i = 0; i < count; i++)
+        CHECK(g_events[i] == first + i);
+    g_event_count = 0;
+}
+
+typedef struct _marshal_arg_t
+{
+    async_ocall_slot_t *slot;
+    uint32_t seq;
+} marshal_arg_t;
+
+static void *marshal_later(void *p)
+{
+    marshal_arg_t *arg = reinterpret_cast<marshal_arg_t *>(p);
+    usleep(2000);
+    ring_writer_t::ready(arg->slot, arg->seq, 0);
+    return NULL;
+}
+
+int main()
+{
+    const sgx_ocall_table_t *table1 = reinterpret_cast<const sgx_ocall_table_t *>(&g_table1);
+    const sgx_ocall_table_t *table2 = reinterpret_cast<const sgx_ocall_table_t *>(&g_table2);
+    uint32_t id = 0;
+
+    {
+        CAsyncOcall async_ocall(table1);
+        CHECK(async_ocall.start() == SGX_SUCCESS);
+        ring_writer_t writer(async_ocall.get_ring());
+
+        /* the table of the ring is 0, another ECALL's table gets its own id */
+        CHECK(async_ocall.register_table(table1, &id) == SGX_SUCCESS && id == 0);
+        CHECK(async_ocall.register_table(table2, &id) == SGX_SUCCESS && id == 1);
+
+        /* several times around the ring, in order, cancelled slots skipped */
+        for (uint32_t seq = 0; seq < 1000; seq++) {
+            if (seq % 100 == 50)
+                writer.cancel();
+            writer.queue(seq);
+        }
+        wait_events(1000);
+        check_events(0, 1000);
+        CHECK(async_ocall.get_ring()->head == writer.tail());
+
+        /* each slot runs with the table it was queued with */
+        writer.queue(1, 1);
+        writer.queue(2, 0);
+        wait_events(2);
+        CHECK(g_events[0] == (1 | 0x80000000) && g_events[1] == 2);
+        g_event_count = 0;
+
+        /* a flush waits for the slot being marshaled at the head */
+        marshal_arg_t arg = { writer.reserve(), 7 };
+        CHECK(arg.slot != NULL);
+        pthread_t thread;
+        CHECK(pthread_create(&thread, NULL, marshal_later, &arg) == 0);
+        async_ocall.flush();
+        CHECK(g_event_count == 1 && g_events[0] == 7);
+        g_event_count = 0;
+        CHECK(pthread_join(thread, NULL) == 0);
+
+        /* a full ring of slow OCALLs, stopped right away */
+        g_ocall_delay_us = 200;
+        for (uint32_t seq = 0; seq < ASYNC_OCALL_RING_SLOTS; seq++)
+            writer.queue(seq);
+        async_ocall.stop();
+        check_events(0, ASYNC_OCALL_RING_SLOTS);
+        g_ocall_delay_us = 0;
+
+        /* queued while the enclave is being destroyed, after the worker
+         * stopped, run when the ring goes away */
+        for (uint32_t seq = 100; seq < 110; seq++)
+            writer.queue(seq);
+        CHECK(g_event_count == 0);
+    }
+    check_events(100, 10);
+
+    printf("async_ocall_test: ordered, stop and destroy run every queued OCALL\n");
+    return 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Runs trim_EPC_pages() of the tRTS against the EDMM OCALL handlers of the
+ * uRTS, with the EnclaveCreator mocked, and checks that:
+ *  - the trim commit of a range is one EDMM_TRIM_COMMIT_BATCH carrying the
+ *    whole range, done before trim_EPC_pages() returns;
+ *  - an error of the creator is returned by trim_EPC_pages();
+ *  - a uRTS without EDMM_TRIM_COMMIT_BATCH gets one EDMM_TRIM_COMMIT per
+ *    page instead;
+ *  - the batch OCALL marshals several ranges in order, and the uRTS
+ *    rejects malformed ones without touching the creator.
+ * The tRTS pieces below trts_add_trim.cpp and trts_trim.cpp are mocked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <utility>
+#include "enclave_creator.h"
+#include "global_data.h"
+#include "rts.h"
+#include "urts_trim.h"
+#include "trts_trim.h"
+#include "trts_inst.h"
+#include "trts_util.h"
+#include "trts_internal.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define HEAP_BASE       ((size_t)0x7f0000000000ULL)  /* never dereferenced */
+#define HEAP_MIN_PAGES  16
+#define HEAP_PAGES      1040
+
+typedef std::vector<std::pair<uint64_t, uint64_t> > ranges_t;
+
+class MockCreator : public EnclaveCreator
+{
+public:
+    MockCreator() : fail_at(0), accept_calls(0) {}
+    int create_enclave(secs_t *, sgx_enclave_id_t *, void **, bool) { return SGX_ERROR_UNEXPECTED; }
+    int add_enclave_page(sgx_enclave_id_t, void *, uint64_t, const sec_info_t &, uint32_t) { return SGX_ERROR_UNEXPECTED; }
+    int init_enclave(sgx_enclave_id_t, enclave_css_t *, SGXLaunchToken *, le_prd_css_file_t *) { return SGX_ERROR_UNEXPECTED; }
+    int destroy_enclave(sgx_enclave_id_t, uint64_t) { return SGX_ERROR_UNEXPECTED; }
+    int initialize(sgx_enclave_id_t) { return SGX_ERROR_UNEXPECTED; }
+    bool use_se_hw() const { return true; }
+    bool is_EDMM_supported(sgx_enclave_id_t) { return true; }
+    bool is_driver_compatible() { return true; }
+    int get_misc_attr(sgx_misc_attribute_t *, metadata_t *, SGXLaunchToken * const, uint32_t) { return SGX_ERROR_UNEXPECTED; }
+    bool get_plat_cap(sgx_misc_attribute_t *) { return false; }
+    int emodpr(uint64_t, uint64_t, uint64_t) { return SGX_ERROR_UNEXPECTED; }
+    int mktcs(uint64_t) { return SGX_ERROR_UNEXPECTED; }
+    int remove_range(uint64_t, uint64_t) { return SGX_ERROR_UNEXPECTED; }
+
+    int trim_range(uint64_t fromaddr, uint64_t toaddr)
+    {
+        trims.push_back(std::make_pair(fromaddr, toaddr));
+        return SGX_SUCCESS;
+    }
+    int trim_accept(uint64_t addr)
+    {
+        pages.push_back(addr);
+        return SGX_SUCCESS;
+    }
+    int trim_accept_range(uint64_t fromaddr, uint64_t toaddr)
+    {
+        if (++accept_calls == fail_at)
+            return SGX_ERROR_UNEXPECTED;
+        commits.push_back(std::make_pair(fromaddr, toaddr));
+        return SGX_SUCCESS;
+    }
+
+    void reset()
+    {
+        trims.clear();
+        commits.clear();
+        pages.clear();
+        fail_at = 0;
+        accept_calls = 0;
+    }
+
+    ranges_t trims;
+    ranges_t commits;
+    std::vector<uint64_t> pages;
+    int fail_at;            /* the trim_accept_range() call to fail, from 1 */
+    int accept_calls;
+};
+
+static MockCreator g_creator;
+
+EnclaveCreator *get_enclave_creator(void)
+{
+    return &g_creator;
+}
+
+/* Mocked tRTS */
+global_data_t const volatile g_global_data = {};
+int EDMM_supported = 1;
+void *rsrv_mem_base = NULL;
+size_t rsrv_mem_size = 0;
+size_t rsrv_mem_min_size = 0;
+
+static uint8_t g_ustack[4096] __attribute__((aligned(64)));
+static size_t g_ustack_top = 0;
+static size_t g_eaccepts = 0;
+static size_t g_batch_ocalls = 0;
+static bool g_old_urts = false;
+
+extern "C" void *get_enclave_base() { return reinterpret_cast<void *>(HEAP_BASE - 0x100000); }
+extern "C" void *get_heap_base(void) { return reinterpret_cast<void *>(HEAP_BASE); }
+extern "C" size_t get_heap_size(void) { return (size_t)HEAP_PAGES << SE_PAGE_SHIFT; }
+extern "C" size_t get_heap_min_size(void) { return (size_t)HEAP_MIN_PAGES << SE_PAGE_SHIFT; }
+
+extern "C" int do_eaccept(const sec_info_t *, size_t)
+{
+    g_eaccepts++;
+    return 0;
+}
+
+extern "C" void *sgx_ocalloc(size_t size)
+{
+    if (size > sizeof(g_ustack) - g_ustack_top)
+        return NULL;
+    g_ustack_top += size;
+    return g_ustack + g_ustack_top - size;
+}
+
+extern "C" void sgx_ocfree(void)
+{
+    g_ustack_top = 0;
+}
+
+/* dispatches the EDMM builtin OCALLs the way CEnclave::ocall() does */
+extern "C" sgx_status_t sgx_ocall(const unsigned int index, void *ms)
+{
+    switch ((int)index) {
+    case EDMM_TRIM:
+        return ocall_trim_range(ms);
+    case EDMM_TRIM_COMMIT:
+        return ocall_trim_accept(ms);
+    case EDMM_TRIM_COMMIT_BATCH:
+        if (g_old_urts)
+            return SGX_ERROR_INVALID_FUNCTION;
+        g_batch_ocalls++;
+        return ocall_trim_accept_batch(ms);
+    default:
+        CHECK(!"unexpected OCALL");
+        return SGX_ERROR_UNEXPECTED;
+    }
+}
+
+static void reset()
+{
+    g_creator.reset();
+    g_eaccepts = 0;
+    g_batch_ocalls = 0;
+    g_old_urts = false;
+}
+
+static void *heap_page(size_t page)
+{
+    return reinterpret_cast<void *>(HEAP_BASE + ((HEAP_MIN_PAGES + page) << SE_PAGE_SHIFT));
+}
+
+int main()
+{
+    const uint64_t from = reinterpret_cast<uint64_t>(heap_page(8));
+    const uint64_t to = from + (512 << SE_PAGE_SHIFT);
+
+    /* 512 pages: one trim, one EACCEPT per page, one commit OCALL */
+    reset();
+    CHECK(trim_EPC_pages(heap_page(8), 512) == 0);
+    CHECK(g_creator.trims.size() == 1 && g_creator.trims[0] == std::make_pair(from, to));
+    CHECK(g_eaccepts == 512);
+    CHECK(g_batch_ocalls == 1);
+    CHECK(g_creator.commits.size() == 1 && g_creator.commits[0] == std::make_pair(from, to));
+    CHECK(g_creator.pages.empty());
+    CHECK(g_ustack_top == 0);
+
+    /* the commit fails: reported, not left for later */
+    reset();
+    g_creator.fail_at = 1;
+    CHECK(trim_EPC_pages(heap_page(8), 512) == SGX_ERROR_UNEXPECTED);
+    CHECK(g_batch_ocalls == 1 && g_creator.commits.empty());
+    reset();
+    CHECK(trim_EPC_pages(heap_page(0), 1) == 0);
+    CHECK(g_creator.commits.size() == 1);
+    CHECK(g_creator.commits[0].first == reinterpret_cast<uint64_t>(heap_page(0)));
+
+    /* an older uRTS, page by page */
+    reset();
+    g_old_urts = true;
+    CHECK(trim_EPC_pages(heap_page(8), 4) == 0);
+    CHECK(g_creator.commits.empty() && g_creator.pages.size() == 4);
+    for (size_t i = 0; i < 4; i++)
+        CHECK(g_creator.pages[i] == from + (i << SE_PAGE_SHIFT));
+
+    /* outside the dynamic heap, nothing happens */
+    reset();
+    CHECK(trim_EPC_pages(reinterpret_cast<void *>(HEAP_BASE), 1) == -1);
+    CHECK(trim_EPC_pages(heap_page(HEAP_PAGES - HEAP_MIN_PAGES - 1), 2) == -1);
+    CHECK(g_creator.trims.empty() && g_batch_ocalls == 0);
+
+    /* several ranges in one OCALL, in order, stopping at the failing one */
+    edmm_trim_range_t ranges[3] = {
+        { from, from + 0x1000 },
+        { from + 0x3000, from + 0x5000 },
+        { from + 0x8000, from + 0x9000 },
+    };
+    reset();
+    CHECK(trim_range_commit_batch_ocall(ranges, 3) == SGX_SUCCESS);
+    CHECK(g_batch_ocalls == 1 && g_creator.commits.size() == 3);
+    for (size_t i = 0; i < 3; i++)
+        CHECK(g_creator.commits[i] == std::make_pair((uint64_t)ranges[i].fromaddr, (uint64_t)ranges[i].toaddr));
+    reset();
+    g_creator.fail_at = 2;
+    CHECK(trim_range_commit_batch_ocall(ranges, 3) == SGX_ERROR_UNEXPECTED);
+    CHECK(g_creator.commits.size() == 1 && g_creator.accept_calls == 2);
+
+    /* bounds checked before anything is marshaled */
+    reset();
+    CHECK(trim_range_commit_batch_ocall(ranges, 0) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(trim_range_commit_batch_ocall(NULL, 1) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(trim_range_commit_batch_ocall(ranges, EDMM_TRIM_COMMIT_MAX_RANGES + 1) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(g_batch_ocalls == 0);
+
+    /* the uRTS rejects unaligned and empty ranges */
+    edmm_trim_range_t bad[3] = {
+        { from + 1, from + 0x1000 },
+        { from, from + 0x1001 },
+        { from + 0x1000, from + 0x1000 },
+    };
+    for (size_t i = 0; i < 3; i++) {
+        reset();
+        CHECK(trim_range_commit_batch_ocall(&bad[i], 1) == SGX_ERROR_INVALID_PARAMETER);
+        CHECK(g_creator.accept_calls == 0);
+    }
+
+    printf("trim_commit_test: 512 trimmed pages committed by 1 OCALL\n");
+    return 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Runs itself with SGX_URTS_TRACE set so that the load-time constructor of
+ * urts_trace.cpp enables tracing, records ECALL/OCALL transitions from two
+ * threads, writes the trace with SIGUSR2 and parses the JSON back. A second
+ * run starts with SIGUSR2 ignored, which the trace must leave alone and only
+ * write the file at exit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "urts_trace.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define TRACE_FILE_SIGNAL   "urts_trace_signal.json"
+#define TRACE_FILE_EXIT     "urts_trace_exit.json"
+#define SMALL_CALLS         3
+#define LARGE_CALLS         5000    /* more events than a ring holds */
+#define RING_EVENTS         4096
+
+typedef struct _event_t
+{
+    std::string name;
+    std::string cat;
+    std::string ph;
+    double ts;
+    long pid;
+    long tid;
+} event_t;
+
+/* A strict parser for the subset of JSON the trace is written in */
+class json_parser_t
+{
+public:
+    explicit json_parser_t(const std::string &text) : m_s(text), m_pos(0) {}
+
+    bool parse(std::vector<event_t> &events)
+    {
+        skip_ws();
+        if (!expect('{'))
+            return false;
+        bool seen_events = false;
+        do
+        {
+            std::string key;
+            if (!parse_string(key) || !expect(':'))
+                return false;
+            if (key == "traceEvents")
+            {
+                if (!parse_events(events))
+                    return false;
+                seen_events = true;
+            }
+            else
+            {
+                std::string value;
+                if (!parse_string(value))
+                    return false;
+            }
+        } while (accept(','));
+        if (!expect('}'))
+            return false;
+        skip_ws();
+        return seen_events && m_pos == m_s.size();
+    }
+
+private:
+    const std::string &m_s;
+    size_t m_pos;
+
+    void skip_ws()
+    {
+        while (m_pos < m_s.size() && strchr(" \t\r\n", m_s[m_pos]) != NULL)
+            m_pos++;
+    }
+    bool accept(char c)
+    {
+        skip_ws();
+        if (m_pos < m_s.size() && m_s[m_pos] == c)
+        {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+    bool expect(char c) { return accept(c); }
+
+    bool parse_string(std::string &out)
+    {
+        if (!accept('"'))
+            return false;
+        out.clear();
+        while (m_pos < m_s.size() && m_s[m_pos] != '"')
+        {
+            if (m_s[m_pos] == '\\' || (unsigned char)m_s[m_pos] < 0x20)
+                return false;
+            out += m_s[m_pos++];
+        }
+        return accept('"');
+    }
+
+    bool parse_number(double &out)
+    {
+        skip_ws();
+        size_t start = m_pos;
+        if (m_pos < m_s.size() && m_s[m_pos] == '-')
+            m_pos++;
+        while (m_pos < m_s.size() && (isdigit((unsigned char)m_s[m_pos]) || m_s[m_pos] == '.'))
+            m_pos++;
+        if (m_pos == start)
+            return false;
+        out = strtod(m_s.substr(start, m_pos - start).c_str(), NULL);
+        return true;
+    }
+
+    bool parse_events(std::vector<event_t> &events)
+    {
+        if (!expect('['))
+            return false;
+        if (accept(']'))
+            return true;
+        do
+        {
+            event_t event;
+            double pid = 0, tid = 0;
+            int fields = 0;
+            if (!expect('{'))
+                return false;
+            do
+            {
+                std::string key;
+                if (!parse_string(key) || !expect(':'))
+                    return false;
+                bool ok;
+                if (key == "name")
+                    ok = parse_string(event.name);
+                else if (key == "cat")
+                    ok = parse_string(event.cat);
+                else if (key == "ph")
+                    ok = parse_string(event.ph);
+                else if (key == "ts")
+                    ok = parse_number(event.ts);
+                else if (key == "pid")
+                    ok = parse_number(pid);
+                else if (key == "tid")
+                    ok = parse_number(tid);
+                else
+                    return false;
+                if (!ok)
+                    return false;
+                fields++;
+            } while (accept(','));
+            if (!expect('}') || fields != 6)
+                return false;
+            event.pid = (long)pid;
+            event.tid = (long)tid;
+            events.push_back(event);
+        } while (accept(','));
+        return expect(']');
+    }
+};
+
+static std::vector<event_t> read_trace(const char *file)
+{
+    FILE *fp = fopen(file, "r");
+    CHECK(fp != NULL);
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        text.append(buf, n);
+    fclose(fp);
+
+    std::vector<event_t> events;
+    json_parser_t parser(text);
+    CHECK(parser.parse(events));
+    return events;
+}
+
+/* Both threads stay alive until both have recorded, the ring of an exited
+ * thread would otherwise be handed to the other one */
+static pthread_barrier_t g_barrier;
+
+static void *small_thread(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < SMALL_CALLS; i++)
+    {
+        urts_trace(URTS_TRACE_ECALL_ENTER, 7);
+        urts_trace(URTS_TRACE_OCALL_ENTER, 2);
+        urts_trace(URTS_TRACE_OCALL_EXIT, 2);
+        urts_trace(URTS_TRACE_ECALL_EXIT, 7);
+    }
+    pthread_barrier_wait(&g_barrier);
+    return NULL;
+}
+
+static void *large_thread(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < LARGE_CALLS; i++)
+    {
+        urts_trace(URTS_TRACE_ECALL_ENTER, 1);
+        urts_trace(URTS_TRACE_ECALL_EXIT, 1);
+    }
+    pthread_barrier_wait(&g_barrier);
+    return NULL;
+}
+
+static void record()
+{
+    pthread_t small, large;
+    CHECK(pthread_barrier_init(&g_barrier, NULL, 2) == 0);
+    CHECK(pthread_create(&small, NULL, small_thread, NULL) == 0);
+    CHECK(pthread_create(&large, NULL, large_thread, NULL) == 0);
+    CHECK(pthread_join(small, NULL) == 0);
+    CHECK(pthread_join(large, NULL) == 0);
+    pthread_barrier_destroy(&g_barrier);
+}
+
+static void check_events(const std::vector<event_t> &events, pid_t pid)
+{
+    /* one ring per thread, the small one complete and properly nested, the
+     * large one holding only its last RING_EVENTS events */
+    std::map<long, std::vector<const event_t *> > by_tid;
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        CHECK(events[i].pid == (long)pid);
+        by_tid[events[i].tid].push_back(&events[i]);
+    }
+    CHECK(by_tid.size() == 2);
+
+    size_t small_events = 0, large_events = 0;
+    for (std::map<long, std::vector<const event_t *> >::iterator it = by_tid.begin(); it != by_tid.end(); ++it)
+    {
+        std::vector<std::string> stack;
+        double last_ts = 0;
+        for (size_t i = 0; i < it->second.size(); i++)
+        {
+            const event_t *event = it->second[i];
+            CHECK(event->ts >= last_ts);
+            last_ts = event->ts;
+            CHECK(event->cat == "ecall" || event->cat == "ocall");
+            CHECK(event->name.compare(0, 6, event->cat + " ") == 0);
+            if (event->ph == "B")
+            {
+                stack.push_back(event->name);
+            }
+            else
+            {
+                CHECK(event->ph == "E");
+                CHECK(!stack.empty() && stack.back() == event->name);
+                stack.pop_back();
+            }
+        }
+        CHECK(stack.empty());
+        if (it->second[0]->name == "ecall 7")
+            small_events = it->second.size();
+        else
+            large_events = it->second.size();
+    }
+    CHECK(small_events == SMALL_CALLS * 4);
+    CHECK(large_events == RING_EVENTS);
+}
+
+static int run_child(const char *self, const char *mode, const char *file, bool ignore_sigusr2, pid_t *child)
+{
+    pid_t pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0)
+    {
+        /* SIG_IGN survives exec, SIG_DFL is what the trace expects to own */
+        signal(SIGUSR2, ignore_sigusr2 ? SIG_IGN : SIG_DFL);
+        setenv("SGX_URTS_TRACE", file, 1);
+        execl(self, self, mode, (char *)NULL);
+        _exit(127);
+    }
+    int status = 0;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status));
+    *child = pid;
+    return WEXITSTATUS(status);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 2 && strcmp(argv[1], "signal") == 0)
+    {
+        CHECK(g_urts_trace_enabled);
+        record();
+        unlink(TRACE_FILE_SIGNAL);
+        CHECK(raise(SIGUSR2) == 0);
+        check_events(read_trace(TRACE_FILE_SIGNAL), getpid());
+        return 0;
+    }
+    if (argc == 2 && strcmp(argv[1], "exit") == 0)
+    {
+        /* the application owns SIGUSR2, nothing is written until exit */
+        CHECK(g_urts_trace_enabled);
+        record();
+        CHECK(raise(SIGUSR2) == 0);
+        CHECK(access(TRACE_FILE_EXIT, F_OK) != 0);
+        return 0;
+    }
+
+    /* tracing stays off without SGX_URTS_TRACE */
+    CHECK(getenv("SGX_URTS_TRACE") == NULL);
+    CHECK(!g_urts_trace_enabled);
+
+    pid_t child = 0;
+    CHECK(run_child(argv[0], "signal", TRACE_FILE_SIGNAL, false, &child) == 0);
+
+    unlink(TRACE_FILE_EXIT);
+    CHECK(run_child(argv[0], "exit", TRACE_FILE_EXIT, true, &child) == 0);
+    check_events(read_trace(TRACE_FILE_EXIT), child);
+
+    printf("urts_trace_test: %d + %d transitions, dumped on SIGUSR2 and at exit\n", SMALL_CALLS * 2, LARGE_CALLS);
+    return 0;
+}
@@ -655,6 +655,8 @@ extern "C" sgx_status_t sgx_destroy_enclave(const sgx_enclave_id_t enclave_id)
             enclave->destroy_uswitchless();
             if (get_enclave_creator()->is_EDMM_supported(enclave->get_enclave_id()))
                 enclave->ecall(ECMD_UNINIT_ENCLAVE, NULL, NULL);
+            // after ECMD_UNINIT_ENCLAVE, which may still queue [async] OCALLs
+            enclave->destroy_async_ocall();
             CEnclavePool::instance()->unref_enclave(enclave);
         }
     }
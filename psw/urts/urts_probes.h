@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _URTS_PROBES_H_
+#define _URTS_PROBES_H_
+
+/* USDT probes of the "sgx_urts" provider, for tracing transitions on live
+ * hosts without rebuilding, e.g.
+ *   bpftrace -e 'usdt:/usr/lib/x86_64-linux-gnu/libsgx_urts.so:sgx_urts:ecall_entry { @[arg1] = count(); }'
+ * Each probe is a nop plus an ELF note. The Makefile defines URTS_HAVE_USDT
+ * when sys/sdt.h is installed, warns and compiles the probes to nothing
+ * otherwise, and checks the notes with readelf -n (make check_usdt).
+ *
+ *   ecall_entry(eid, proc)             ecall_return(eid, proc, status)
+ *   ocall_entry(eid, proc)             ocall_return(eid, proc, status)
+ *   exception_ecall(eid, tcs)          the signal handler enters the enclave to
+ *                                      handle an exception, AEXs resumed without
+ *                                      it are not seen by the uRTS
+ *   tcs_acquire(ecall_cmd, tcs, waited)
+ *   switchless_fallback(eid, proc)     a switchless ECALL runs as a regular one,
+ *                                      proc is -1 for a queued asynchronous ECALL
+ */
+#ifdef URTS_HAVE_USDT
+#include <sys/sdt.h>
+#define URTS_PROBE2(name, a1, a2)       DTRACE_PROBE2(sgx_urts, name, a1, a2)
+#define URTS_PROBE3(name, a1, a2, a3)   DTRACE_PROBE3(sgx_urts, name, a1, a2, a3)
+#else
+#define URTS_PROBE2(name, a1, a2)       do {} while(0)
+#define URTS_PROBE3(name, a1, a2, a3)   do {} while(0)
+#endif
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "urts_trace.h"
+#include "se_trace.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#define URTS_TRACE_RING_EVENTS  4096    /* power of two, 64KB per thread */
+#define URTS_TRACE_ENV          "SGX_URTS_TRACE"
+
+typedef struct _trace_event_t
+{
+    uint64_t tsc;
+    int32_t  index;
+    uint32_t type;
+} trace_event_t;
+
+typedef struct _trace_ring_t
+{
+    struct _trace_ring_t *next;
+    volatile int in_use;        /* owned by a live thread */
+    pid_t tid;
+    volatile uint64_t head;     /* events recorded since the ring was acquired */
+    trace_event_t events[URTS_TRACE_RING_EVENTS];
+} trace_ring_t;
+
+volatile int g_urts_trace_enabled = 0;
+
+/* Rings are never freed, a ring of an exited thread is reused by the next one */
+static trace_ring_t *volatile g_ring_list = NULL;
+static __thread trace_ring_t *t_ring = NULL;
+static pthread_key_t g_ring_key;
+static pthread_once_t g_ring_key_once = PTHREAD_ONCE_INIT;
+
+/* TSC and monotonic clock when tracing was enabled, to convert TSC into time */
+static volatile uint64_t g_base_tsc = 0;
+static volatile uint64_t g_base_ns = 0;
+
+static const char *g_trace_file = NULL;
+
+static inline uint64_t read_tsc()
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint64_t get_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void release_ring(void *ring)
+{
+    __atomic_store_n(&((trace_ring_t *)ring)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_ring_key()
+{
+    pthread_key_create(&g_ring_key, release_ring);
+}
+
+static trace_ring_t *acquire_ring()
+{
+    trace_ring_t *ring = NULL;
+    for (ring = g_ring_list; ring != NULL; ring = ring->next)
+    {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&ring->in_use, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+    }
+
+    if (ring == NULL)
+    {
+        ring = (trace_ring_t *)calloc(1, sizeof(trace_ring_t));
+        if (ring == NULL)
+            return NULL;
+        ring->in_use = 1;
+        ring->next = g_ring_list;
+        while (!__atomic_compare_exchange_n(&g_ring_list, &ring->next, ring, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+    }
+
+    ring->tid = (pid_t)syscall(SYS_gettid);
+    __atomic_store_n(&ring->head, 0, __ATOMIC_RELEASE);
+
+    pthread_once(&g_ring_key_once, create_ring_key);
+    pthread_setspecific(g_ring_key, ring);
+    return ring;
+}
+
+void urts_trace_record(urts_trace_type_t type, int index)
+{
+    trace_ring_t *ring = t_ring;
+    if (ring == NULL)
+    {
+        if ((ring = acquire_ring()) == NULL)
+            return;
+        t_ring = ring;
+    }
+
+    uint64_t head = ring->head;
+    trace_event_t *event = &ring->events[head & (URTS_TRACE_RING_EVENTS - 1)];
+    event->tsc = read_tsc();
+    event->index = index;
+    event->type = (uint32_t)type;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void urts_trace_enable(bool enable)
+{
+    if (enable && !g_urts_trace_enabled)
+    {
+        g_base_ns = get_time_ns();
+        g_base_tsc = read_tsc();
+    }
+    __atomic_store_n(&g_urts_trace_enabled, enable ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+/* A buffered writer using only write(2), snprintf is not async-signal-safe */
+typedef struct _trace_writer_t
+{
+    int fd;
+    bool failed;
+    size_t len;
+    char buf[4096];
+} trace_writer_t;
+
+static void writer_flush(trace_writer_t *w)
+{
+    size_t off = 0;
+    while (off < w->len && !w->failed)
+    {
+        ssize_t n = write(w->fd, w->buf + off, w->len - off);
+        if (n > 0)
+            off += (size_t)n;
+        else if (n < 0 && errno != EINTR)
+            w->failed = true;
+    }
+    w->len = 0;
+}
+
+static void writer_str(trace_writer_t *w, const char *s)
+{
+    for (; *s; s++)
+    {
+        if (w->len == sizeof(w->buf))
+            writer_flush(w);
+        w->buf[w->len++] = *s;
+    }
+}
+
+static void writer_u64(trace_writer_t *w, uint64_t v, int min_digits)
+{
+    char digits[21];
+    int n = 0;
+    do
+    {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0 || n < min_digits);
+
+    char s[22];
+    for (int i = 0; i < n; i++)
+        s[i] = digits[n - 1 - i];
+    s[n] = '\0';
+    writer_str(w, s);
+}
+
+static void writer_i32(trace_writer_t *w, int32_t v)
+{
+    if (v < 0)
+    {
+        writer_str(w, "-");
+        writer_u64(w, (uint64_t)(-(int64_t)v), 1);
+    }
+    else
+        writer_u64(w, (uint64_t)v, 1);
+}
+
+static void write_event(trace_writer_t *w, const trace_event_t *event, pid_t pid, pid_t tid,
+                        uint64_t tsc_span, uint64_t ns_span, bool *first)
+{
+    bool is_ecall = event->type == URTS_TRACE_ECALL_ENTER || event->type == URTS_TRACE_ECALL_EXIT;
+    bool is_enter = event->type == URTS_TRACE_ECALL_ENTER || event->type == URTS_TRACE_OCALL_ENTER;
+
+    /* Events recorded before tracing was (re)enabled are dropped */
+    if (event->tsc < g_base_tsc)
+        return;
+    uint64_t ns = (uint64_t)((unsigned __int128)(event->tsc - g_base_tsc) * ns_span / tsc_span);
+
+    writer_str(w, *first ? "\n" : ",\n");
+    *first = false;
+    writer_str(w, is_ecall ? "{\"name\":\"ecall " : "{\"name\":\"ocall ");
+    writer_i32(w, event->index);
+    writer_str(w, is_ecall ? "\",\"cat\":\"ecall\",\"ph\":\"" : "\",\"cat\":\"ocall\",\"ph\":\"");
+    writer_str(w, is_enter ? "B" : "E");
+    writer_str(w, "\",\"ts\":");
+    writer_u64(w, ns / 1000, 1);
+    writer_str(w, ".");
+    writer_u64(w, ns % 1000, 3);
+    writer_str(w, ",\"pid\":");
+    writer_u64(w, (uint64_t)pid, 1);
+    writer_str(w, ",\"tid\":");
+    writer_u64(w, (uint64_t)tid, 1);
+    writer_str(w, "}");
+}
+
+sgx_status_t urts_trace_dump(const char *filename)
+{
+    if (filename == NULL)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    trace_writer_t w;
+    w.fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (w.fd < 0)
+        return SGX_ERROR_UNEXPECTED;
+    w.failed = false;
+    w.len = 0;
+
+    uint64_t tsc_span = read_tsc() - g_base_tsc;
+    uint64_t ns_span = get_time_ns() - g_base_ns;
+    if (tsc_span == 0)
+        tsc_span = 1;
+
+    pid_t pid = getpid();
+    bool first = true;
+    writer_str(&w, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    /* Rings are read while threads keep recording, events being overwritten
+     * at the time may come out torn */
+    for (trace_ring_t *ring = g_ring_list; ring != NULL; ring = ring->next)
+    {
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t tail = head > URTS_TRACE_RING_EVENTS ? head - URTS_TRACE_RING_EVENTS : 0;
+        for (uint64_t i = tail; i < head; i++)
+        {
+            write_event(&w, &ring->events[i & (URTS_TRACE_RING_EVENTS - 1)], pid, ring->tid,
+                        tsc_span, ns_span, &first);
+        }
+    }
+
+    writer_str(&w, "\n]}\n");
+    writer_flush(&w);
+    close(w.fd);
+    return w.failed ? SGX_ERROR_UNEXPECTED : SGX_SUCCESS;
+}
+
+static void dump_on_signal(int signum)
+{
+    (void)signum;
+    int saved_errno = errno;
+    urts_trace_dump(g_trace_file);
+    errno = saved_errno;
+}
+
+static void dump_at_exit()
+{
+    urts_trace_dump(g_trace_file);
+}
+
+__attribute__((constructor)) static void urts_trace_init()
+{
+    const char *file = getenv(URTS_TRACE_ENV);
+    if (file == NULL || *file == '\0')
+        return;
+
+    g_trace_file = file;
+    urts_trace_enable(true);
+
+    /* Do not take SIGUSR2 over from the application */
+    struct sigaction sa, old_sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = dump_on_signal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGUSR2, NULL, &old_sa) == 0 && old_sa.sa_handler == SIG_DFL)
+    {
+        sigaction(SIGUSR2, &sa, NULL);
+    }
+    else
+    {
+        SE_TRACE(SE_TRACE_WARNING, "SIGUSR2 is in use, the transition trace is only written at exit\n");
+    }
+
+    atexit(dump_at_exit);
+}
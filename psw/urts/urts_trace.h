@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _URTS_TRACE_H_
+#define _URTS_TRACE_H_
+
+#include "sgx_error.h"
+
+/* Runtime-enabled tracing of enclave transitions. Each thread records into
+ * its own fixed-size ring, so the oldest events are overwritten once a ring
+ * is full. Tracing is enabled with sgx_enable_transition_trace() or by
+ * setting SGX_URTS_TRACE to an output file, which is then written on SIGUSR2
+ * and at exit.
+ */
+typedef enum
+{
+    URTS_TRACE_ECALL_ENTER,
+    URTS_TRACE_ECALL_EXIT,
+    URTS_TRACE_OCALL_ENTER,
+    URTS_TRACE_OCALL_EXIT
+} urts_trace_type_t;
+
+extern volatile int g_urts_trace_enabled;
+
+void urts_trace_record(urts_trace_type_t type, int index);
+
+static inline void urts_trace(urts_trace_type_t type, int index)
+{
+    if (__builtin_expect(g_urts_trace_enabled, 0))
+        urts_trace_record(type, index);
+}
+
+void urts_trace_enable(bool enable);
+
+/* Write all rings as Chrome trace-event JSON. Only async-signal-safe calls
+ * are made, so it may run in a signal handler. */
+sgx_status_t urts_trace_dump(const char *filename);
+
+#endif
@@ -87,6 +87,7 @@ type ptr_attr = {
   pa_iswstr     : bool;       (* 'wchar*' pointer with length of wcslen(x), 'iswstr' *)
   pa_rdonly     : bool;       (* If the pointer is 'const' qualified, 'readonly' *)
   pa_chkptr     : bool;       (* Whether to generate code to check pointer, 'user_check' *)
+  pa_shared     : bool;       (* Points into a registered untrusted region, passed without copy, 'shared' *)
 }
 
 (* parameter type *)
@@ -108,6 +109,7 @@ let get_call_conv_str (cc: call_conv) =
 type func_attr = {
   fa_dllimport : bool;                   (* use 'dllimport'? *)
   fa_convention: call_conv;              (* the calling convention *)
+  fa_async     : bool;                   (* queued without waiting, 'async' *)
 }
 
 (* A declarator can be an identifier or an identifier with array form.
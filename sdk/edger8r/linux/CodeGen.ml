@@ -64,6 +64,17 @@ let get_sgx_fname fn_id is_switchless =
     | SGX_OCALLOC -> "sgx_ocalloc"
     | SGX_OCFREE -> "sgx_ocfree"
 
+(* Async OCalls allocate and queue the marshaling structure in a ring shared
+ * with the uRTS, with the synchronous OCall as the fallback. *)
+let get_ocall_fname fn_id (uf: Ast.untrusted_func) =
+  if not uf.Ast.uf_fattr.Ast.fa_async then get_sgx_fname fn_id uf.Ast.uf_is_switchless
+  else
+    match fn_id with
+      SGX_ECALL -> get_sgx_fname fn_id false
+    | SGX_OCALL -> "sgx_async_ocall"
+    | SGX_OCALLOC -> "sgx_async_ocalloc"
+    | SGX_OCFREE -> "sgx_async_ocfree"
+
 (* Whether to prefix untrusted proxy with Enclave name *)
 let g_use_prefix = ref false
 let g_untrusted_dir = ref "."
@@ -653,6 +664,23 @@ let gen_uproxy_com_proto (fd: Ast.func_decl) (prefix: string) =
     else fd.Ast.fname
   in "sgx_status_t " ^ fname ^ eid_parm_str ^ parm_list ^ ")"
 
+(* Switchless trusted functions also get an `_async' untrusted proxy,
+ * which returns a handle to be completed by sgx_ecall_wait() or
+ * sgx_ecall_poll():
+ *   sgx_status_t foo_async(sgx_enclave_id_t eid, sgx_ecall_handle_t* handle, int* retval, double d);
+ *)
+let gen_uproxy_async_proto (fd: Ast.func_decl) (prefix: string) =
+  let retval_parm_str =
+    if fd.Ast.rtype = Ast.Void then ""
+    else ", " ^ gen_parm_retval fd.Ast.rtype in
+  let parm_list =
+    List.fold_left (fun acc pd -> acc ^ ", " ^ gen_parm_str pd)
+      retval_parm_str fd.Ast.plist in
+  let fname =
+    if !g_use_prefix then sprintf "%s_%s_async" prefix fd.Ast.fname
+    else fd.Ast.fname ^ "_async"
+  in sprintf "sgx_status_t %s(sgx_enclave_id_t %s, sgx_ecall_handle_t* handle%s)" fname eid_name parm_list
+
 let get_ret_tystr (fd: Ast.func_decl) = Ast.get_tystr fd.Ast.rtype
 let get_plist_str (fd: Ast.func_decl) =
   if fd.Ast.plist = [] then "void"
@@ -714,12 +742,18 @@ let gen_untrusted_header (ec: enclave_content) =
                   gen_uproxy_com_proto tf.Ast.tf_fdecl ec.enclave_name)
         ec.tfunc_decls
   in
+  let uproxy_async_proto =
+      List.map (fun (tf: Ast.trusted_func) ->
+                  gen_uproxy_async_proto tf.Ast.tf_fdecl ec.enclave_name)
+        (List.filter is_switchless_ecall ec.tfunc_decls)
+  in
   let out_chan = open_out header_fname in
     output_string out_chan (preemble_code ^ "\n");
     List.iter (fun s -> output_string out_chan (s ^ "\n")) comp_def_list;
     List.iter (fun s -> output_string out_chan (s ^ "\n")) func_proto_ufunc;
     output_string out_chan "\n";
     List.iter (fun s -> output_string out_chan (s ^ ";\n")) uproxy_com_proto;
+    List.iter (fun s -> output_string out_chan (s ^ ";\n")) uproxy_async_proto;
     output_string out_chan header_footer;
     close_out out_chan
 
@@ -901,11 +935,49 @@ let gen_func_uproxy (tf: Ast.trusted_func) (idx: int) (ec: enclave_content) =
           List.fold_left (fun acc s -> acc ^ "\t" ^ s ^ "\n") func_open (List.rev !func_body) ^ func_close
       end
 
+(* Generate the `_async' untrusted proxy of a switchless trusted function.
+ * The marshaling structure is copied by sgx_ecall_switchless_async(), and
+ * the return value is stored when the call is completed.
+ *)
+let gen_func_uproxy_async (tf: Ast.trusted_func) (idx: int) (ec: enclave_content) =
+  let fd = tf.Ast.tf_fdecl in
+  let func_open  =
+    gen_uproxy_async_proto fd ec.enclave_name ^
+      "\n{\n\tsgx_status_t status;\n"
+  in
+  let func_close = "\treturn status;\n}\n" in
+  let ocall_table_ptr = sprintf "&%s" (mk_ocall_table_name ec.enclave_name) in
+  let ms_struct_name  = mk_ms_struct_name fd.Ast.fname in
+  let declare_ms_expr = sprintf "%s %s;" ms_struct_name ms_struct_val in
+  let retval_args =
+    if fd.Ast.rtype = Ast.Void then "NULL, 0"
+    else sprintf "%s, sizeof(*%s)" retval_name retval_name
+  in
+  let ecall_with_ms = sprintf "status = sgx_ecall_switchless_async(%s, %d, %s, &%s, sizeof(%s), %s, handle);"
+                              eid_name idx ocall_table_ptr ms_struct_val ms_struct_val retval_args in
+  let ecall_null = sprintf "status = sgx_ecall_switchless_async(%s, %d, %s, NULL, 0, NULL, 0, handle);"
+                           eid_name idx ocall_table_ptr
+  in
+  let func_body = ref [] in
+    if is_naked_func fd then
+      sprintf "%s\t%s\n%s" func_open ecall_null func_close
+    else
+      begin
+        func_body := declare_ms_expr :: !func_body;
+        List.iter (fun pd -> func_body := fill_ms_field false pd :: !func_body) fd.Ast.plist;
+        func_body := ecall_with_ms :: !func_body;
+          List.fold_left (fun acc s -> acc ^ "\t" ^ s ^ "\n") func_open (List.rev !func_body) ^ func_close
+      end
+
 (* Generate an expression to check the pointers. *)
 let mk_check_ptr (name: string) (lenvar: string) =
   let checker = "CHECK_UNIQUE_POINTER"
   in sprintf "\t%s(%s, %s);\n" checker name lenvar
 
+(* A [shared] buffer is left in place, it only has to lie in a registered region. *)
+let mk_check_shared_ptr (name: string) (lenvar: string) =
+  sprintf "\tCHECK_SHARED_POINTER(%s, %s);\n" name lenvar
+
 (* Pointer to marshaling structure should never be NULL. *)
 let mk_check_pms (fname: string) =
   let lenvar = sprintf "sizeof(%s)" (mk_ms_struct_name fname)
@@ -1022,9 +1094,9 @@ let gen_check_tbridge_ptr_parms (plist: Ast.pdecl list) =
       let name = declr.Ast.identifier in
       let len_var = mk_len_var name in
       let parm_name = mk_tmp_var name in
-        if pattr.Ast.pa_chkptr
-        then mk_check_ptr parm_name len_var
-        else ""
+        if pattr.Ast.pa_shared
+        then mk_check_shared_ptr parm_name len_var
+        else mk_check_ptr parm_name len_var
   in
   let new_param_list = List.map conv_array_to_ptr plist
   in
@@ -1278,7 +1350,7 @@ let gen_parm_ptr_direction_pre (plist: Ast.pdecl list) =
                 in
                 let struct_malloc =
                   let code_template = [
-                      sprintf "\t__tmp_%s = malloc(_%s_malloc_size);"(mk_in_var name) name;
+                      sprintf "\t__tmp_%s = ECALL_BUF_ALLOC(_%s_malloc_size);"(mk_in_var name) name;
                       sprintf "\tif (__tmp_%s == NULL) {" (mk_in_var name);
                       "\t\tstatus = SGX_ERROR_OUT_OF_MEMORY;";
                       "\t\tgoto err;";
@@ -1301,7 +1373,7 @@ let gen_parm_ptr_direction_pre (plist: Ast.pdecl list) =
               ]
               @ check_size @
               [
-              sprintf "\t%s = (%s)malloc(%s);" in_ptr_name in_ptr_type len_var;
+              sprintf "\t%s = (%s)ECALL_BUF_ALLOC(%s);" in_ptr_name in_ptr_type len_var;
               sprintf "\tif (%s == NULL) {" in_ptr_name;
               "\t\tstatus = SGX_ERROR_OUT_OF_MEMORY;";
               "\t\tgoto err;";
@@ -1345,7 +1417,7 @@ let gen_parm_ptr_direction_pre (plist: Ast.pdecl list) =
               ]
               @ check_size @
               [
-              sprintf "\tif ((%s = (%s)malloc(%s)) == NULL) {" in_ptr_name in_ptr_type len_var;
+              sprintf "\tif ((%s = (%s)ECALL_BUF_ALLOC(%s)) == NULL) {" in_ptr_name in_ptr_type len_var;
               "\t\tstatus = SGX_ERROR_OUT_OF_MEMORY;";
               "\t\tgoto err;";
               "\t}\n";
@@ -1512,14 +1584,14 @@ let gen_parm_ptr_free_post (plist: Ast.pdecl list) =
                           let (_, deep_copy)= get_struct_def struct_type
                           in
                           if deep_copy then
-                             sprintf "\tif (_in_member_%s) free(_in_member_%s);\n" name name
+                             sprintf "\tif (_in_member_%s) ECALL_BUF_FREE(_in_member_%s);\n" name name
                           else ""
                         else ""
                   | _ -> ""
             in
-            sprintf "\tif (%s) free(%s);\n%s" in_ptr_name in_ptr_dst_name struct_free
+            sprintf "\tif (%s) ECALL_BUF_FREE(%s);\n%s" in_ptr_name in_ptr_dst_name struct_free
         | Ast.PtrInOut | Ast.PtrOut ->
-                  sprintf "\tif (%s) free(%s);\n" in_ptr_name in_ptr_name
+                  sprintf "\tif (%s) ECALL_BUF_FREE(%s);\n" in_ptr_name in_ptr_name
         | _ -> ""
   in
   List.fold_left
@@ -1615,7 +1687,7 @@ let gen_tbridge_local_vars (plist: Ast.pdecl list) =
         | _ -> sprintf "\t%s %s = NULL;\n" (Ast.get_tystr ty) (mk_in_var name)
     in
     let in_ptr_struct_var =
-      if not attr.Ast.pa_chkptr then ""
+      if not attr.Ast.pa_chkptr || attr.Ast.pa_shared then ""
       else
        let gen_struct_local_var (param_direction: Ast.ptr_direction) (struct_type: string) (struct_name: string) (ty: Ast.atype) (attr: Ast.ptr_attr) (declr: Ast.declarator)=
            let in_ptr_name = mk_in_var2 struct_name declr.Ast.identifier in
@@ -1696,12 +1768,12 @@ let gen_func_tbridge (fd: Ast.func_decl) (dummy_var: string) =
         (gen_parm_ptr_free_post fd.Ast.plist)
         func_close
 
-let tproxy_fill_ms_field (pd: Ast.pdecl) (is_ocall_switchless: bool) =
+let tproxy_fill_ms_field (pd: Ast.pdecl) (uf: Ast.untrusted_func) =
   let (pt, declr)   = pd in
   let name          = declr.Ast.identifier in
   let len_var       = mk_len_var name in
   let parm_accessor = mk_parm_accessor name in
-  let sgx_ocfree_fn = get_sgx_fname SGX_OCFREE is_ocall_switchless in
+  let sgx_ocfree_fn = get_ocall_fname SGX_OCFREE uf in
     match pt with
         Ast.PTVal _ -> fill_ms_field true pd
       | Ast.PTPtr(ty, attr) ->
@@ -1791,11 +1863,11 @@ let tproxy_fill_ms_field (pd: Ast.pdecl) (is_ocall_switchless: bool) =
                     in List.fold_left (fun acc s -> acc ^ s ^ "\n\t") "" code_template
 
 (* Attach data pointed by structure member pointer at the end of ms. *)
-let tproxy_fill_structure(pd: Ast.pdecl) (is_ocall_switchless: bool)=
+let tproxy_fill_structure(pd: Ast.pdecl) (uf: Ast.untrusted_func)=
   let (pt, declr)   = pd in
   let name          = declr.Ast.identifier in
   let parm_accessor = mk_parm_accessor name in
-  let sgx_ocfree_fn = get_sgx_fname SGX_OCFREE is_ocall_switchless in
+  let sgx_ocfree_fn = get_ocall_fname SGX_OCFREE uf in
   let fill_structure(param_direction: Ast.ptr_direction) (struct_type: string) (struct_name: string)  (ty: Ast.atype) (attr: Ast.ptr_attr) (declr: Ast.declarator) =
     let member_name        = declr.Ast.identifier in
     let len_member_name = mk_len_var2 struct_name member_name in
@@ -1876,8 +1948,63 @@ let gen_tproxy_local_vars (plist: Ast.pdecl list) =
     str ^ if deep_copy then "\tsize_t i = 0;\n" else ""
     
 
-(* Generate only one ocalloc block required for the trusted proxy. *)
-let gen_ocalloc_block (fname: string) (plist: Ast.pdecl list) (is_switchless: bool) =
+(* Generate code adding the size of the data pointed by structure members
+ * to `ocalloc_size', so that it is allocated with the marshaling structure.
+ * It runs before sgx_ocalloc, hence nothing needs to be freed on error.
+ *)
+let gen_struct_deep_copy_size (new_param_list: Ast.pdecl list) =
+  let count_ocalloc_size (ty: Ast.atype) (attr: Ast.ptr_attr) (name: string) =
+    if not attr.Ast.pa_chkptr then ""
+    else 
+      let count_struct_ocalloc_size =  
+         let gen_member_size (_: Ast.ptr_direction) (_: string) (struct_name: string)  (ty: Ast.atype) (attr: Ast.ptr_attr) (declr: Ast.declarator) =
+           let in_len_ptr_var = mk_len_var2 struct_name declr.Ast.identifier in
+           let para_struct = sprintf "(%s + i)->%s"  struct_name in
+           let check_size =
+                match ty with
+                Ast.Ptr(Ast.Void) | Ast.Ptr(Ast.Foreign(_)) | Ast.Foreign(_)  | Ast.Ptr(Ast.Struct(_)) -> []
+                | _ ->
+                    [
+                       sprintf "if (%s %% sizeof(*%s) != 0)" in_len_ptr_var (para_struct declr.Ast.identifier); (* "size x count" is a multiple of sizeof type *)
+                       "\treturn SGX_ERROR_INVALID_PARAMETER;";
+                    ]
+           in
+           let code_template = 
+               [
+               gen_check_member_length ty attr declr para_struct "\t\t\t" ["\treturn SGX_ERROR_INVALID_PARAMETER;"];
+               sprintf "%s = %s;" in_len_ptr_var (gen_struct_ptr_size ty attr struct_name para_struct);
+               ]
+               @ check_size @
+               [
+               sprintf "if (%s && ! sgx_is_within_enclave(%s, %s))" (para_struct declr.Ast.identifier)  (para_struct declr.Ast.identifier) in_len_ptr_var;
+               "\treturn SGX_ERROR_INVALID_PARAMETER;";
+               sprintf "if (ADD_ASSIGN_OVERFLOW(ocalloc_size, (%s != NULL) ? %s : 0))" (para_struct declr.Ast.identifier) in_len_ptr_var;
+               "\treturn SGX_ERROR_INVALID_PARAMETER;";
+               ]
+           in
+           List.fold_left (fun acc s -> acc ^ "\t\t\t" ^ s ^ "\n") "" code_template
+         in
+         invoke_if_struct ty attr.Ast.pa_direction name (fun struct_type name -> sprintf "\t\tfor (i = 0; i < %s / sizeof(struct %s); i++){\n"  (mk_len_var name) struct_type) gen_member_size "\t\t}\n"
+      in
+      if count_struct_ocalloc_size <> "" then
+                  sprintf "\tif (%s != NULL && %s != 0){\n" name (mk_len_var name) ^
+                  sprintf "%s" count_struct_ocalloc_size ^
+                  "\t}\n"
+      else ""
+  in
+  let do_count_ocalloc_size (pd: Ast.pdecl) =
+    let (pty, declr) = pd in
+      match pty with
+        Ast.PTVal _          -> ""
+      | Ast.PTPtr (ty, attr) -> count_ocalloc_size ty attr declr.Ast.identifier
+  in
+  List.fold_left (fun acc pd -> acc ^ do_count_ocalloc_size pd) "" new_param_list
+
+(* Generate only one ocalloc block required for the trusted proxy.
+ * The marshaling structure, the buffers of pointer parameters and the data
+ * of structure members being deep copied are laid out contiguously in it.
+ *)
+let gen_ocalloc_block (fname: string) (plist: Ast.pdecl list) (uf: Ast.untrusted_func) =
   let ms_struct_name = mk_ms_struct_name fname in
   let new_param_list = List.map conv_array_to_ptr plist in
   let local_vars_block = sprintf "%s* %s = NULL;\n\tsize_t ocalloc_size = sizeof(%s);\n\tvoid *__tmp = NULL;\n\n" ms_struct_name ms_struct_val ms_struct_name in
@@ -1922,8 +2049,8 @@ let gen_ocalloc_block (fname: string) (plist: Ast.pdecl list) (is_switchless: bo
         Ast.PTVal _          -> ""
       | Ast.PTPtr (ty, attr) -> count_ocalloc_size ty attr declr.Ast.identifier
   in
-  let sgx_ocalloc_fn = get_sgx_fname SGX_OCALLOC is_switchless in
-  let sgx_ocfree_fn = get_sgx_fname SGX_OCFREE is_switchless in
+  let sgx_ocalloc_fn = get_ocall_fname SGX_OCALLOC uf in
+  let sgx_ocfree_fn = get_ocall_fname SGX_OCFREE uf in
   let do_gen_ocalloc_block = [
       sprintf "\n\t__tmp = %s(ocalloc_size);\n" sgx_ocalloc_fn;
       "\tif (__tmp == NULL) {\n";
@@ -1936,76 +2063,8 @@ let gen_ocalloc_block (fname: string) (plist: Ast.pdecl list) (is_switchless: bo
       ]
   in
   let s1 = List.fold_left (fun acc pd -> acc ^ do_local_var pd) local_vars_block new_param_list in
-  let s2 = List.fold_left (fun acc pd -> acc ^ do_count_ocalloc_size pd) (s1 ^ check_enclave_ptr_block) new_param_list in
-     List.fold_left (fun acc s -> acc ^ s) s2 do_gen_ocalloc_block
-
-(* Generate only one ocalloc block required for the trusted proxy. *)
-let gen_ocalloc_block_struct_deep_copy (fname: string) (plist: Ast.pdecl list) (is_ocall_switchless: bool)=
-  let new_param_list = List.map conv_array_to_ptr plist in
-  let sgx_ocalloc_fn = get_sgx_fname SGX_OCALLOC is_ocall_switchless in
-  let sgx_ocfree_fn = get_sgx_fname SGX_OCFREE is_ocall_switchless in
-  let count_ocalloc_size (ty: Ast.atype) (attr: Ast.ptr_attr) (name: string) =
-    if not attr.Ast.pa_chkptr then ""
-    else 
-      let count_struct_ocalloc_size =  
-         let gen_member_size (_: Ast.ptr_direction) (_: string) (struct_name: string)  (ty: Ast.atype) (attr: Ast.ptr_attr) (declr: Ast.declarator) =
-           let in_len_ptr_var = mk_len_var2 struct_name declr.Ast.identifier in
-           let para_struct = sprintf "(%s + i)->%s"  struct_name in
-           let check_size =
-                match ty with
-                Ast.Ptr(Ast.Void) | Ast.Ptr(Ast.Foreign(_)) | Ast.Foreign(_)  | Ast.Ptr(Ast.Struct(_)) -> []
-                | _ ->
-                    [
-                       sprintf "if (%s %% sizeof(*%s) != 0) {" in_len_ptr_var (para_struct declr.Ast.identifier); (* "size x count" is a multiple of sizeof type *)
-                       sprintf "\t%s();" sgx_ocfree_fn;
-                       "\treturn SGX_ERROR_INVALID_PARAMETER;";
-                       "}";
-                    ]
-           in
-           let code_template = 
-               [
-               gen_check_member_length ty attr declr para_struct "\t\t\t" [(sprintf "\t%s();" sgx_ocfree_fn);"\treturn SGX_ERROR_INVALID_PARAMETER;"];
-               sprintf "%s = %s;" in_len_ptr_var (gen_struct_ptr_size ty attr struct_name para_struct);
-               ]
-               @ check_size @
-               [
-               sprintf "if (%s && ! sgx_is_within_enclave(%s, %s)) {" (para_struct declr.Ast.identifier)  (para_struct declr.Ast.identifier) in_len_ptr_var;
-               sprintf "\t%s();" sgx_ocfree_fn;
-               "\treturn SGX_ERROR_INVALID_PARAMETER;";
-               "}";
-               sprintf "\tif (ADD_ASSIGN_OVERFLOW(ocalloc_size, (%s != NULL) ? %s : 0)) {" (para_struct declr.Ast.identifier) in_len_ptr_var;
-               sprintf "\t%s();" sgx_ocfree_fn;
-               "\treturn SGX_ERROR_INVALID_PARAMETER;";
-               "}";
-               ]
-           in
-           List.fold_left (fun acc s -> acc ^ "\t\t\t" ^ s ^ "\n") "" code_template
-         in
-         invoke_if_struct ty attr.Ast.pa_direction name (fun struct_type name -> sprintf "\t\tfor (i = 0; i < %s / sizeof(struct %s); i++){\n"  (mk_len_var name) struct_type) gen_member_size "\t\t}\n"
-      in
-      if count_struct_ocalloc_size <> "" then
-                  sprintf "\tif (%s != NULL && %s != 0){\n" name (mk_len_var name) ^
-                  sprintf "%s" count_struct_ocalloc_size ^
-                  "\t}\n"
-      else ""
-  in
-  let do_count_ocalloc_size (pd: Ast.pdecl) =
-    let (pty, declr) = pd in
-      match pty with
-        Ast.PTVal _          -> ""
-      | Ast.PTPtr (ty, attr) -> count_ocalloc_size ty attr declr.Ast.identifier
-  in
-  let do_gen_ocalloc_block = [
-      sprintf "\n\t__tmp = %s(ocalloc_size);\n" sgx_ocalloc_fn;
-      "\tif (__tmp == NULL) {\n";
-      sprintf "\t\t%s();\n" sgx_ocfree_fn;
-      "\t\treturn SGX_ERROR_UNEXPECTED;\n";
-      "\t}\n";
-      ]
-  in
-  let s2 = List.fold_left (fun acc pd -> acc ^ do_count_ocalloc_size pd) "" new_param_list in
-  if s2 = "" then ""
-  else
+  let s2 = List.fold_left (fun acc pd -> acc ^ do_count_ocalloc_size pd) (s1 ^ check_enclave_ptr_block) new_param_list
+           ^ gen_struct_deep_copy_size new_param_list in
      List.fold_left (fun acc s -> acc ^ s) s2 do_gen_ocalloc_block
 
 (* Generate trusted proxy code for a given untrusted function. *)
@@ -2014,9 +2073,8 @@ let gen_func_tproxy (ufunc: Ast.untrusted_func) (idx: int) =
   let propagate_errno = ufunc.Ast.uf_propagate_errno in
   let func_open = sprintf "%s\n{\n" (gen_tproxy_proto fd) in
   let local_vars = gen_tproxy_local_vars fd.Ast.plist in
-  let ocalloc_ms_struct = gen_ocalloc_block fd.Ast.fname fd.Ast.plist ufunc.Ast.uf_is_switchless in
-  let ocalloc_struct_deep_copy = gen_ocalloc_block_struct_deep_copy fd.Ast.fname fd.Ast.plist in
-  let sgx_ocfree_fn = get_sgx_fname SGX_OCFREE ufunc.Ast.uf_is_switchless in
+  let ocalloc_ms_struct = gen_ocalloc_block fd.Ast.fname fd.Ast.plist ufunc in
+  let sgx_ocfree_fn = get_ocall_fname SGX_OCFREE ufunc in
   let gen_ocfree rtype plist =
     if rtype = Ast.Void && plist = [] && propagate_errno = false then "" else sprintf "\t%s();\n" sgx_ocfree_fn
   in
@@ -2149,7 +2207,7 @@ let gen_func_tproxy (ufunc: Ast.untrusted_func) (idx: int) =
                            "\t}"
                            (gen_ocfree fd.Ast.rtype fd.Ast.plist)
                            "\treturn status;\n}" in
-  let sgx_ocall_fn = get_sgx_fname SGX_OCALL ufunc.Ast.uf_is_switchless in
+  let sgx_ocall_fn = get_ocall_fname SGX_OCALL ufunc in
   let ocall_null = sprintf "status = %s(%d, NULL);\n" sgx_ocall_fn idx in
   let ocall_with_ms = sprintf "status = %s(%d, %s);\n" sgx_ocall_fn idx ms_struct_val in
   let update_retval = sprintf "\tif (%s) *%s = %s;"
@@ -2161,9 +2219,8 @@ let gen_func_tproxy (ufunc: Ast.untrusted_func) (idx: int) =
       begin
         func_body := local_vars :: !func_body;
         func_body := ocalloc_ms_struct:: !func_body;
-        List.iter (fun pd -> func_body := tproxy_fill_ms_field pd ufunc.Ast.uf_is_switchless :: !func_body ) fd.Ast.plist;
-        func_body := ocalloc_struct_deep_copy ufunc.Ast.uf_is_switchless :: !func_body;
-        List.iter (fun pd -> func_body := tproxy_fill_structure pd ufunc.Ast.uf_is_switchless:: !func_body) fd.Ast.plist;
+        List.iter (fun pd -> func_body := tproxy_fill_ms_field pd ufunc :: !func_body ) fd.Ast.plist;
+        List.iter (fun pd -> func_body := tproxy_fill_structure pd ufunc :: !func_body) fd.Ast.plist;
         func_body := ocall_with_ms :: !func_body;
         func_body := "if (status == SGX_SUCCESS) {" :: !func_body;
         if fd.Ast.rtype <> Ast.Void then func_body := update_retval :: !func_body;
@@ -2200,7 +2257,10 @@ let gen_untrusted_source (ec: enclave_content) =
   let include_hd = "#include \"" ^ get_uheader_short_name ec.file_shortnm ^ "\"\n" in
   let include_errno = "#include <errno.h>\n" in
   let uproxy_list =
-    List.map2 (fun tf ecall_idx -> gen_func_uproxy tf ecall_idx ec)
+    List.map2 (fun tf ecall_idx ->
+                 if is_switchless_ecall tf
+                 then gen_func_uproxy tf ecall_idx ec ^ "\n" ^ gen_func_uproxy_async tf ecall_idx ec
+                 else gen_func_uproxy tf ecall_idx ec)
       ec.tfunc_decls
       (Util.mk_seq 0 (List.length ec.tfunc_decls - 1))
   in
@@ -2240,9 +2300,24 @@ let gen_trusted_source (ec: enclave_content) =
 \t\treturn SGX_ERROR_INVALID_PARAMETER;\\\n\
 } while (0)\n\
 \n\
+#define CHECK_SHARED_POINTER(ptr, siz) do {\t\\\n\
+\tif ((ptr) && ! sgx_is_within_shared_region((ptr), (siz)))\t\\\n\
+\t\treturn SGX_ERROR_INVALID_PARAMETER;\\\n\
+} while (0)\n\
+\n\
 #define ADD_ASSIGN_OVERFLOW(a, b) (\t\\\n\
 \t((a) += (b)) < (b)\t\\\n\
 )\n\
+\n\
+/* Buffers up to SGX_ECALL_ARENA_THRESHOLD bytes are taken from the per-thread\n\
+ * ECALL arena, which is reset when the ECALL returns. 0 always uses malloc. */\n\
+#ifndef SGX_ECALL_ARENA_THRESHOLD\n\
+#define SGX_ECALL_ARENA_THRESHOLD 256\n\
+#endif\n\
+\n\
+#define ECALL_BUF_ALLOC(siz) \\\n\
+\t((siz) <= SGX_ECALL_ARENA_THRESHOLD ? sgx_ecall_arena_alloc(siz) : malloc(siz))\n\
+#define ECALL_BUF_FREE(ptr) sgx_ecall_arena_free(ptr)\n\
 \n"
   in
   let trusted_fds = tf_list_to_fd_list ec.tfunc_decls in
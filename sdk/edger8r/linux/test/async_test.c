@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Checks the trusted proxies generated for async.edl together with the
+ * ring of the tRTS (sdk/trts/trts_async_ocall.cpp):
+ *  - queued OCALLs run in the order they were made, with and without
+ *    parameters;
+ *  - an OCALL that finds the ring full, or that does not fit in a slot,
+ *    is made synchronously after the queued ones are flushed, so it neither
+ *    overtakes them nor is dropped;
+ *  - a proxy failing after it reserved a slot cancels it, and the slot
+ *    does not hold back the ones queued after it.
+ *
+ * The generated async_t.c is built into this file and linked with the tRTS
+ * ring, the other tRTS functions and the uRTS side are played below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef int errno_t;
+
+#include "async_t.c"
+#include "internal/rts.h"
+#include "internal/thread_data.h"
+#include "sgx_spinlock.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define MAX_EVENTS  1024
+#define TICK        0xFFFFFFFF  /* event of ocall_async_tick() */
+
+/* the uRTS */
+static async_ocall_ring_t g_ring __attribute__((aligned(4096)));
+static uint32_t g_events[MAX_EVENTS];
+static size_t g_event_count = 0;
+static size_t g_sync_calls = 0;
+static size_t g_flushes = 0;
+
+/* the tRTS */
+static uint8_t g_ustack[4096] __attribute__((aligned(64)));
+static size_t g_ustack_top = 0;
+static thread_data_t g_td;
+static int g_fail_copy = 0;
+
+thread_data_t *get_thread_data(void)
+{
+    return &g_td;
+}
+
+uint32_t sgx_spin_lock(sgx_spinlock_t *lock)
+{
+    *lock = 1;
+    return 0;
+}
+
+uint32_t sgx_spin_unlock(sgx_spinlock_t *lock)
+{
+    *lock = 0;
+    return 0;
+}
+
+int sgx_is_within_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 1;
+}
+
+int sgx_is_outside_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 1;
+}
+
+errno_t memcpy_s(void *dst, size_t dst_size, const void *src, size_t count)
+{
+    if (g_fail_copy || count > dst_size)
+        return -1;
+    memcpy(dst, src, count);
+    return 0;
+}
+
+void* sgx_ocalloc(size_t size)
+{
+    if (size > sizeof(g_ustack) - g_ustack_top)
+        return NULL;
+    g_ustack_top += size;
+    return g_ustack + g_ustack_top - size;
+}
+
+void sgx_ocfree(void)
+{
+    g_ustack_top = 0;
+}
+
+/* plays the untrusted bridges */
+static void run_ocall(unsigned int index, void *pms)
+{
+    CHECK(g_event_count < MAX_EVENTS);
+    if (index == 0) {
+        ms_ocall_async_log_t *ms = (ms_ocall_async_log_t *)pms;
+        for (size_t i = 0; i < ms->ms_len; i++)
+            CHECK(ms->ms_data[i] == (uint8_t)(ms->ms_seq + i));
+        g_events[g_event_count++] = ms->ms_seq;
+    } else {
+        CHECK(index == 1);
+        g_events[g_event_count++] = TICK;
+    }
+}
+
+/* what the uRTS worker does: run the ready slots from the head, skip the
+ * cancelled ones, stop at the first one not queued yet */
+static size_t drain(void)
+{
+    size_t count = 0;
+
+    for (;;) {
+        async_ocall_slot_t *slot = &g_ring.slots[g_ring.head % ASYNC_OCALL_RING_SLOTS];
+        if (slot->state != ASYNC_OCALL_SLOT_READY && slot->state != ASYNC_OCALL_SLOT_CANCELLED)
+            break;
+        if (slot->state == ASYNC_OCALL_SLOT_READY) {
+            CHECK(slot->table == 0);
+            run_ocall(slot->index, slot->data);
+        }
+        slot->state = ASYNC_OCALL_SLOT_FREE;
+        g_ring.head++;
+        count++;
+    }
+    return count;
+}
+
+sgx_status_t sgx_ocall(const unsigned int index, void *pms)
+{
+    switch ((int)index) {
+    case ASYNC_OCALL_SETUP:
+        ((ms_async_ocall_setup_t *)pms)->ring = &g_ring;
+        return SGX_SUCCESS;
+    case ASYNC_OCALL_TABLE:
+        ((ms_async_ocall_table_t *)pms)->table = 0;
+        return SGX_SUCCESS;
+    case ASYNC_OCALL_FLUSH:
+        g_flushes++;
+        drain();
+        return SGX_SUCCESS;
+    default:
+        /* a synchronous OCALL must never overtake a queued one */
+        CHECK(g_ring.slots[g_ring.head % ASYNC_OCALL_RING_SLOTS].state == ASYNC_OCALL_SLOT_FREE);
+        g_sync_calls++;
+        run_ocall(index, pms);
+        return SGX_SUCCESS;
+    }
+}
+
+static sgx_status_t log_seq(uint32_t seq, size_t len)
+{
+    static uint8_t data[2048];
+
+    for (size_t i = 0; i < len; i++)
+        data[i] = (uint8_t)(seq + i);
+    return ocall_async_log(seq, data, len);
+}
+
+static void check_events(const uint32_t *expected, size_t count)
+{
+    CHECK(g_event_count == count);
+    for (size_t i = 0; i < count; i++)
+        CHECK(g_events[i] == expected[i]);
+    g_event_count = 0;
+}
+
+void ecall_async(void)
+{
+    uint32_t expected[MAX_EVENTS];
+
+    /* queued in order, nothing runs until the worker drains the ring */
+    CHECK(log_seq(0, 16) == SGX_SUCCESS);
+    CHECK(ocall_async_tick() == SGX_SUCCESS);
+    CHECK(log_seq(1, 0) == SGX_SUCCESS);
+    CHECK(g_event_count == 0 && g_sync_calls == 0);
+    CHECK(g_ustack_top == 0);
+    CHECK(drain() == 3);
+    expected[0] = 0;
+    expected[1] = TICK;
+    expected[2] = 1;
+    check_events(expected, 3);
+
+    /* more OCALLs than slots: the one finding the ring full flushes it and
+     * runs synchronously, the next ones are queued again */
+    for (uint32_t seq = 0; seq < 100; seq++) {
+        CHECK(log_seq(seq, 32) == SGX_SUCCESS);
+        expected[seq] = seq;
+    }
+    CHECK(g_sync_calls == 1 && g_flushes == 1);
+    CHECK(g_event_count == ASYNC_OCALL_RING_SLOTS + 1);
+    CHECK(drain() == 100 - ASYNC_OCALL_RING_SLOTS - 1);
+    check_events(expected, 100);
+
+    /* too large for a slot, made synchronously behind the queued ones */
+    CHECK(log_seq(1, 8) == SGX_SUCCESS);
+    CHECK(log_seq(2, ASYNC_OCALL_SLOT_DATA_SIZE) == SGX_SUCCESS);
+    CHECK(log_seq(3, 8) == SGX_SUCCESS);
+    CHECK(g_sync_calls == 2 && g_flushes == 2);
+    CHECK(drain() == 1);
+    expected[0] = 1;
+    expected[1] = 2;
+    expected[2] = 3;
+    check_events(expected, 3);
+
+    /* a proxy failing after its slot was reserved cancels the slot */
+    CHECK(log_seq(4, 8) == SGX_SUCCESS);
+    g_fail_copy = 1;
+    CHECK(log_seq(5, 8) == SGX_ERROR_UNEXPECTED);
+    g_fail_copy = 0;
+    CHECK(log_seq(6, 8) == SGX_SUCCESS);
+    CHECK(g_ustack_top == 0);
+    CHECK(drain() == 3);
+    expected[0] = 4;
+    expected[1] = 6;
+    check_events(expected, 2);
+
+    CHECK(g_sync_calls == 2);
+    for (size_t i = 0; i < ASYNC_OCALL_RING_SLOTS; i++)
+        CHECK(g_ring.slots[i].state == ASYNC_OCALL_SLOT_FREE);
+}
+
+int main(void)
+{
+    CHECK(sgx_ecall_async(NULL) == SGX_SUCCESS);
+    printf("async_test: %llu OCALLs through the ring, %zu synchronous after a flush\n",
+           (unsigned long long)g_ring.head, g_sync_calls);
+    return 0;
+}
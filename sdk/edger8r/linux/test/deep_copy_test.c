@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Checks the trusted proxy generated for deep_copy.edl: the marshaling
+ * structure, the parameter buffers and the data of the deep copied members
+ * must come from a single sgx_ocalloc() of exactly the size the two
+ * separate blocks used to take, laid out in parameter order.
+ *
+ * The generated deep_copy_t.c is built into this file, the tRTS functions
+ * it calls are replaced by the ones below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef int errno_t;
+
+#include "deep_copy_t.c"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+static uint8_t g_stack[4096] __attribute__((aligned(64)));
+static size_t g_ocalloc_calls = 0;
+static size_t g_ocalloc_size = 0;
+
+void* sgx_ocalloc(size_t size)
+{
+    g_ocalloc_calls++;
+    g_ocalloc_size = size;
+    return size <= sizeof(g_stack) ? g_stack : NULL;
+}
+
+void sgx_ocfree(void)
+{
+}
+
+int sgx_is_within_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 1;
+}
+
+int sgx_is_outside_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 1;
+}
+
+errno_t memcpy_s(void *dst, size_t dst_size, const void *src, size_t count)
+{
+    if (count > dst_size)
+        return -1;
+    memcpy(dst, src, count);
+    return 0;
+}
+
+static int in_block(const void *p, size_t size)
+{
+    return (const uint8_t *)p >= g_stack &&
+           (const uint8_t *)p + size <= g_stack + g_ocalloc_size;
+}
+
+/* trusted data passed to the OCALL */
+static uint8_t g_buf0[13] = "deep copy #0";
+static uint64_t g_ids0[3] = {1, 2, 3};
+static uint8_t g_buf2[5] = "#2..";
+static uint32_t g_vals[7] = {10, 11, 12, 13, 14, 15, 16};
+static uint8_t g_extra[9] = "extra...";
+
+static struct dc_blob_t g_blobs[3] = {
+    {sizeof(g_buf0), g_buf0, 3, g_ids0},
+    {0, NULL, 0, NULL},                 /* no member data */
+    {sizeof(g_buf2), g_buf2, 0, NULL},
+};
+static struct dc_vec_t g_vec = {7, g_vals};
+
+/* plays the untrusted bridge */
+sgx_status_t sgx_ocall(const unsigned int index, void *pms)
+{
+    ms_ocall_deep_copy_t *ms = (ms_ocall_deep_copy_t *)pms;
+    uint8_t *end = g_stack + sizeof(ms_ocall_deep_copy_t);
+
+    CHECK(index == 0);
+    CHECK((uint8_t *)ms == g_stack);
+
+    /* parameter buffers follow the marshaling structure */
+    CHECK((uint8_t *)ms->ms_blobs == end);
+    end += sizeof(g_blobs);
+    CHECK((uint8_t *)ms->ms_vec == end);
+    end += sizeof(g_vec);
+    CHECK(ms->ms_extra == end && memcmp(ms->ms_extra, g_extra, sizeof(g_extra)) == 0);
+    end += sizeof(g_extra);
+
+    /* then the member data, in parameter and member order */
+    CHECK(ms->ms_blobs[0].buf == end && memcmp(end, g_buf0, sizeof(g_buf0)) == 0);
+    end += sizeof(g_buf0);
+    CHECK((uint8_t *)ms->ms_blobs[0].ids == end && memcmp(end, g_ids0, sizeof(g_ids0)) == 0);
+    end += sizeof(g_ids0);
+    CHECK(ms->ms_blobs[1].buf == NULL && ms->ms_blobs[1].ids == NULL);
+    CHECK(ms->ms_blobs[2].buf == end && memcmp(end, g_buf2, sizeof(g_buf2)) == 0);
+    end += sizeof(g_buf2);
+    CHECK(ms->ms_blobs[2].ids == NULL);
+    CHECK((uint8_t *)ms->ms_vec->vals == end && memcmp(end, g_vals, sizeof(g_vals)) == 0);
+    end += sizeof(g_vals);
+
+    CHECK(end == g_stack + g_ocalloc_size);
+    CHECK(in_block(ms->ms_vec->vals, sizeof(g_vals)));
+
+    /* shrink the [in, out] vector, the proxy copies the rest back */
+    ms->ms_vec->count = 2;
+    ms->ms_vec->vals[0] = 20;
+    ms->ms_vec->vals[1] = 21;
+    ms->ms_retval = 42;
+    return SGX_SUCCESS;
+}
+
+void ecall_deep_copy(void)
+{
+    int retval = 0;
+
+    sgx_status_t status = ocall_deep_copy(&retval, g_blobs, 3, &g_vec, g_extra, sizeof(g_extra));
+    CHECK(status == SGX_SUCCESS);
+    CHECK(retval == 42);
+}
+
+int main(void)
+{
+    /* what the marshaling block and the member block used to take */
+    size_t ms_block = sizeof(ms_ocall_deep_copy_t) + sizeof(g_blobs) + sizeof(g_vec) + sizeof(g_extra);
+    size_t member_block = sizeof(g_buf0) + sizeof(g_ids0) + sizeof(g_buf2) + sizeof(g_vals);
+
+    ecall_deep_copy();
+
+    CHECK(g_ocalloc_calls == 1);
+    CHECK(g_ocalloc_size == ms_block + member_block);
+
+    /* copied back into the trusted structure, the pointer is kept */
+    CHECK(g_vec.count == 2 && g_vec.vals == g_vals);
+    CHECK(g_vals[0] == 20 && g_vals[1] == 21 && g_vals[2] == 12);
+
+    printf("deep_copy_test: single sgx_ocalloc of %zu bytes\n", g_ocalloc_size);
+    return 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Checks the trusted bridges generated for ecall_arena.edl: [in] and [out]
+ * buffers up to SGX_ECALL_ARENA_THRESHOLD bytes must be taken from the ECALL
+ * arena and larger ones from malloc(), every buffer must be handed back to
+ * sgx_ecall_arena_free(), and once the runtime rewinds the arena around the
+ * dispatch, back to back ECALLs must reuse the same arena space.
+ *
+ * The generated ecall_arena_t.c is built into this file, the tRTS functions
+ * it calls are replaced by the ones below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef int errno_t;
+
+#include "ecall_arena_t.c"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+static uint8_t g_arena[4096] __attribute__((aligned(64)));
+static size_t g_arena_top = 0;
+static size_t g_arena_allocs = 0;
+static size_t g_arena_frees = 0;
+static size_t g_heap_frees = 0;
+
+static int in_arena(const void *p, size_t size)
+{
+    return (const uint8_t *)p >= g_arena &&
+           (const uint8_t *)p + size <= g_arena + g_arena_top;
+}
+
+void* sgx_ecall_arena_alloc(size_t size)
+{
+    size_t top = (g_arena_top + 15) & ~(size_t)15;
+
+    if (size > sizeof(g_arena) - top)
+        return malloc(size);
+    g_arena_allocs++;
+    g_arena_top = top + size;
+    return g_arena + top;
+}
+
+void sgx_ecall_arena_free(void *ptr)
+{
+    if ((uint8_t *)ptr >= g_arena && (uint8_t *)ptr < g_arena + sizeof(g_arena)) {
+        g_arena_frees++;
+        return;
+    }
+    g_heap_frees++;
+    free(ptr);
+}
+
+size_t sgx_ecall_arena_mark(void)
+{
+    return g_arena_top;
+}
+
+void sgx_ecall_arena_rewind(size_t mark)
+{
+    if (mark <= g_arena_top)
+        g_arena_top = mark;
+}
+
+int sgx_is_within_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 1;
+}
+
+int sgx_is_outside_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 1;
+}
+
+errno_t memcpy_s(void *dst, size_t dst_size, const void *src, size_t count)
+{
+    if (count > dst_size)
+        return -1;
+    memcpy(dst, src, count);
+    return 0;
+}
+
+static const void *g_last_buf = NULL;
+
+uint32_t ecall_arena_in(const uint8_t *buf, size_t len)
+{
+    uint32_t sum = 0;
+
+    g_last_buf = buf;
+    CHECK(in_arena(buf, len) == (len <= SGX_ECALL_ARENA_THRESHOLD));
+    for (size_t i = 0; i < len; i++)
+        sum += buf[i];
+    return sum;
+}
+
+void ecall_arena_out(uint8_t *buf, size_t len)
+{
+    g_last_buf = buf;
+    CHECK(in_arena(buf, len) == (len <= SGX_ECALL_ARENA_THRESHOLD));
+    for (size_t i = 0; i < len; i++) {
+        CHECK(buf[i] == 0);
+        buf[i] = (uint8_t)(i + 1);
+    }
+}
+
+/* plays trts_ecall() around the bridge */
+static sgx_status_t dispatch(sgx_status_t (*bridge)(void *), void *ms)
+{
+    size_t mark = sgx_ecall_arena_mark();
+    sgx_status_t status = bridge(ms);
+
+    sgx_ecall_arena_rewind(mark);
+    return status;
+}
+
+static uint32_t call_in(const uint8_t *buf, size_t len)
+{
+    ms_ecall_arena_in_t ms;
+
+    memset(&ms, 0, sizeof(ms));
+    ms.ms_buf = buf;
+    ms.ms_len = len;
+    CHECK(dispatch(sgx_ecall_arena_in, &ms) == SGX_SUCCESS);
+    return ms.ms_retval;
+}
+
+static void call_out(uint8_t *buf, size_t len)
+{
+    ms_ecall_arena_out_t ms;
+
+    memset(&ms, 0, sizeof(ms));
+    ms.ms_buf = buf;
+    ms.ms_len = len;
+    CHECK(dispatch(sgx_ecall_arena_out, &ms) == SGX_SUCCESS);
+}
+
+int main(void)
+{
+    static uint8_t src[SGX_ECALL_ARENA_THRESHOLD + 1];
+    static uint8_t dst[SGX_ECALL_ARENA_THRESHOLD + 1];
+    const void *first = NULL;
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i < sizeof(src); i++)
+        src[i] = (uint8_t)(i * 7);
+    for (size_t i = 0; i < SGX_ECALL_ARENA_THRESHOLD; i++)
+        sum += src[i];
+
+    /* at the threshold the copy is in the arena, and the same space is
+     * taken again by every ECALL once the arena is rewound */
+    for (int n = 0; n < 100; n++) {
+        CHECK(call_in(src, SGX_ECALL_ARENA_THRESHOLD) == sum);
+        if (first == NULL)
+            first = g_last_buf;
+        CHECK(g_last_buf == first);
+        CHECK(g_arena_top == 0);
+    }
+    CHECK(g_arena_allocs == 100 && g_arena_frees == 100);
+
+    /* one byte more goes to the heap */
+    CHECK(call_in(src, sizeof(src)) == sum + src[SGX_ECALL_ARENA_THRESHOLD]);
+    CHECK(!in_arena(g_last_buf, 1));
+    CHECK(g_arena_allocs == 100 && g_heap_frees == 1);
+
+    /* [out] buffers are zeroed in the arena and copied back */
+    call_out(dst, 64);
+    CHECK(g_last_buf == first);
+    for (size_t i = 0; i < 64; i++)
+        CHECK(dst[i] == (uint8_t)(i + 1));
+    call_out(dst, sizeof(dst));
+    CHECK(!in_arena(g_last_buf, 1));
+    CHECK(dst[SGX_ECALL_ARENA_THRESHOLD] == (uint8_t)(SGX_ECALL_ARENA_THRESHOLD + 1));
+    CHECK(g_arena_allocs == 101 && g_arena_frees == 101 && g_heap_frees == 2);
+
+    /* without the rewind every ECALL leaves its copy behind */
+    ms_ecall_arena_in_t ms;
+    memset(&ms, 0, sizeof(ms));
+    ms.ms_buf = src;
+    ms.ms_len = SGX_ECALL_ARENA_THRESHOLD;
+    CHECK(sgx_ecall_arena_in(&ms) == SGX_SUCCESS);
+    CHECK(sgx_ecall_arena_in(&ms) == SGX_SUCCESS);
+    CHECK(g_arena_top == 2 * SGX_ECALL_ARENA_THRESHOLD);
+    sgx_ecall_arena_rewind(0);
+
+    printf("ecall_arena_test: %d byte buffers reuse the arena, larger ones use malloc\n",
+           SGX_ECALL_ARENA_THRESHOLD);
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Checks the trusted bridges generated for shared.edl: a [shared] buffer
+ * must reach the trusted function as the untrusted pointer itself, without
+ * a copy, and only if the whole buffer lies in a registered shared region.
+ *
+ * The generated shared_t.c is built into this file, the tRTS functions it
+ * calls are replaced by the ones below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef int errno_t;
+
+#include "shared_t.c"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+/* the registered region, with untrusted memory on both sides */
+static uint8_t g_memory[3 * 1024] __attribute__((aligned(64)));
+static uint8_t *const g_region = g_memory + 1024;
+static const size_t g_region_size = 1024;
+static size_t g_region_checks = 0;
+static size_t g_copies = 0;
+
+int sgx_is_within_shared_region(const void *addr, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)addr;
+
+    g_region_checks++;
+    return p >= g_region && size <= g_region_size &&
+           (size_t)(p - g_region) <= g_region_size - size;
+}
+
+int sgx_is_within_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 0;
+}
+
+int sgx_is_outside_enclave(const void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return 1;
+}
+
+void* sgx_ecall_arena_alloc(size_t size)
+{
+    g_copies++;
+    return malloc(size);
+}
+
+void sgx_ecall_arena_free(void *ptr)
+{
+    free(ptr);
+}
+
+errno_t memcpy_s(void *dst, size_t dst_size, const void *src, size_t count)
+{
+    g_copies++;
+    if (count > dst_size)
+        return -1;
+    memcpy(dst, src, count);
+    return 0;
+}
+
+static const void *g_seen = NULL;
+static size_t g_calls = 0;
+
+uint32_t ecall_shared_sum(const uint8_t *buf, size_t len)
+{
+    uint32_t sum = 0;
+
+    g_seen = buf;
+    g_calls++;
+    for (size_t i = 0; buf != NULL && i < len; i++)
+        sum += buf[i];
+    return sum;
+}
+
+void ecall_shared_fill(uint32_t *vals, size_t n)
+{
+    g_seen = vals;
+    g_calls++;
+    for (size_t i = 0; i < n; i++)
+        vals[i] = (uint32_t)i;
+}
+
+static sgx_status_t call_sum(const uint8_t *buf, size_t len, uint32_t *sum)
+{
+    ms_ecall_shared_sum_t ms;
+
+    memset(&ms, 0, sizeof(ms));
+    ms.ms_buf = buf;
+    ms.ms_len = len;
+    sgx_status_t status = sgx_ecall_shared_sum(&ms);
+    *sum = ms.ms_retval;
+    return status;
+}
+
+static sgx_status_t call_fill(uint32_t *vals, size_t n)
+{
+    ms_ecall_shared_fill_t ms;
+
+    memset(&ms, 0, sizeof(ms));
+    ms.ms_vals = vals;
+    ms.ms_n = n;
+    return sgx_ecall_shared_fill(&ms);
+}
+
+int main(void)
+{
+    uint32_t sum = 0, expected = 0;
+
+    for (size_t i = 0; i < sizeof(g_memory); i++)
+        g_memory[i] = (uint8_t)i;
+    for (size_t i = 0; i < g_region_size; i++)
+        expected += g_region[i];
+
+    /* the whole region, passed in place */
+    CHECK(call_sum(g_region, g_region_size, &sum) == SGX_SUCCESS);
+    CHECK(g_seen == g_region && sum == expected && g_calls == 1);
+
+    /* and a buffer inside it; the trusted function writes straight through */
+    uint32_t *vals = (uint32_t *)(g_region + 512);
+    CHECK(call_fill(vals, 16) == SGX_SUCCESS);
+    CHECK(g_seen == vals && g_calls == 2);
+    for (size_t i = 0; i < 16; i++)
+        CHECK(vals[i] == i);
+    CHECK(g_copies == 0);
+
+    /* a buffer crossing either end of the region never reaches the
+     * trusted function */
+    CHECK(call_sum(g_region - 1, 16, &sum) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(call_sum(g_region + g_region_size - 15, 16, &sum) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(call_fill((uint32_t *)(g_region + g_region_size - 60), 16) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(call_sum(g_memory, sizeof(g_memory), &sum) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(g_calls == 2);
+
+    /* count * sizeof must not wrap into a small size that passes the check */
+    CHECK(call_fill(vals, SIZE_MAX / sizeof(uint32_t) + 2) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(g_calls == 2);
+
+    /* NULL is passed on like for the other pointer attributes */
+    CHECK(call_sum(NULL, 0, &sum) == SGX_SUCCESS);
+    CHECK(g_seen == NULL && sum == 0 && g_calls == 3);
+
+    CHECK(g_copies == 0);
+    printf("shared_test: %zu region checks, no copies\n", g_region_checks);
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Checks the untrusted proxies generated for switchless_async.edl: each
+ * `_async' proxy must pass sgx_ecall_switchless_async() the same index and
+ * OCALL table as the synchronous proxy, the marshaling structure with its
+ * size, and where the return value goes with its size, and must not touch
+ * the return value itself. Several calls are left outstanding and completed
+ * out of order, after the stack of the proxies is gone.
+ *
+ * The generated switchless_async_u.c is built into this file, the uRTS
+ * functions it calls are replaced by the ones below, which keep a copy of
+ * the marshaling structure and run the trusted function on completion the
+ * way psw/urts/routine.cpp does.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "switchless_async_u.c"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define EID         ((sgx_enclave_id_t)0x1234)
+#define ECALL_ADD   0
+#define ECALL_STORE 1
+#define ECALL_PING  2
+
+struct _sgx_ecall_handle_t
+{
+    int index;
+    void *retval;
+    size_t retval_size;
+    size_t ms_size;
+    int polls;
+    uint8_t ms[64];
+};
+
+static int g_sync_index = -1;
+static const void *g_sync_table = NULL;
+static const void *g_async_table = NULL;
+static uint64_t g_stored = 0;
+static int g_pings = 0;
+
+/* the trusted functions */
+static void run_ecall(int index, void *pms)
+{
+    switch (index) {
+    case ECALL_ADD: {
+        ms_ecall_sl_add_t *ms = (ms_ecall_sl_add_t *)pms;
+        ms->ms_retval = ms->ms_a + ms->ms_b;
+        break;
+    }
+    case ECALL_STORE:
+        g_stored = ((ms_ecall_sl_store_t *)pms)->ms_v;
+        break;
+    case ECALL_PING:
+        CHECK(pms == NULL);
+        g_pings++;
+        break;
+    default:
+        CHECK(!"unknown ECALL");
+    }
+}
+
+sgx_status_t sgx_ecall(const sgx_enclave_id_t eid, const int index,
+                       const void *ocall_table, void *ms)
+{
+    (void)eid;
+    (void)index;
+    (void)ocall_table;
+    (void)ms;
+    CHECK(!"switchless ECALLs never use sgx_ecall()");
+    return SGX_ERROR_UNEXPECTED;
+}
+
+sgx_status_t sgx_ecall_switchless(const sgx_enclave_id_t eid, const int index,
+                                  const void *ocall_table, void *ms)
+{
+    CHECK(eid == EID);
+    g_sync_index = index;
+    g_sync_table = ocall_table;
+    run_ecall(index, ms);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_ecall_switchless_async(const sgx_enclave_id_t eid, const int index,
+                                        const void *ocall_table, const void *ms,
+                                        const size_t ms_size, void *retval,
+                                        const size_t retval_size,
+                                        sgx_ecall_handle_t *handle)
+{
+    CHECK(eid == EID);
+    CHECK(handle != NULL);
+    CHECK((ms == NULL) == (ms_size == 0) && retval_size <= ms_size);
+    CHECK(ms_size <= sizeof(((struct _sgx_ecall_handle_t *)0)->ms));
+
+    sgx_ecall_handle_t h = (sgx_ecall_handle_t)calloc(1, sizeof(*h));
+    CHECK(h != NULL);
+    h->index = index;
+    h->retval = retval;
+    h->retval_size = retval_size;
+    h->ms_size = ms_size;
+    if (ms_size)
+        memcpy(h->ms, ms, ms_size);
+    g_async_table = ocall_table;
+    *handle = h;
+    return SGX_SUCCESS;
+}
+
+static sgx_status_t complete(sgx_ecall_handle_t handle)
+{
+    run_ecall(handle->index, handle->ms_size ? handle->ms : NULL);
+    /* the return value is the first member of the marshaling structure */
+    if (handle->retval)
+        memcpy(handle->retval, handle->ms, handle->retval_size);
+    free(handle);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_ecall_wait(sgx_ecall_handle_t handle)
+{
+    return complete(handle);
+}
+
+/* busy on the first poll of each handle */
+sgx_status_t sgx_ecall_poll(sgx_ecall_handle_t handle)
+{
+    if (handle->polls++ == 0)
+        return SGX_ERROR_BUSY;
+    return complete(handle);
+}
+
+/* overwrites the stack the proxies ran on */
+static __attribute__((noinline)) void clobber_stack(void)
+{
+    volatile uint8_t junk[4096];
+    for (size_t i = 0; i < sizeof(junk); i++)
+        junk[i] = 0xcc;
+}
+
+int main(void)
+{
+    sgx_ecall_handle_t handles[8];
+    int results[8];
+    int retval = 0;
+
+    /* the synchronous proxy, for the index and table to compare with */
+    CHECK(ecall_sl_add(EID, &retval, 2, 3) == SGX_SUCCESS && retval == 5);
+    CHECK(g_sync_index == ECALL_ADD);
+
+    /* outstanding calls keep their own copy of the parameters and only
+     * store the return value when they are completed */
+    for (int i = 0; i < 8; i++) {
+        results[i] = -1;
+        CHECK(ecall_sl_add_async(EID, &handles[i], &results[i], i, 100 * i) == SGX_SUCCESS);
+        CHECK(handles[i]->index == ECALL_ADD && g_async_table == g_sync_table);
+        CHECK(handles[i]->ms_size == sizeof(ms_ecall_sl_add_t));
+        CHECK(handles[i]->retval == &results[i] && handles[i]->retval_size == sizeof(int));
+    }
+    clobber_stack();
+    for (int i = 0; i < 8; i++)
+        CHECK(results[i] == -1);
+    for (int i = 7; i >= 0; i -= 2)
+        CHECK(sgx_ecall_wait(handles[i]) == SGX_SUCCESS && results[i] == 101 * i);
+    for (int i = 0; i < 8; i += 2) {
+        CHECK(sgx_ecall_poll(handles[i]) == SGX_ERROR_BUSY && results[i] == -1);
+        CHECK(sgx_ecall_poll(handles[i]) == SGX_SUCCESS && results[i] == 101 * i);
+    }
+
+    /* no return value: nothing to store */
+    sgx_ecall_handle_t handle = NULL;
+    CHECK(ecall_sl_store_async(EID, &handle, 0x1122334455667788ULL) == SGX_SUCCESS);
+    CHECK(handle->index == ECALL_STORE && handle->retval == NULL && handle->retval_size == 0);
+    CHECK(handle->ms_size == sizeof(ms_ecall_sl_store_t));
+    clobber_stack();
+    CHECK(g_stored == 0);
+    CHECK(sgx_ecall_wait(handle) == SGX_SUCCESS && g_stored == 0x1122334455667788ULL);
+
+    /* neither parameters nor return value: no marshaling structure */
+    CHECK(ecall_sl_ping_async(EID, &handle) == SGX_SUCCESS);
+    CHECK(handle->index == ECALL_PING && handle->ms_size == 0 && handle->retval == NULL);
+    CHECK(sgx_ecall_wait(handle) == SGX_SUCCESS && g_pings == 1);
+
+    printf("switchless_async_test: 10 outstanding ECALLs completed out of order\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "sgx_trts.h"
+#include "sgx_spinlock.h"
+#include "pthread_imp.h"
+#include "util.h"
+
+static volatile uint32_t static_init_lock = SGX_SPINLOCK_INITIALIZER;
+
+int pthread_rwlock_init(pthread_rwlock_t *lockp, const pthread_rwlockattr_t *attr)
+{
+    pthread_rwlock_t lock;
+    UNUSED(attr);
+    if (lockp == NULL)
+        return (EINVAL);
+    lock = (pthread_rwlock_t)calloc(1, sizeof(*lock));
+    if (lock == NULL)
+        return (ENOMEM);
+    sgx_thread_rwlock_init(lock, NULL);
+    *lockp = lock;
+    return 0;
+}
+
+int pthread_rwlock_destroy(pthread_rwlock_t *lockp)
+{
+    if (lockp == NULL)
+        return (EINVAL);
+
+    sgx_thread_rwlock_t *lock = *lockp;
+    if (lock) {
+        int ret = sgx_thread_rwlock_destroy(lock);
+        if (ret != 0)
+            return ret;
+
+        free((void *)(lock));
+        *lockp = NULL;
+    }
+    return 0;
+}
+
+/*
+ * If the lock is statically initialized, perform the dynamic
+ * initialization.
+ */
+static int _rwlock_init_static(pthread_rwlock_t *lockp)
+{
+    int error = 0;
+
+    if (lockp == NULL)
+        return (EINVAL);
+
+    if (*lockp == NULL) {
+        sgx_spin_lock(&static_init_lock);
+        if (*lockp == NULL)
+            error = pthread_rwlock_init(lockp, NULL);
+        sgx_spin_unlock(&static_init_lock);
+        if (error != 0)
+            return (EINVAL);
+    }
+    return 0;
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t *lockp)
+{
+    int error = _rwlock_init_static(lockp);
+    if (error != 0)
+        return error;
+
+    return sgx_thread_rwlock_rdlock(*lockp);
+}
+
+int pthread_rwlock_tryrdlock(pthread_rwlock_t *lockp)
+{
+    int error = _rwlock_init_static(lockp);
+    if (error != 0)
+        return error;
+
+    return sgx_thread_rwlock_tryrdlock(*lockp);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t *lockp)
+{
+    int error = _rwlock_init_static(lockp);
+    if (error != 0)
+        return error;
+
+    return sgx_thread_rwlock_wrlock(*lockp);
+}
+
+int pthread_rwlock_trywrlock(pthread_rwlock_t *lockp)
+{
+    int error = _rwlock_init_static(lockp);
+    if (error != 0)
+        return error;
+
+    return sgx_thread_rwlock_trywrlock(*lockp);
+}
+
+int pthread_rwlock_unlock(pthread_rwlock_t *lockp)
+{
+    if (lockp == NULL)
+        return (EINVAL);
+
+    if (*lockp == NULL)
+        abort();
+
+    return sgx_thread_rwlock_unlock(*lockp);
+}
@@ -315,6 +315,14 @@ int EnclaveCreatorST::trim_accept(uint64_t addr)
     return SGX_SUCCESS;
 }
 
+int EnclaveCreatorST::trim_accept_range(uint64_t fromaddr, uint64_t toaddr)
+{
+    UNUSED(fromaddr);
+    UNUSED(toaddr);
+
+    return SGX_SUCCESS;
+}
+
 int EnclaveCreatorST::remove_range(uint64_t fromaddr, uint64_t numpages)
 {
     UNUSED(fromaddr);
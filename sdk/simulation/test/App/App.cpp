@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Simulation mode tests of the uRTS and tRTS. Every test runs unless test
+ * names are given on the command line. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+
+static const struct
+{
+    const char *name;
+    sim_test_t func;
+} g_tests[] = {
+    { "trace", test_trace },
+    { "timedwait", test_timedwait },
+    { "task", test_task },
+    { "ecall", test_ecall },
+    { "switchless", test_switchless },
+    { "tcs_churn", test_tcs_churn },
+    { "pthread", test_pthread },
+    { "tcs_wait", test_tcs_wait },
+    { "stats", test_stats },
+};
+
+static bool selected(const char *name, int argc, char *argv[])
+{
+    if (argc < 2)
+        return true;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+            return true;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    sgx_enclave_id_t eid = 0;
+    sgx_status_t ret = sgx_create_enclave(ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &eid, NULL);
+    if (ret != SGX_SUCCESS)
+    {
+        fprintf(stderr, "sgx_create_enclave: 0x%x\n", ret);
+        return 1;
+    }
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(g_tests) / sizeof(g_tests[0]); i++)
+    {
+        if (!selected(g_tests[i].name, argc, argv))
+            continue;
+        int rc = g_tests[i].func(eid);
+        printf("%s  %s\n", rc == 0 ? "PASS" : "FAIL", g_tests[i].name);
+        if (rc != 0)
+            failed++;
+    }
+
+    sgx_destroy_enclave(eid);
+    return failed == 0 ? 0 : 1;
+}
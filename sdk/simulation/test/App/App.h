@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _APP_H_
+#define _APP_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sgx_error.h"  /* sgx_status_t */
+#include "sgx_eid.h"    /* sgx_enclave_id_t */
+
+#define ENCLAVE_FILENAME "enclave.signed.so"
+/* the same enclave signed with the bind TCS policy */
+#define BIND_ENCLAVE_FILENAME "enclave_bind.signed.so"
+/* the same enclave with only two TCS */
+#define FEW_TCS_ENCLAVE_FILENAME "enclave_few_tcs.signed.so"
+
+/* Report a failed check and fail the running test */
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        return -1;                                                      \
+    }                                                                   \
+} while (0)
+
+/* A test returns 0 on success. It is given the enclave created by main and
+ * may create more of its own. */
+typedef int (*sim_test_t)(sgx_enclave_id_t eid);
+
+int test_trace(sgx_enclave_id_t eid);
+int test_timedwait(sgx_enclave_id_t eid);
+int test_task(sgx_enclave_id_t eid);
+int test_ecall(sgx_enclave_id_t eid);
+int test_switchless(sgx_enclave_id_t eid);
+int test_tcs_churn(sgx_enclave_id_t eid);
+int test_pthread(sgx_enclave_id_t eid);
+int test_tcs_wait(sgx_enclave_id_t eid);
+int test_stats(sgx_enclave_id_t eid);
+
+#endif /* !_APP_H_ */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* ECALL round trips with an [in] buffer below and above the ECALL arena
+ * threshold of the trusted bridges. Small buffers must land at the same
+ * trusted address every time, which only holds if the arena is rewound
+ * after each ECALL. The times are only printed. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define ECALL_ROUNDS    100000
+#define ARENA_MAX       256     /* SGX_ECALL_ARENA_THRESHOLD */
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int run_rounds(sgx_enclave_id_t eid, const uint8_t *buf, size_t len)
+{
+    uint32_t expected = 0, sum = 0;
+    uint64_t first = 0, last = 0;
+
+    for (size_t i = 0; i < len; i++)
+        expected += buf[i];
+
+    uint64_t start = now_ns();
+    for (int n = 0; n < ECALL_ROUNDS; n++) {
+        CHECK(ecall_arena_sum(eid, &sum, buf, len) == SGX_SUCCESS && sum == expected);
+        if (len <= ARENA_MAX) {
+            CHECK(ecall_arena_last(eid, &last) == SGX_SUCCESS);
+            if (n == 0)
+                first = last;
+            CHECK(last == first);
+        }
+    }
+    uint64_t ns = now_ns() - start;
+
+    printf("  %5zu byte [in] buffer: %8.1f ns per ECALL%s\n", len,
+           (double)ns / ECALL_ROUNDS, len <= ARENA_MAX ? " (2 ECALLs, arena)" : "");
+    return 0;
+}
+
+int test_ecall(sgx_enclave_id_t eid)
+{
+    static uint8_t buf[4096];
+    static const size_t sizes[] = { 16, ARENA_MAX, ARENA_MAX + 1, sizeof(buf) };
+
+    for (size_t i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)i;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (run_rounds(eid, buf, sizes[i]) != 0)
+            return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* sgx_get_enclave_stats() and sgx_get_enclave_ecall_stats() on a fresh
+ * enclave. Checks that:
+ *  - every ECALL and OCALL is counted, with timing disabled as well;
+ *  - the time and the per-index counters only move while timing is
+ *    enabled, the ECALLs land on one index each and the per-index
+ *    counters add up to the totals;
+ *  - a bad ECALL index or enclave id is refused.
+ * The cost of an ECALL with and without timing is printed. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define STATS_PINGS     2000
+#define STATS_OCALLS    100
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct _index_stats_t
+{
+    uint64_t count[SGX_STATS_MAX_ECALLS];
+    uint64_t time_ns[SGX_STATS_MAX_ECALLS];
+} index_stats_t;
+
+static int read_index_stats(sgx_enclave_id_t eid, index_stats_t *stats)
+{
+    for (uint32_t i = 0; i < SGX_STATS_MAX_ECALLS; i++)
+        CHECK(sgx_get_enclave_ecall_stats(eid, i, &stats->count[i], &stats->time_ns[i]) == SGX_SUCCESS);
+    return 0;
+}
+
+static int run_pings(sgx_enclave_id_t eid, uint64_t *ns)
+{
+    int ret = 0;
+    uint64_t start = now_ns();
+    for (int i = 0; i < STATS_PINGS; i++)
+        CHECK(ecall_tcs_ping(eid, &ret) == SGX_SUCCESS && ret == 1);
+    *ns = now_ns() - start;
+    return 0;
+}
+
+static int run_stats(sgx_enclave_id_t eid)
+{
+    sgx_enclave_stats_t before, after;
+    index_stats_t *index = (index_stats_t *)calloc(1, sizeof(index_stats_t));
+    CHECK(index != NULL);
+
+    /* untimed: totals only */
+    uint64_t untimed_ns = 0;
+    CHECK(sgx_enable_ecall_timing(0) == SGX_SUCCESS);
+    CHECK(sgx_get_enclave_stats(eid, &before) == SGX_SUCCESS);
+    CHECK(run_pings(eid, &untimed_ns) == 0);
+    CHECK(ecall_trace(eid, STATS_OCALLS) == SGX_SUCCESS);
+    CHECK(sgx_get_enclave_stats(eid, &after) == SGX_SUCCESS);
+    CHECK(after.ecall_count - before.ecall_count == STATS_PINGS + 1);
+    CHECK(after.ocall_count - before.ocall_count == STATS_OCALLS);
+    CHECK(after.ecall_time_ns == before.ecall_time_ns);
+    CHECK(read_index_stats(eid, index) == 0);
+    for (uint32_t i = 0; i < SGX_STATS_MAX_ECALLS; i++)
+        CHECK(index->count[i] == 0 && index->time_ns[i] == 0);
+
+    /* timed: the same calls show up per index too */
+    uint64_t timed_ns = 0;
+    CHECK(sgx_enable_ecall_timing(1) == SGX_SUCCESS);
+    before = after;
+    CHECK(run_pings(eid, &timed_ns) == 0);
+    CHECK(ecall_trace(eid, STATS_OCALLS) == SGX_SUCCESS);
+    CHECK(sgx_get_enclave_stats(eid, &after) == SGX_SUCCESS);
+    CHECK(sgx_enable_ecall_timing(0) == SGX_SUCCESS);
+    CHECK(after.ecall_count - before.ecall_count == STATS_PINGS + 1);
+    CHECK(after.ocall_count - before.ocall_count == STATS_OCALLS);
+    CHECK(after.ecall_time_ns > before.ecall_time_ns);
+
+    CHECK(read_index_stats(eid, index) == 0);
+    uint64_t count = 0, time_ns = 0;
+    int ping_indexes = 0, trace_indexes = 0;
+    for (uint32_t i = 0; i < SGX_STATS_MAX_ECALLS; i++) {
+        count += index->count[i];
+        time_ns += index->time_ns[i];
+        ping_indexes += index->count[i] == STATS_PINGS;
+        trace_indexes += index->count[i] == 1;
+    }
+    CHECK(count == STATS_PINGS + 1);
+    CHECK(time_ns == after.ecall_time_ns - before.ecall_time_ns);
+    CHECK(ping_indexes == 1 && trace_indexes == 1);
+
+    uint64_t dummy = 0;
+    CHECK(sgx_get_enclave_ecall_stats(eid, SGX_STATS_MAX_ECALLS, &dummy, &dummy) == SGX_ERROR_INVALID_PARAMETER);
+    free(index);
+
+    printf("  %d ECALLs: %6.2f us each untimed, %6.2f us timed, %8.1f ns inside on average\n",
+           STATS_PINGS, (double)untimed_ns / 1000 / STATS_PINGS, (double)timed_ns / 1000 / STATS_PINGS,
+           (double)time_ns / (double)count);
+    return 0;
+}
+
+int test_stats(sgx_enclave_id_t eid)
+{
+    sgx_enclave_stats_t stats;
+    sgx_enclave_id_t stats_eid = 0;
+    CHECK(sgx_create_enclave(ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &stats_eid, NULL) == SGX_SUCCESS);
+
+    int ret = run_stats(stats_eid);
+    sgx_enable_ecall_timing(0);
+    sgx_destroy_enclave(stats_eid);
+    if (ret != 0)
+        return ret;
+
+    CHECK(sgx_get_enclave_stats(stats_eid, &stats) == SGX_ERROR_INVALID_ENCLAVE_ID);
+    CHECK(sgx_get_enclave_stats(eid, NULL) == SGX_ERROR_INVALID_PARAMETER);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Switchless ECALLs and OCALLs in simulation mode, on an enclave of its own
+ * created with one trusted and one untrusted worker. Every call must return
+ * the right result whether a worker took it or it fell back to a regular
+ * transition, and sgx_get_switchless_call_stats must account for each of
+ * them. The times are only printed. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "sgx_urts.h"
+#include "sgx_uswitchless.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define SL_ROUNDS       10000
+#define SL_RETRIES      100000  /* workers share a CPU with the callers here */
+
+static uint64_t g_ocalls = 0;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t ocall_sl_add(uint64_t a, uint64_t b)
+{
+    __atomic_add_fetch(&g_ocalls, 1, __ATOMIC_RELAXED);
+    return a + b;
+}
+
+static uint64_t hist_count(const uint64_t *hist)
+{
+    uint64_t count = 0;
+    for (int i = 0; i < SGX_USWITCHLESS_HIST_BUCKETS; i++)
+        count += hist[i];
+    return count;
+}
+
+/* The function indexes come from the generated bridges, so the stats of all
+ * of them are added up. Only ecall_sl_add and ocall_sl_add are switchless. */
+static int total_stats(sgx_enclave_id_t eid, sgx_uswitchless_call_type_t type,
+                       sgx_uswitchless_call_stats_t *total)
+{
+    memset(total, 0, sizeof(*total));
+    for (uint32_t func = 0; func < SGX_USWITCHLESS_STATS_MAX_FUNCS; func++) {
+        sgx_uswitchless_call_stats_t stats;
+        CHECK(sgx_get_switchless_call_stats(eid, type, func, &stats) == SGX_SUCCESS);
+        total->calls += stats.calls;
+        total->fallbacks += stats.fallbacks;
+        for (int i = 0; i < SGX_USWITCHLESS_HIST_BUCKETS; i++) {
+            total->queue_wait_hist[i] += stats.queue_wait_hist[i];
+            total->exec_hist[i] += stats.exec_hist[i];
+        }
+    }
+    return 0;
+}
+
+static int check_stats(sgx_enclave_id_t eid)
+{
+    sgx_uswitchless_call_stats_t ecalls, ocalls;
+    CHECK(total_stats(eid, SGX_USWITCHLESS_CALL_ECALL, &ecalls) == 0);
+    CHECK(total_stats(eid, SGX_USWITCHLESS_CALL_OCALL, &ocalls) == 0);
+
+    CHECK(ecalls.calls == SL_ROUNDS && ecalls.fallbacks <= ecalls.calls);
+    CHECK(ocalls.calls == SL_ROUNDS && ocalls.fallbacks <= ocalls.calls);
+
+    /* the untrusted worker times every OCALL it accepts, a switchless ECALL
+     * is only timed when its caller sees the acceptance */
+    CHECK(hist_count(ocalls.exec_hist) == ocalls.calls - ocalls.fallbacks);
+    CHECK(hist_count(ocalls.queue_wait_hist) == 0);
+    CHECK(hist_count(ecalls.exec_hist) <= ecalls.calls - ecalls.fallbacks);
+    CHECK(hist_count(ecalls.queue_wait_hist) == hist_count(ecalls.exec_hist));
+
+    sgx_uswitchless_call_stats_t stats;
+    CHECK(sgx_get_switchless_call_stats(eid, SGX_USWITCHLESS_CALL_ECALL,
+                                        SGX_USWITCHLESS_STATS_MAX_FUNCS, &stats) == SGX_ERROR_INVALID_PARAMETER);
+
+    printf("  ECALLs: %llu, %llu fell back, %llu timed; OCALLs: %llu, %llu fell back\n",
+           (unsigned long long)ecalls.calls, (unsigned long long)ecalls.fallbacks,
+           (unsigned long long)hist_count(ecalls.exec_hist),
+           (unsigned long long)ocalls.calls, (unsigned long long)ocalls.fallbacks);
+    return 0;
+}
+
+static int run_calls(sgx_enclave_id_t eid)
+{
+    uint64_t sum = 0;
+
+    uint64_t start = now_ns();
+    for (uint64_t n = 0; n < SL_ROUNDS; n++) {
+        CHECK(ecall_sl_add(eid, &sum, n, 3) == SGX_SUCCESS);
+        CHECK(sum == n + 3);
+    }
+    uint64_t ecall_ns = now_ns() - start;
+
+    /* the enclave checks every OCALL result and returns their sum */
+    start = now_ns();
+    CHECK(ecall_sl_ocalls(eid, &sum, SL_ROUNDS) == SGX_SUCCESS);
+    uint64_t ocall_ns = now_ns() - start;
+    CHECK(sum == (uint64_t)SL_ROUNDS * (SL_ROUNDS - 1) / 2 + SL_ROUNDS);
+    CHECK(g_ocalls == SL_ROUNDS);
+
+    printf("  switchless ECALL: %8.1f ns, OCALL: %8.1f ns\n",
+           (double)ecall_ns / SL_ROUNDS, (double)ocall_ns / SL_ROUNDS);
+    return check_stats(eid);
+}
+
+int test_switchless(sgx_enclave_id_t main_eid)
+{
+    /* main's enclave was created without switchless support */
+    sgx_uswitchless_call_stats_t stats;
+    CHECK(sgx_get_switchless_call_stats(main_eid, SGX_USWITCHLESS_CALL_ECALL, 0, &stats) ==
+          SGX_ERROR_FEATURE_NOT_SUPPORTED);
+
+    sgx_uswitchless_config_t us_config = SGX_USWITCHLESS_CONFIG_INITIALIZER;
+    us_config.num_uworkers = 1;
+    us_config.num_tworkers = 1;
+    us_config.retries_before_fallback = SL_RETRIES;
+
+    const void *enclave_ex_p[32] = { 0 };
+    enclave_ex_p[SGX_CREATE_ENCLAVE_EX_SWITCHLESS_BIT_IDX] = (const void *)&us_config;
+
+    sgx_enclave_id_t eid = 0;
+    CHECK(sgx_create_enclave_ex(ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &eid, NULL,
+                                SGX_CREATE_ENCLAVE_EX_SWITCHLESS, enclave_ex_p) == SGX_SUCCESS);
+
+    g_ocalls = 0;
+    int ret = -1;
+    if (sgx_enable_switchless_call_timing(eid, 1) == SGX_SUCCESS)
+        ret = run_calls(eid);
+    else
+        fprintf(stderr, "%s:%d: sgx_enable_switchless_call_timing failed\n", __FILE__, __LINE__);
+    sgx_destroy_enclave(eid);
+    return ret;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Parallel-for and fork/join benchmarks of the task runtime, with worker
+ * threads donated by ECALLs. The results are checked, the times are only
+ * printed. */
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define TASK_WORKERS    4       /* TCSNum leaves room for them and main */
+#define FOR_ITEMS       (1 << 24)
+#define FOR_GRAIN       4096
+#define FIB_N           30
+#define FIB_RESULT      832040
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct _worker_arg_t
+{
+    sgx_enclave_id_t eid;
+    int ret;
+} worker_arg_t;
+
+static void *worker_thread(void *p)
+{
+    worker_arg_t *arg = (worker_arg_t *)p;
+    if (ecall_task_worker(arg->eid, &arg->ret) != SGX_SUCCESS)
+        arg->ret = -1;
+    return NULL;
+}
+
+static int run_benchmarks(sgx_enclave_id_t eid, unsigned int workers)
+{
+    pthread_t threads[TASK_WORKERS];
+    worker_arg_t args[TASK_WORKERS];
+    int ret = -1;
+
+    CHECK(ecall_task_init(eid, &ret) == SGX_SUCCESS && ret == 0);
+    for (unsigned int i = 0; i < workers; i++) {
+        args[i].eid = eid;
+        args[i].ret = -1;
+        CHECK(pthread_create(&threads[i], NULL, worker_thread, &args[i]) == 0);
+    }
+
+    uint64_t sum = 0, fib = 0;
+    uint64_t start = now_ns();
+    sgx_status_t for_status = ecall_task_parallel_for(eid, &sum, FOR_ITEMS, FOR_GRAIN);
+    uint64_t for_ns = now_ns() - start;
+    start = now_ns();
+    sgx_status_t fib_status = ecall_task_fib(eid, &fib, FIB_N);
+    uint64_t fib_ns = now_ns() - start;
+
+    CHECK(ecall_task_shutdown(eid, &ret) == SGX_SUCCESS && ret == 0);
+    for (unsigned int i = 0; i < workers; i++) {
+        CHECK(pthread_join(threads[i], NULL) == 0);
+        /* a worker that came in after the shutdown is turned away */
+        CHECK(args[i].ret == 0 || args[i].ret == ECANCELED);
+    }
+
+    CHECK(for_status == SGX_SUCCESS && sum == (uint64_t)FOR_ITEMS * (FOR_ITEMS - 1) / 2);
+    CHECK(fib_status == SGX_SUCCESS && fib == FIB_RESULT);
+    printf("  %u workers: parallel_for %8.3f ms, fork/join fib(%d) %8.3f ms\n",
+           workers, (double)for_ns / 1e6, FIB_N, (double)fib_ns / 1e6);
+    return 0;
+}
+
+int test_task(sgx_enclave_id_t eid)
+{
+    for (unsigned int workers = 0; workers <= TASK_WORKERS; workers = workers ? workers * 2 : 1) {
+        if (run_benchmarks(eid, workers) != 0)
+            return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Thread create/ECALL/exit churn on an enclave with the bind TCS policy and
+ * on the unbind enclave created by main. Each round starts as many threads
+ * as the bind enclave has TCS, so every round after the first only gets a
+ * TCS if the exited threads of the previous round gave theirs back. The
+ * times are only printed. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define CHURN_THREADS   4       /* TCSNum of Enclave_bind.config.xml */
+#define CHURN_ROUNDS    250
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct _churn_arg_t
+{
+    sgx_enclave_id_t eid;
+    sgx_status_t status;
+    int ret;
+} churn_arg_t;
+
+static void *churn_thread(void *p)
+{
+    churn_arg_t *arg = (churn_arg_t *)p;
+    arg->status = ecall_tcs_ping(arg->eid, &arg->ret);
+    return NULL;
+}
+
+static int run_churn(sgx_enclave_id_t eid, const char *policy)
+{
+    pthread_t threads[CHURN_THREADS];
+    churn_arg_t args[CHURN_THREADS];
+
+    uint64_t start = now_ns();
+    for (int round = 0; round < CHURN_ROUNDS; round++) {
+        for (int i = 0; i < CHURN_THREADS; i++) {
+            args[i].eid = eid;
+            args[i].status = SGX_ERROR_UNEXPECTED;
+            args[i].ret = 0;
+            CHECK(pthread_create(&threads[i], NULL, churn_thread, &args[i]) == 0);
+        }
+        for (int i = 0; i < CHURN_THREADS; i++) {
+            CHECK(pthread_join(threads[i], NULL) == 0);
+            CHECK(args[i].status == SGX_SUCCESS && args[i].ret == 1);
+        }
+    }
+    uint64_t ns = now_ns() - start;
+
+    printf("  %-6s TCS policy: %8.1f us per thread create, ECALL and join\n", policy,
+           (double)ns / 1000 / (CHURN_ROUNDS * CHURN_THREADS));
+    return 0;
+}
+
+int test_tcs_churn(sgx_enclave_id_t eid)
+{
+    sgx_enclave_id_t bind_eid = 0;
+    CHECK(sgx_create_enclave(BIND_ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &bind_eid, NULL) == SGX_SUCCESS);
+
+    int ret = run_churn(bind_eid, "bind");
+    sgx_destroy_enclave(bind_eid);
+    if (ret != 0)
+        return ret;
+    return run_churn(eid, "unbind");
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* sgx_set_tcs_wait() on an enclave with two TCS. Both are kept busy by
+ * ECALLs parked in an OCALL, then checks that:
+ *  - without a wait timeout the next ECALL fails with SGX_ERROR_OUT_OF_TCS
+ *    right away, and with one it fails only once the timeout expired;
+ *  - with SGX_TCS_WAIT_INFINITE queued ECALLs get a TCS in the order they
+ *    arrived, as the TCSs are given back one at a time.
+ * The time from a TCS given back to the next waiter entering is printed. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define WAIT_TCS        2       /* TCSNum of Enclave_few_tcs.config.xml */
+#define WAIT_WAITERS    6
+#define WAIT_TIMEOUT_MS 50
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static pthread_mutex_t g_hold_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_hold_cond = PTHREAD_COND_INITIALIZER;
+static int g_entered[WAIT_TCS + WAIT_WAITERS];
+static int g_entered_count = 0;
+static int g_permits = 0;
+
+void ocall_tcs_hold(int id)
+{
+    pthread_mutex_lock(&g_hold_mutex);
+    g_entered[g_entered_count++] = id;
+    pthread_cond_broadcast(&g_hold_cond);
+    while (g_permits == 0)
+        pthread_cond_wait(&g_hold_cond, &g_hold_mutex);
+    g_permits--;
+    pthread_mutex_unlock(&g_hold_mutex);
+}
+
+static void release_one()
+{
+    pthread_mutex_lock(&g_hold_mutex);
+    g_permits++;
+    pthread_cond_broadcast(&g_hold_cond);
+    pthread_mutex_unlock(&g_hold_mutex);
+}
+
+/* returns 0 once 'count' ECALLs have entered, -1 after 5 seconds */
+static int wait_entered(int count)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+
+    int ret = 0;
+    pthread_mutex_lock(&g_hold_mutex);
+    while (g_entered_count < count && ret == 0)
+        ret = pthread_cond_timedwait(&g_hold_cond, &g_hold_mutex, &deadline);
+    ret = g_entered_count >= count ? 0 : -1;
+    pthread_mutex_unlock(&g_hold_mutex);
+    return ret;
+}
+
+typedef struct _hold_arg_t
+{
+    sgx_enclave_id_t eid;
+    int id;
+    sgx_status_t status;
+    int ret;
+} hold_arg_t;
+
+static void *hold_thread(void *p)
+{
+    hold_arg_t *arg = (hold_arg_t *)p;
+    arg->status = ecall_tcs_hold(arg->eid, &arg->ret, arg->id);
+    return NULL;
+}
+
+static int run_tcs_wait(sgx_enclave_id_t eid)
+{
+    pthread_t threads[WAIT_TCS + WAIT_WAITERS];
+    hold_arg_t args[WAIT_TCS + WAIT_WAITERS];
+    int ret = 0;
+
+    /* the holders take every TCS */
+    for (int i = 0; i < WAIT_TCS; i++) {
+        args[i].eid = eid;
+        args[i].id = 100 + i;
+        CHECK(pthread_create(&threads[i], NULL, hold_thread, &args[i]) == 0);
+    }
+    CHECK(wait_entered(WAIT_TCS) == 0);
+
+    CHECK(ecall_tcs_ping(eid, &ret) == SGX_ERROR_OUT_OF_TCS);
+
+    CHECK(sgx_set_tcs_wait(eid, WAIT_TIMEOUT_MS) == SGX_SUCCESS);
+    uint64_t start = now_ns();
+    CHECK(ecall_tcs_ping(eid, &ret) == SGX_ERROR_OUT_OF_TCS);
+    CHECK(now_ns() - start >= (WAIT_TIMEOUT_MS - 5) * 1000000ULL);
+
+    /* queue the waiters one after the other */
+    CHECK(sgx_set_tcs_wait(eid, SGX_TCS_WAIT_INFINITE) == SGX_SUCCESS);
+    for (int i = WAIT_TCS; i < WAIT_TCS + WAIT_WAITERS; i++) {
+        args[i].eid = eid;
+        args[i].id = i - WAIT_TCS;
+        CHECK(pthread_create(&threads[i], NULL, hold_thread, &args[i]) == 0);
+        usleep(20000);
+    }
+    CHECK(g_entered_count == WAIT_TCS);
+
+    /* hand the TCSs over one at a time */
+    uint64_t handover_ns = 0;
+    for (int i = WAIT_TCS; i < WAIT_TCS + WAIT_WAITERS; i++) {
+        start = now_ns();
+        release_one();
+        CHECK(wait_entered(i + 1) == 0);
+        handover_ns += now_ns() - start;
+    }
+    for (int i = 0; i < WAIT_TCS; i++)
+        release_one();
+
+    for (int i = 0; i < WAIT_TCS + WAIT_WAITERS; i++) {
+        CHECK(pthread_join(threads[i], NULL) == 0);
+        CHECK(args[i].status == SGX_SUCCESS && args[i].ret == 1);
+    }
+    for (int i = WAIT_TCS; i < WAIT_TCS + WAIT_WAITERS; i++)
+        CHECK(g_entered[i] == i - WAIT_TCS);
+
+    printf("  %d waiters on %d TCS served in arrival order, %8.1f us per hand over\n",
+           WAIT_WAITERS, WAIT_TCS, (double)handover_ns / 1000 / WAIT_WAITERS);
+    return 0;
+}
+
+int test_tcs_wait(sgx_enclave_id_t eid)
+{
+    (void)eid;
+    sgx_enclave_id_t few_eid = 0;
+    CHECK(sgx_create_enclave(FEW_TCS_ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &few_eid, NULL) == SGX_SUCCESS);
+
+    int ret = run_tcs_wait(few_eid);
+    sgx_destroy_enclave(few_eid);
+    return ret;
+}
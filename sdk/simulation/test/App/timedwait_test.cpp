@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* sgx_thread_mutex_timedlock and sgx_thread_cond_timedwait time out on a
+ * held mutex and an unsignaled condition, and return as soon as the mutex
+ * is released or the condition is signaled. */
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define SHORT_TIMEOUT_US    20000
+#define LONG_TIMEOUT_US     5000000
+
+static uint64_t now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+typedef struct _timed_arg_t
+{
+    sgx_enclave_id_t eid;
+    int ret;
+    uint64_t elapsed_us;
+} timed_arg_t;
+
+static void *hold_thread(void *p)
+{
+    timed_arg_t *arg = (timed_arg_t *)p;
+    arg->ret = ecall_timed_hold(arg->eid) == SGX_SUCCESS ? 0 : -1;
+    return NULL;
+}
+
+static void *wait_thread(void *p)
+{
+    timed_arg_t *arg = (timed_arg_t *)p;
+    uint64_t start = now_us();
+    if (ecall_timed_cond_wait(arg->eid, &arg->ret, LONG_TIMEOUT_US) != SGX_SUCCESS)
+        arg->ret = -1;
+    arg->elapsed_us = now_us() - start;
+    return NULL;
+}
+
+/* Poll an enclave flag set by another thread */
+static int wait_for(sgx_enclave_id_t eid, sgx_status_t (*flag)(sgx_enclave_id_t, int *))
+{
+    uint64_t start = now_us();
+    int set = 0;
+    while (flag(eid, &set) == SGX_SUCCESS && !set && now_us() - start < LONG_TIMEOUT_US)
+        sched_yield();
+    return set;
+}
+
+int test_timedwait(sgx_enclave_id_t eid)
+{
+    int ret = 0;
+    uint64_t start = 0, elapsed_us = 0;
+
+    /* no signal, the wait times out with the mutex held again */
+    start = now_us();
+    CHECK(ecall_timed_cond_wait(eid, &ret, SHORT_TIMEOUT_US) == SGX_SUCCESS);
+    elapsed_us = now_us() - start;
+    CHECK(ret == ETIMEDOUT);
+    CHECK(elapsed_us >= SHORT_TIMEOUT_US && elapsed_us < LONG_TIMEOUT_US);
+
+    /* a free mutex is taken at once */
+    CHECK(ecall_timed_mutex_lock(eid, &ret, 0) == SGX_SUCCESS);
+    CHECK(ret == 0);
+
+    /* a held mutex times out, and is taken once released */
+    timed_arg_t holder = { eid, 0, 0 };
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, hold_thread, &holder) == 0);
+    CHECK(wait_for(eid, ecall_timed_is_held));
+    start = now_us();
+    CHECK(ecall_timed_mutex_lock(eid, &ret, SHORT_TIMEOUT_US) == SGX_SUCCESS);
+    elapsed_us = now_us() - start;
+    CHECK(ecall_timed_release(eid) == SGX_SUCCESS);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(holder.ret == 0);
+    CHECK(ret == ETIMEDOUT);
+    CHECK(elapsed_us >= SHORT_TIMEOUT_US && elapsed_us < LONG_TIMEOUT_US);
+    CHECK(ecall_timed_mutex_lock(eid, &ret, LONG_TIMEOUT_US) == SGX_SUCCESS);
+    CHECK(ret == 0);
+
+    /* a signal ends the wait long before the timeout */
+    timed_arg_t waiter = { eid, 0, 0 };
+    CHECK(pthread_create(&thread, NULL, wait_thread, &waiter) == 0);
+    CHECK(wait_for(eid, ecall_timed_is_waiting));
+    CHECK(ecall_timed_cond_signal(eid) == SGX_SUCCESS);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(waiter.ret == 0);
+    CHECK(waiter.elapsed_us < LONG_TIMEOUT_US);
+
+    printf("  timed out after %llu us\n", (unsigned long long)elapsed_us);
+    return 0;
+}
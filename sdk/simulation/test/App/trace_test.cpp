@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* The run target starts the tests with SGX_URTS_TRACE set. ECALLs that make
+ * one OCALL each are run from a thread of their own, SIGUSR2 writes the trace
+ * and the events of that thread are read back and checked for nesting. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "sgx_urts.h"
+#include "App.h"
+#include "Enclave_u.h"
+
+#define TRACE_ECALLS    100
+
+void ocall_trace(void)
+{
+}
+
+typedef struct _trace_arg_t
+{
+    sgx_enclave_id_t eid;
+    long tid;
+    int failed;
+} trace_arg_t;
+
+static void *trace_thread(void *p)
+{
+    trace_arg_t *arg = (trace_arg_t *)p;
+    arg->tid = syscall(SYS_gettid);
+    for (int i = 0; i < TRACE_ECALLS; i++)
+    {
+        if (ecall_trace(arg->eid, 1) != SGX_SUCCESS)
+            arg->failed++;
+    }
+    return NULL;
+}
+
+int test_trace(sgx_enclave_id_t eid)
+{
+    const char *file = getenv("SGX_URTS_TRACE");
+    CHECK(file != NULL && *file != '\0');
+
+    trace_arg_t arg = { eid, 0, 0 };
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, trace_thread, &arg) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(arg.failed == 0);
+
+    unlink(file);
+    CHECK(raise(SIGUSR2) == 0);
+
+    FILE *fp = fopen(file, "r");
+    CHECK(fp != NULL);
+    char line[256];
+    CHECK(fgets(line, sizeof(line), fp) != NULL);
+    CHECK(strncmp(line, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) == 0);
+
+    /* one event per line, ecall and ocall alternately nested */
+    int ecalls = 0, ocalls = 0, depth = 0;
+    bool closed = false, malformed = false;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (strcmp(line, "]}\n") == 0)
+        {
+            closed = true;
+            break;
+        }
+        char cat[8], ph[2];
+        int index = 0;
+        long pid = 0, tid = 0;
+        double ts = 0;
+        if (sscanf(line, "{\"name\":\"%*[a-z] %d\",\"cat\":\"%7[a-z]\",\"ph\":\"%1[BE]\",\"ts\":%lf,\"pid\":%ld,\"tid\":%ld}",
+                   &index, cat, ph, &ts, &pid, &tid) != 6)
+        {
+            malformed = true;
+            break;
+        }
+        /* skip other threads and ECMD_* ECALLs of the runtime */
+        if (tid != arg.tid || index < 0)
+            continue;
+        bool is_ecall = strcmp(cat, "ecall") == 0;
+        if (ph[0] == 'B')
+        {
+            if (depth != (is_ecall ? 0 : 1))
+                break;
+            depth++;
+            is_ecall ? ecalls++ : ocalls++;
+        }
+        else
+        {
+            if (depth != (is_ecall ? 1 : 2))
+                break;
+            depth--;
+        }
+    }
+    fclose(fp);
+
+    CHECK(!malformed);
+    CHECK(closed);
+    CHECK(depth == 0);
+    CHECK(ecalls == TRACE_ECALLS);
+    CHECK(ocalls == TRACE_ECALLS);
+    return 0;
+}
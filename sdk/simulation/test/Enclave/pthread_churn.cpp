@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pthread.h>
+
+#include "Enclave_t.h"
+
+#define PTHREAD_MAX_HOST_THREADS    64
+
+static void *pthread_churn_body(void *arg)
+{
+    if (ocall_pthread_host_tid((uint64_t *)arg) != SGX_SUCCESS)
+        *(uint64_t *)arg = 0;
+    return NULL;
+}
+
+/* Creates and joins 'rounds' threads one after the other. Returns the
+ * number of different host threads that ran them, -1 on failure. */
+int ecall_pthread_churn(int rounds)
+{
+    uint64_t seen[PTHREAD_MAX_HOST_THREADS];
+    int distinct = 0;
+
+    for (int round = 0; round < rounds; round++) {
+        pthread_t thread;
+        uint64_t tid = 0;
+        if (pthread_create(&thread, NULL, pthread_churn_body, &tid) != 0)
+            return -1;
+        if (pthread_join(thread, NULL) != 0 || tid == 0)
+            return -1;
+
+        int i = 0;
+        while (i < distinct && seen[i] != tid)
+            i++;
+        if (i == distinct) {
+            if (distinct == PTHREAD_MAX_HOST_THREADS)
+                return -1;
+            seen[distinct++] = tid;
+        }
+    }
+    return distinct;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include "sgx_task.h"
+#include "Enclave_t.h"
+
+#define FIB_CUTOFF  10
+
+int ecall_task_init(void)
+{
+    return sgx_task_runtime_init(0);
+}
+
+/* Returns once ecall_task_shutdown() is called */
+int ecall_task_worker(void)
+{
+    return sgx_task_worker_run();
+}
+
+int ecall_task_shutdown(void)
+{
+    return sgx_task_runtime_shutdown();
+}
+
+static void sum_body(size_t begin, size_t end, void *arg)
+{
+    uint64_t sum = 0;
+    for (size_t i = begin; i < end; i++)
+        sum += i;
+    __atomic_add_fetch((uint64_t *)arg, sum, __ATOMIC_RELAXED);
+}
+
+/* Sum of 0 to items - 1 */
+uint64_t ecall_task_parallel_for(size_t items, size_t grain)
+{
+    uint64_t sum = 0;
+    if (sgx_task_parallel_for(0, items, grain, sum_body, &sum) != 0)
+        return 0;
+    return sum;
+}
+
+typedef struct _fib_t
+{
+    unsigned int n;
+    uint64_t result;
+} fib_t;
+
+static uint64_t fib_serial(unsigned int n)
+{
+    return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+static void fib_task(void *arg)
+{
+    fib_t *fib = (fib_t *)arg;
+    if (fib->n < FIB_CUTOFF) {
+        fib->result = fib_serial(fib->n);
+        return;
+    }
+    sgx_task_group_t group = SGX_TASK_GROUP_INITIALIZER;
+    fib_t left = {fib->n - 1, 0}, right = {fib->n - 2, 0};
+    sgx_task_spawn(&group, fib_task, &left);
+    fib_task(&right);
+    sgx_task_group_wait(&group);
+    fib->result = left.result + right.result;
+}
+
+uint64_t ecall_task_fib(unsigned int n)
+{
+    fib_t fib = {n, 0};
+    fib_task(&fib);
+    return fib.result;
+}
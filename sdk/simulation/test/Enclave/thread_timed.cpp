@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "sgx_thread.h"
+#include "Enclave_t.h"
+
+static sgx_thread_mutex_t g_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+static sgx_thread_cond_t g_cond = SGX_THREAD_COND_INITIALIZER;
+static volatile int g_held = 0;
+static volatile int g_release = 0;
+static volatile int g_waiting = 0;
+
+/* Hold g_mutex until ecall_timed_release() */
+void ecall_timed_hold(void)
+{
+    sgx_thread_mutex_lock(&g_mutex);
+    g_release = 0;
+    g_held = 1;
+    while (!g_release)
+        __asm__ __volatile__ ("pause" : : : "memory");
+    g_held = 0;
+    sgx_thread_mutex_unlock(&g_mutex);
+}
+
+int ecall_timed_is_held(void)
+{
+    return g_held;
+}
+
+void ecall_timed_release(void)
+{
+    g_release = 1;
+}
+
+int ecall_timed_mutex_lock(uint64_t timeout_us)
+{
+    int ret = sgx_thread_mutex_timedlock(&g_mutex, timeout_us);
+    if (ret == 0)
+        sgx_thread_mutex_unlock(&g_mutex);
+    return ret;
+}
+
+/* Returns the result of the wait, or -1 if the mutex was not held after it */
+int ecall_timed_cond_wait(uint64_t timeout_us)
+{
+    sgx_thread_mutex_lock(&g_mutex);
+    g_waiting = 1;
+    int ret = sgx_thread_cond_timedwait(&g_cond, &g_mutex, timeout_us);
+    g_waiting = 0;
+    if (sgx_thread_mutex_unlock(&g_mutex) != 0)
+        return -1;
+    return ret;
+}
+
+int ecall_timed_is_waiting(void)
+{
+    return g_waiting;
+}
+
+/* The waiter is queued on g_cond once it set g_waiting and released g_mutex */
+void ecall_timed_cond_signal(void)
+{
+    sgx_thread_mutex_lock(&g_mutex);
+    sgx_thread_cond_signal(&g_cond);
+    sgx_thread_mutex_unlock(&g_mutex);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// sim_transition.cpp -- emulates the cost of EENTER/EEXIT in simulation mode.
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "se_trace.h"
+#include "sim_transition.h"
+
+#define SIM_TRANSITION_CYCLES_ENV   "SGX_SIM_TRANSITION_CYCLES"
+#define SIM_TRANSITION_FLUSH_ENV    "SGX_SIM_TRANSITION_FLUSH_KB"
+#define SIM_FLUSH_MAX_KB            (64 * 1024)
+#define SIM_CACHE_LINE_SIZE         64
+
+int g_sim_transition_enabled = 0;
+
+static uint64_t g_transition_cycles = 0;
+static size_t g_flush_size = 0;
+static __thread uint8_t *t_flush_buf = NULL;
+static pthread_key_t g_flush_key;
+
+static inline uint64_t read_tsc()
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint64_t get_env_u64(const char *name)
+{
+    const char *str = getenv(name);
+    if (str == NULL || *str == '\0')
+        return 0;
+
+    char *end = NULL;
+    unsigned long long value = strtoull(str, &end, 0);
+    if (*end != '\0')
+    {
+        SE_TRACE(SE_TRACE_WARNING, "ignoring invalid %s=%s\n", name, str);
+        return 0;
+    }
+    return (uint64_t)value;
+}
+
+__attribute__((constructor)) static void sim_transition_init()
+{
+    g_transition_cycles = get_env_u64(SIM_TRANSITION_CYCLES_ENV);
+
+    uint64_t flush_kb = get_env_u64(SIM_TRANSITION_FLUSH_ENV);
+    if (flush_kb > SIM_FLUSH_MAX_KB)
+        flush_kb = SIM_FLUSH_MAX_KB;
+    g_flush_size = (size_t)flush_kb * 1024;
+    // the key frees the buffer of an exiting thread
+    if (g_flush_size != 0 && pthread_key_create(&g_flush_key, free) != 0)
+        g_flush_size = 0;
+
+    g_sim_transition_enabled = (g_transition_cycles != 0 || g_flush_size != 0);
+}
+
+void sim_transition_cost_slow(void)
+{
+    uint64_t start = read_tsc();
+
+    if (g_flush_size != 0)
+    {
+        if (t_flush_buf == NULL && (t_flush_buf = (uint8_t *)malloc(g_flush_size)) != NULL)
+            pthread_setspecific(g_flush_key, t_flush_buf);
+        if (t_flush_buf != NULL)
+        {
+            volatile uint8_t *buf = t_flush_buf;
+            for (size_t off = 0; off < g_flush_size; off += SIM_CACHE_LINE_SIZE)
+                buf[off]++;
+        }
+    }
+
+    while (read_tsc() - start < g_transition_cycles)
+        __builtin_ia32_pause();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _SIM_TRANSITION_H_
+#define _SIM_TRANSITION_H_
+
+/* Optional emulation of the cost of enclave transitions in simulation mode,
+ * where EENTER and EEXIT are plain jumps. Configured by the environment:
+ *
+ *   SGX_SIM_TRANSITION_CYCLES=<n>      spin <n> TSC cycles per EENTER/EEXIT
+ *   SGX_SIM_TRANSITION_FLUSH_KB=<n>    write <n> KB of a per-thread buffer per
+ *                                      transition, evicting the caches and data
+ *                                      TLB entries a real transition would flush
+ *
+ * Both are off by default.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int g_sim_transition_enabled;
+
+void sim_transition_cost_slow(void);
+
+static inline void sim_transition_cost(void)
+{
+    if (__builtin_expect(g_sim_transition_enabled, 0))
+        sim_transition_cost_slow();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
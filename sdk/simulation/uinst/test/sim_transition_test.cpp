@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Runs sim_transition.cpp on the host, once per SGX_SIM_TRANSITION_*
+ * setting since they are read when the library is loaded. Checks that:
+ *  - without a setting, or with an invalid one, the emulation is off;
+ *  - SGX_SIM_TRANSITION_CYCLES=<n> costs at least <n> TSC cycles per
+ *    transition;
+ *  - SGX_SIM_TRANSITION_FLUSH_KB=<n> writes the buffer on every transition.
+ * The emulated cost per transition is printed for each setting.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include "sim_transition.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define TRANSITIONS     2000
+#define TEST_CYCLES     20000
+#define TEST_FLUSH_KB   1024
+
+extern char **environ;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t read_tsc()
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* child: time the transitions under the setting it was started with */
+static int run_setting(const char *setting)
+{
+    uint64_t cycles = getenv("SGX_SIM_TRANSITION_CYCLES") ? strtoull(getenv("SGX_SIM_TRANSITION_CYCLES"), NULL, 0) : 0;
+    uint64_t flush_kb = getenv("SGX_SIM_TRANSITION_FLUSH_KB") ? strtoull(getenv("SGX_SIM_TRANSITION_FLUSH_KB"), NULL, 0) : 0;
+
+    uint64_t start_ns = now_ns(), start_tsc = read_tsc();
+    for (int i = 0; i < TRANSITIONS; i++)
+        sim_transition_cost();
+    uint64_t tsc = read_tsc() - start_tsc;
+    double ns = (double)(now_ns() - start_ns) / TRANSITIONS;
+
+    if (strcmp(setting, "off") == 0 || strcmp(setting, "invalid") == 0) {
+        CHECK(g_sim_transition_enabled == 0);
+    } else {
+        CHECK(g_sim_transition_enabled == 1);
+        CHECK(tsc >= cycles * TRANSITIONS);
+        /* one write per cache line of the buffer, even a cache hit
+         * costs more than 1ns per 8 lines */
+        if (flush_kb != 0)
+            CHECK(ns >= (double)(flush_kb * 1024 / 64 / 8));
+    }
+
+    printf("  %-8s %10.1f ns, %10.1f cycles per transition\n", setting, ns, (double)tsc / TRANSITIONS);
+    return 0;
+}
+
+static void spawn_setting(const char *setting, const char *env)
+{
+    char self[] = "/proc/self/exe";
+    char *argv[] = { self, (char *)setting, NULL };
+    char *envp[] = { (char *)env, NULL };
+    pid_t pid;
+    int status = 0;
+
+    fflush(stdout);
+    CHECK(posix_spawn(&pid, self, NULL, NULL, argv, env ? envp : environ) == 0);
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2)
+        return run_setting(argv[1]);
+
+    char cycles[64], flush[64];
+    snprintf(cycles, sizeof(cycles), "SGX_SIM_TRANSITION_CYCLES=%d", TEST_CYCLES);
+    snprintf(flush, sizeof(flush), "SGX_SIM_TRANSITION_FLUSH_KB=%d", TEST_FLUSH_KB);
+
+    printf("sim_transition_test: %d transitions\n", TRANSITIONS);
+    spawn_setting("off", NULL);
+    spawn_setting("invalid", "SGX_SIM_TRANSITION_CYCLES=12abc");
+    spawn_setting("cycles", cycles);
+    spawn_setting("flush", flush);
+    return 0;
+}
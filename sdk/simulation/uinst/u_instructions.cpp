@@ -49,6 +49,7 @@
 #include "sgxsim.h"
 #include "enclave_mngr.h"
 #include "u_instructions.h"
+#include "sim_transition.h"
 
 #include "crypto_wrapper.h"
 
@@ -219,6 +220,8 @@ void _SE3(uintptr_t xax, uintptr_t xbx,
     switch (xax)
     {
     case SE_EENTER:
+        sim_transition_cost();
+
         uintptr_t     xip;
         void        * enclave_base_addr;
         se_pt_regs_t* p_pt_regs;
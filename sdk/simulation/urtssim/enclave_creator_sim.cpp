@@ -298,6 +298,14 @@ int EnclaveCreatorSim::trim_accept(uint64_t addr)
     return SGX_SUCCESS;
 }
 
+int EnclaveCreatorSim::trim_accept_range(uint64_t fromaddr, uint64_t toaddr)
+{
+    UNUSED(fromaddr);
+    UNUSED(toaddr);
+
+    return SGX_SUCCESS;
+}
+
 int EnclaveCreatorSim::remove_range(uint64_t fromaddr, uint64_t numpages)
 {
     UNUSED(fromaddr);
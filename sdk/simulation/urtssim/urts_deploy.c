@@ -61,15 +61,28 @@ void sgx_debug_load_state_add_element(){};
 void sgx_debug_unload_state_remove_element(){};
 void sgx_destroy_enclave(){};
 void sgx_get_target_info(){};
+void sgx_set_tcs_wait(){};
+void sgx_get_enclave_stats(){};
+void sgx_get_enclave_ecall_stats(){};
+void sgx_enable_ecall_timing(){};
+void sgx_get_switchless_call_stats(){};
+void sgx_enable_switchless_call_timing(){};
+void sgx_enable_transition_trace(){};
+void sgx_dump_transition_trace(){};
 void sgx_ecall(){};
 void sgx_ecall_switchless(){};
+void sgx_ecall_switchless_async(){};
+void sgx_ecall_wait(){};
+void sgx_ecall_poll(){};
 void sgx_set_switchless_itf(){};
+void sgx_set_switchless_itf_ex(){};
 void sgx_oc_cpuidex(){};
 void sgx_ocall(){};
 void sgx_thread_set_multiple_untrusted_events_ocall(){};
 void sgx_thread_set_untrusted_event_ocall(){};
 void sgx_thread_setwait_untrusted_events_ocall(){};
 void sgx_thread_wait_untrusted_event_ocall(){};
+void sgx_thread_wait_untrusted_event_timeout_ocall(){};
 
 sgx_status_t pthread_create_ocall()
 {
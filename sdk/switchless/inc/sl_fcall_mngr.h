@@ -58,6 +58,7 @@
  */
 
 #include <sgx_error.h>
+#include <sgx_uswitchless.h>
 #include <sl_siglines.h>
 
 
@@ -88,15 +89,32 @@ struct sl_call_task {
     uint32_t                   func_id;       // function id to be called (index to the call table)
     void*                      func_data;     // data to be passed to the function 
     sgx_status_t               ret_code;      // return code of the function 
+    uint64_t                   submit_ns;     // submission time, only set by untrusted callers, 0 when not timed
+    uint64_t                   accept_ns;     // acceptance time, set by untrusted workers or by the waiting caller, 0 when unknown
+    uint32_t                   poll_tries;    // polls that found the task not accepted yet
 };
 
 #define SL_INVALID_FUNC_ID ((uint32_t)-1)
 
+#define sl_call_stats_t         sgx_uswitchless_call_stats_t
+#define SL_STATS_MAX_FUNCS      SGX_USWITCHLESS_STATS_MAX_FUNCS
+#define SL_HIST_BUCKETS         SGX_USWITCHLESS_HIST_BUCKETS
+
+/* Layout version of sl_call_task and sl_call_mngr, bump it whenever either
+ * changes. It is the first field so that a mismatch is caught however the
+ * rest moved: an enclave refuses call managers of another version, and this
+ * value is neither SL_TYPE_OCALL nor SL_TYPE_ECALL, which older enclaves read
+ * in its place. */
+#define SL_CALL_MNGR_VERSION    0x534c0002  /* "SL", 2 */
+
 struct sl_call_mngr {
+    uint32_t                version;        // SL_CALL_MNGR_VERSION of the untrusted side
     sl_call_type_t          type;           // type of the call manager (ECALL / OCALL)
     struct sl_siglines      siglns;         // signal lines to pass task request from/to trusted/untrusted side
     struct sl_call_task*    tasks;          // array of tasks  
     const sl_call_table_t*  call_table;     // functions call table 
+    sl_call_stats_t*        stats;          // per-function statistics, SL_STATS_MAX_FUNCS entries
+    volatile uint32_t       timing;         // fill the latency histograms, only read by untrusted code
 };
 
 #pragma pack(pop)
@@ -40,12 +40,24 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <sl_siglines.h>
+#ifndef SL_INSIDE_ENCLAVE /* Untrusted */
+#include <time.h>
+#else /* Trusted */
+#include <sgx_edger8r.h>
+#endif
 
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* The enclave and the uRTS may come from different builds, these pin the
+ * layout that SL_CALL_MNGR_VERSION stands for. */
+_Static_assert(sizeof(struct sl_call_task) == 32 + sizeof(void*),
+               "sl_call_task changed, bump SL_CALL_MNGR_VERSION");
+_Static_assert(sizeof(struct sl_call_mngr) == 12 + sizeof(struct sl_siglines) + 3 * sizeof(void*),
+               "sl_call_mngr changed, bump SL_CALL_MNGR_VERSION");
+
 static inline sl_siglines_dir_t call_type2direction(sl_call_type_t type)
 {
     /* Use C99's designated initializers to make this conversion more readable */
@@ -77,6 +89,48 @@ static inline int can_type_call(sl_call_type_t type)
 }
 
 
+/*
+ * Per-function statistics live outside the enclave and are updated by both
+ * sides. Latencies can only be measured by untrusted code, which has a clock.
+ */
+static inline sl_call_stats_t* sl_call_mngr_get_stats(struct sl_call_mngr* mngr, uint32_t func_id)
+{
+    if (mngr->stats == NULL || func_id >= SL_STATS_MAX_FUNCS)
+        return NULL;
+    return &mngr->stats[func_id];
+}
+
+static inline void sl_call_mngr_count_call(struct sl_call_mngr* mngr, uint32_t func_id)
+{
+    sl_call_stats_t* stats = sl_call_mngr_get_stats(mngr, func_id);
+    if (stats != NULL)
+        lock_inc(&stats->calls);
+}
+
+static inline void sl_call_mngr_count_fallback(struct sl_call_mngr* mngr, uint32_t func_id)
+{
+    sl_call_stats_t* stats = sl_call_mngr_get_stats(mngr, func_id);
+    if (stats != NULL)
+        lock_inc(&stats->fallbacks);
+}
+
+#ifndef SL_INSIDE_ENCLAVE /* Untrusted */
+
+static inline uint64_t sl_get_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline void sl_hist_add(volatile uint64_t* hist, uint64_t ns)
+{
+    uint32_t bucket = (uint32_t)(63 - __builtin_clzll(ns | 1));
+    lock_inc(&hist[MIN(bucket, SL_HIST_BUCKETS - 1)]);
+}
+
+#endif /* SL_INSIDE_ENCLAVE */
+
 static inline void sl_call_mngr_register_calls(struct sl_call_mngr* mngr,
                                   const sl_call_table_t* call_table)
 {
@@ -124,6 +178,10 @@ static inline void process_switchless_call(struct sl_siglines* siglns, uint32_t
     struct sl_call_task *call_task_u = &mngr->tasks[line];
 
     BUG_ON(call_task_u->status != SL_SUBMITTED);
+#ifndef SL_INSIDE_ENCLAVE /* untrusted, only untrusted workers have a clock */
+    if (mngr->timing)
+        call_task_u->accept_ns = sl_get_time_ns();
+#endif
     call_task_u->status = SL_ACCEPTED;
 
     uint32_t func_id = call_task_u->func_id;
@@ -150,7 +208,20 @@ static inline void process_switchless_call(struct sl_siglines* siglns, uint32_t
     // Do the call.
     // func_data should point to untrusted buffer and should be checked by invoked function
     // in our case, edre8r generated code is performing the check
+#ifndef SL_INSIDE_ENCLAVE /* untrusted, time the switchless OCall from its acceptance */
+    call_task_u->ret_code = call_func_ptr(call_task_u->func_data);
+
+    if (call_task_u->accept_ns != 0)
+    {
+        sl_call_stats_t* stats = sl_call_mngr_get_stats(mngr, func_id);
+        if (stats != NULL)
+            sl_hist_add(stats->exec_hist, sl_get_time_ns() - call_task_u->accept_ns);
+    }
+#else /* trusted, the ECall doesn't go through trts_ecall(), which rewinds the ECALL arena */
+    size_t arena_mark = sgx_ecall_arena_mark();
     call_task_u->ret_code = call_func_ptr(call_task_u->func_data);
+    sgx_ecall_arena_rewind(arena_mark);
+#endif
 
 on_done:
     /* Notify the caller that the switchless is done by updating the status.
@@ -162,10 +233,11 @@ on_done:
 
 
 
-static inline int sl_call_mngr_call(struct sl_call_mngr* mngr, struct sl_call_task* call_task, uint32_t max_tries)
+static inline int sl_call_mngr_submit(struct sl_call_mngr* mngr, struct sl_call_task* call_task, uint32_t* line_out)
 {
     /*
-        Used to make actual switchless call by both enclave & untrusted code
+        Publishes a switchless call without waiting for it, the call is completed
+        with sl_call_mngr_wait() or sl_call_mngr_poll() on the returned line.
 
         mngr:      points to ECALL or OCALL manager. For enclave, OCALL mngr and all its content are checkeds in sl_mngr_clone() function
                    see init_tswitchless_ocall_mngr()
@@ -176,8 +248,6 @@ static inline int sl_call_mngr_call(struct sl_call_mngr* mngr, struct sl_call_ta
 
     BUG_ON(!can_type_call(mngr->type));
 
-    int ret = 0;
-
     /* Allocate a free signal line to send signal */
     struct sl_siglines* siglns = &mngr->siglns;
     uint32_t line = sl_siglines_alloc_line(siglns);
@@ -186,6 +256,13 @@ static inline int sl_call_mngr_call(struct sl_call_mngr* mngr, struct sl_call_ta
 
     BUG_ON(call_task->status != SL_INIT);
     call_task->status = SL_SUBMITTED;
+    call_task->poll_tries = 0;
+    call_task->accept_ns = 0;
+#ifndef SL_INSIDE_ENCLAVE /* untrusted */
+    call_task->submit_ns = mngr->timing ? sl_get_time_ns() : 0;
+#else
+    call_task->submit_ns = 0;
+#endif
 
     // copy task data to internal array accessable by both sides (trusted & untrusted)
     mngr->tasks[line] = *call_task;
@@ -197,6 +274,21 @@ static inline int sl_call_mngr_call(struct sl_call_mngr* mngr, struct sl_call_ta
 
     sl_siglines_trigger_signal(siglns, line);
 
+    *line_out = line;
+    return 0;
+}
+
+static inline int sl_call_mngr_wait(struct sl_call_mngr* mngr, uint32_t line, struct sl_call_task* call_task, uint32_t max_tries)
+{
+    int ret = 0;
+    struct sl_siglines* siglns = &mngr->siglns;
+#ifndef SL_INSIDE_ENCLAVE /* untrusted */
+    /* A trusted worker can't timestamp the acceptance of an ECall, the caller
+     * does it when it sees the status change while spinning. */
+    int timed = mngr->timing && mngr->tasks[line].submit_ns != 0 &&
+                mngr->tasks[line].status == SL_SUBMITTED;
+#endif
+
     // wait till the other side has picked the task for processing
     while ((mngr->tasks[line].status == SL_SUBMITTED) && (--max_tries > 0))
     {
@@ -216,7 +308,16 @@ static inline int sl_call_mngr_call(struct sl_call_mngr* mngr, struct sl_call_ta
         }
         /* Otherwise, the signal is not revoked succesfully, meaning this
         * call is being or has been processed by workers. So we continue. */
+#ifndef SL_INSIDE_ENCLAVE /* untrusted, the acceptance was not seen */
+        timed = 0;
+#endif
     }
+#ifndef SL_INSIDE_ENCLAVE /* untrusted */
+    else if (timed && mngr->tasks[line].accept_ns == 0)
+    {
+        mngr->tasks[line].accept_ns = sl_get_time_ns();
+    }
+#endif
 
     /* The request must has been accepted. Now wait for its completion */
     while (mngr->tasks[line].status != SL_DONE)
@@ -231,12 +332,76 @@ static inline int sl_call_mngr_call(struct sl_call_mngr* mngr, struct sl_call_ta
     // copy the return code
     call_task->ret_code = mngr->tasks[line].ret_code;
 
+#ifndef SL_INSIDE_ENCLAVE /* untrusted */
+    if (timed)
+    {
+        sl_call_stats_t* stats = sl_call_mngr_get_stats(mngr, mngr->tasks[line].func_id);
+        if (stats != NULL)
+        {
+            uint64_t accept_ns = mngr->tasks[line].accept_ns;
+            sl_hist_add(stats->queue_wait_hist, accept_ns - mngr->tasks[line].submit_ns);
+            sl_hist_add(stats->exec_hist, sl_get_time_ns() - accept_ns);
+        }
+    }
+#endif
+
 on_exit:
     mngr->tasks[line].func_id = SL_INVALID_FUNC_ID;
     sl_siglines_free_line(siglns, line);
     return ret;
 }
 
+// Returns -EINPROGRESS and keeps the line while the call is not done. Every poll
+// finding the call not accepted yet uses up one of max_tries, when they run out
+// the call is revoked as in sl_call_mngr_wait() and -EAGAIN is returned.
+static inline int sl_call_mngr_poll(struct sl_call_mngr* mngr, uint32_t line, struct sl_call_task* call_task, uint32_t max_tries)
+{
+    struct sl_siglines* siglns = &mngr->siglns;
+
+    if (mngr->tasks[line].status == SL_SUBMITTED)
+    {
+        if (++mngr->tasks[line].poll_tries < max_tries)
+            return -EINPROGRESS;
+
+        if (sl_siglines_revoke_signal(siglns, line) == 0)
+        {
+            mngr->tasks[line].func_id = SL_INVALID_FUNC_ID;
+            sl_siglines_free_line(siglns, line);
+            return -EAGAIN;
+        }
+        /* Otherwise a worker has taken the call, keep polling for its completion. */
+    }
+
+    if (mngr->tasks[line].status != SL_DONE)
+        return -EINPROGRESS;
+
+    sgx_mfence();
+    call_task->ret_code = mngr->tasks[line].ret_code;
+    mngr->tasks[line].func_id = SL_INVALID_FUNC_ID;
+    sl_siglines_free_line(siglns, line);
+    return 0;
+}
+
+static inline int sl_call_mngr_call(struct sl_call_mngr* mngr, struct sl_call_task* call_task, uint32_t max_tries)
+{
+    /*
+        Used to make actual switchless call by both enclave & untrusted code
+
+        mngr:      points to ECALL or OCALL manager. For enclave, OCALL mngr and all its content are checkeds in sl_mngr_clone() function
+                   see init_tswitchless_ocall_mngr()
+
+        call_task: contains all the information of function to be called,
+                   when called by enclave to make OCALL, call_task resides on enclaves stack
+    */
+
+    uint32_t line = SL_INVALID_SIGLINE;
+    int ret = sl_call_mngr_submit(mngr, call_task, &line);
+    if (ret)
+        return ret;
+
+    return sl_call_mngr_wait(mngr, line, call_task, max_tries);
+}
+
 
 #ifdef __cplusplus
 }
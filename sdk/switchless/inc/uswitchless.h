@@ -72,8 +72,26 @@ sgx_status_t sl_uswitchless_do_switchless_ecall(void* _switchless,
                                                 void* ecall_ms,
                                                 int* need_fallback);
 
+sgx_status_t sl_uswitchless_submit_switchless_ecall(void* _switchless,
+                                                    const unsigned int ecall_id,
+                                                    void* ecall_ms,
+                                                    uint32_t* line);
+
+sgx_status_t sl_uswitchless_complete_switchless_ecall(void* _switchless,
+                                                      const uint32_t line,
+                                                      int wait,
+                                                      int* done,
+                                                      int* need_fallback);
+
 sgx_status_t sl_uswitchless_on_first_ecall(void* _switchless, sgx_enclave_id_t enclave_id, const void* ocall_table);
 
+sgx_status_t sl_uswitchless_get_call_stats(void* _switchless,
+                                           const int call_type,
+                                           const uint32_t func_id,
+                                           void* stats);
+
+sgx_status_t sl_uswitchless_set_call_timing(void* _switchless, const int enable);
+
 sgx_status_t sl_ocall_wake_workers(void* ms);
 
 #ifdef __cplusplus
@@ -89,6 +89,7 @@ sgx_status_t sgx_ocall_switchless(const unsigned int index, void* ms)
         return sgx_ocall(index, ms);
 
     // g_uswitchless_handle is checked in sl_init_switchless()
+    sl_call_mngr_count_call(&g_ocall_mngr, index);
 
     /* If no untrusted workers are running, then fallback */ 
     if (g_uswitchless_handle->us_uworkers.num_running == 0) 
@@ -117,6 +118,7 @@ sgx_status_t sgx_ocall_switchless(const unsigned int index, void* ms)
     return call_task.ret_code;
 
 on_fallback:
+    sl_call_mngr_count_fallback(&g_ocall_mngr, index);
     lock_inc(&g_uswitchless_handle->us_uworkers.stats.missed);
     g_uswitchless_handle->us_has_new_ocall_fallback = 1;
     return sgx_ocall(index, ms);
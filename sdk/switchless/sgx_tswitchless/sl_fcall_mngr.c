@@ -45,11 +45,16 @@ uint32_t sl_call_mngr_clone(struct sl_call_mngr* mngr, const struct sl_call_mngr
     PANIC_ON(!sgx_is_outside_enclave(untrusted, sizeof(*untrusted)));
     sgx_lfence();
 
+    // built with another layout of the shared structures
+    if (untrusted->version != SL_CALL_MNGR_VERSION)
+        return EPROTO;
+
     sl_call_type_t type_u = untrusted->type;
 
     // garbage data ? probably an attack
     PANIC_ON((type_u != SL_TYPE_ECALL) && (type_u != SL_TYPE_OCALL));
     
+    mngr->version = SL_CALL_MNGR_VERSION;
     mngr->type = type_u;
 
     // clone internal pointers to siglines structure
@@ -72,6 +77,14 @@ uint32_t sl_call_mngr_clone(struct sl_call_mngr* mngr, const struct sl_call_mngr
     sgx_lfence();
 
     mngr->tasks = tasks_u;
+
+    // statistics are updated by both the enclave and untrusted code, they must be outside too
+    sl_call_stats_t* stats_u = untrusted->stats;
+
+    PANIC_ON(stats_u != NULL && !sgx_is_outside_enclave(stats_u, sizeof(stats_u[0]) * SL_STATS_MAX_FUNCS));
+    sgx_lfence();
+
+    mngr->stats = stats_u;
     mngr->call_table = NULL;
 
     return 0;
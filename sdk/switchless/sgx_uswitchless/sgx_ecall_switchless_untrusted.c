@@ -94,6 +94,8 @@ sgx_status_t sl_uswitchless_do_switchless_ecall(void* _switchless,
 
     int error = 0;
 
+    sl_call_mngr_count_call(&handle->us_ecall_mngr, ecall_id);
+
     /* initialization in progress or no trusted workers are running, then fallback */
     if ((handle->us_init_finished == 0) || (handle->us_tworkers.num_running == 0))
         goto on_fallback;
@@ -118,7 +120,95 @@ sgx_status_t sl_uswitchless_do_switchless_ecall(void* _switchless,
     return call_task.ret_code;
 on_fallback:
     *need_fallback = 1;
+    sl_call_mngr_count_fallback(&handle->us_ecall_mngr, ecall_id);
+    lock_inc(&handle->us_tworkers.stats.missed);
+    sl_workers_notify_event(&handle->us_tworkers, SL_WORKER_EVENT_MISS);
+    return SGX_ERROR_BUSY;
+}
+
+
+/* sgx_ecall_switchless_async() from uRTS calls this function to queue the call,
+ * SGX_ERROR_BUSY means it has to be made as an ordinary ECall */
+sgx_status_t sl_uswitchless_submit_switchless_ecall(void* _switchless,
+                                                    const unsigned int ecall_id,
+                                                    void* ecall_ms,
+                                                    uint32_t* line)
+{
+    BUG_ON(_switchless == NULL);
+    struct sl_uswitchless* handle = (struct sl_uswitchless*)_switchless;
+
+    sl_call_mngr_count_call(&handle->us_ecall_mngr, ecall_id);
+
+    if ((handle->us_init_finished == 0) || (handle->us_tworkers.num_running == 0))
+        goto on_fallback;
+
+    if (handle->us_tworkers.num_sleeping > 0)
+    {
+        wake_all_threads(&handle->us_tworkers);
+    }
+
+    struct sl_call_task call_task;
+    call_task.status = SL_INIT;
+    call_task.func_id = ecall_id;
+    call_task.func_data = ecall_ms;
+    call_task.ret_code = SGX_ERROR_UNEXPECTED;
+
+    if (sl_call_mngr_submit(&handle->us_ecall_mngr, &call_task, line))
+        goto on_fallback;
+
+    return SGX_SUCCESS;
+on_fallback:
+    sl_call_mngr_count_fallback(&handle->us_ecall_mngr, ecall_id);
     lock_inc(&handle->us_tworkers.stats.missed);
     sl_workers_notify_event(&handle->us_tworkers, SL_WORKER_EVENT_MISS);
     return SGX_ERROR_BUSY;
 }
+
+/* sgx_ecall_wait() and sgx_ecall_poll() from uRTS call this function for a
+ * queued switchless ECall. *done is 0 only when polling a call still running,
+ * a call not accepted before the retries run out is revoked and falls back,
+ * each poll of a call not accepted yet counts as one retry */
+sgx_status_t sl_uswitchless_complete_switchless_ecall(void* _switchless,
+                                                      const uint32_t line,
+                                                      int wait,
+                                                      int* done,
+                                                      int* need_fallback)
+{
+    BUG_ON(_switchless == NULL);
+    struct sl_uswitchless* handle = (struct sl_uswitchless*)_switchless;
+
+    struct sl_call_task call_task;
+    call_task.ret_code = SGX_ERROR_UNEXPECTED;
+
+    // the line is released once the call completes
+    uint32_t ecall_id = handle->us_ecall_mngr.tasks[line].func_id;
+
+    int error = 0;
+    if (wait)
+    {
+        error = sl_call_mngr_wait(&handle->us_ecall_mngr, line, &call_task, handle->us_config.retries_before_fallback);
+    }
+    else
+    {
+        error = sl_call_mngr_poll(&handle->us_ecall_mngr, line, &call_task, handle->us_config.retries_before_fallback);
+        if (error == -EINPROGRESS)
+        {
+            *done = 0;
+            return SGX_ERROR_BUSY;
+        }
+    }
+
+    *done = 1;
+    if (error)
+    {
+        *need_fallback = 1;
+        sl_call_mngr_count_fallback(&handle->us_ecall_mngr, ecall_id);
+        lock_inc(&handle->us_tworkers.stats.missed);
+        sl_workers_notify_event(&handle->us_tworkers, SL_WORKER_EVENT_MISS);
+        return SGX_ERROR_BUSY;
+    }
+
+    *need_fallback = 0;
+    lock_inc(&handle->us_tworkers.stats.processed);
+    return call_task.ret_code;
+}
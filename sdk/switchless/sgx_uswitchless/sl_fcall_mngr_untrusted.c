@@ -36,6 +36,7 @@ uint32_t sl_call_mngr_init(struct sl_call_mngr* mngr,
                        uint32_t max_pending_calls)
 {
     uint32_t i;
+    mngr->version = SL_CALL_MNGR_VERSION;
     mngr->type = type;
 
     struct sl_call_task* tasks = (struct sl_call_task*)calloc(max_pending_calls, sizeof(tasks[0]));
@@ -50,16 +51,26 @@ uint32_t sl_call_mngr_init(struct sl_call_mngr* mngr,
     
     mngr->tasks = tasks;
 
+    sl_call_stats_t* stats = (sl_call_stats_t*)calloc(SL_STATS_MAX_FUNCS, sizeof(stats[0]));
+    if (stats == NULL)
+    {
+        free(tasks);
+        return ENOMEM;
+    }
+
     uint32_t ret = sl_siglines_init(&mngr->siglns,
                                     call_type2direction(type),
                                     max_pending_calls,
                                     can_type_process(type) ? process_switchless_call : NULL);
     if (ret != 0) 
     { 
+        free(stats);
         free(tasks); 
         return ret; 
     }
 
+    mngr->stats = stats;
+    mngr->timing = 0;
     mngr->call_table = NULL;
     return 0;
 }
@@ -67,5 +78,6 @@ uint32_t sl_call_mngr_init(struct sl_call_mngr* mngr,
 void sl_call_mngr_destroy(struct sl_call_mngr* mngr) 
 {
     sl_siglines_destroy(&mngr->siglns);
+    free(mngr->stats);
     free(mngr->tasks);
 }
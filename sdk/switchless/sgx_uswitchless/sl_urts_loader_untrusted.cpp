@@ -14,13 +14,17 @@ sgx_switchless_funcs_t g_switchless_itf =
     sl_uswitchless_do_switchless_ecall,
     sl_destroy_uswitchless,
     sl_uswitchless_check_switchless_ocall_fallback,
-    sl_uswitchless_on_first_ecall
+    sl_uswitchless_on_first_ecall,
+    sl_uswitchless_submit_switchless_ecall,
+    sl_uswitchless_complete_switchless_ecall,
+    sl_uswitchless_get_call_stats,
+    sl_uswitchless_set_call_timing
 };
 
 
 urts_loader_t::urts_loader_t()
 {
-    sgx_set_switchless_itf(&g_switchless_itf);
+    sgx_set_switchless_itf_ex(&g_switchless_itf, sizeof(g_switchless_itf));
 }
 
 urts_loader_t urts_loader;
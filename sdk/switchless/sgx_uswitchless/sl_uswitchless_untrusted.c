@@ -228,6 +228,47 @@ void sl_uswitchless_check_switchless_ocall_fallback(void* _switchless)
     }
 }
 
+/*=========================================================================
+ * Statistics
+ *========================================================================*/
+
+/* sgx_get_switchless_call_stats() from uRTS calls this function. The counters
+ * keep changing while calls are made, so the copy is not a consistent snapshot */
+sgx_status_t sl_uswitchless_get_call_stats(void* _switchless,
+                                           const int call_type,
+                                           const uint32_t func_id,
+                                           void* stats)
+{
+    BUG_ON(_switchless == NULL);
+    struct sl_uswitchless* handle = (struct sl_uswitchless*)_switchless;
+
+    struct sl_call_mngr* mngr;
+    if (call_type == SGX_USWITCHLESS_CALL_OCALL)
+        mngr = &handle->us_ocall_mngr;
+    else if (call_type == SGX_USWITCHLESS_CALL_ECALL)
+        mngr = &handle->us_ecall_mngr;
+    else
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    sl_call_stats_t* stats_p = sl_call_mngr_get_stats(mngr, func_id);
+    if (stats_p == NULL)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    memcpy(stats, stats_p, sizeof(*stats_p));
+    return SGX_SUCCESS;
+}
+
+/* sgx_enable_switchless_call_timing() from uRTS calls this function */
+sgx_status_t sl_uswitchless_set_call_timing(void* _switchless, const int enable)
+{
+    BUG_ON(_switchless == NULL);
+    struct sl_uswitchless* handle = (struct sl_uswitchless*)_switchless;
+
+    handle->us_ocall_mngr.timing = enable ? 1 : 0;
+    handle->us_ecall_mngr.timing = enable ? 1 : 0;
+    return SGX_SUCCESS;
+}
+
 /*=========================================================================
  * ECall-specific APIs
  *========================================================================*/
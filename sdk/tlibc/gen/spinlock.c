@@ -58,13 +58,25 @@ static inline int _InterlockedExchange(int volatile * dst, int val)
    
 }
 
+/* upper bound of pause instructions between two reads of a busy lock */
+#define SPIN_BACKOFF_MAX    64
+
 uint32_t sgx_spin_lock(sgx_spinlock_t *lock)
 {
-    while(_InterlockedExchange((volatile int *)lock, 1) != 0) {
-        while (*lock) {
-            /* tell cpu we are spinning */
-            _mm_pause();
-        } 
+    unsigned int backoff = 1;
+
+    /* only try the xchg when a plain read says the lock is free, so waiters
+     * share the cache line instead of bouncing it between cores */
+    while(*(volatile sgx_spinlock_t *)lock != 0 ||
+          _InterlockedExchange((volatile int *)lock, 1) != 0) {
+        do {
+            /* tell cpu we are spinning, back off longer while contended */
+            for (unsigned int i = 0; i < backoff; i++)
+                _mm_pause();
+            backoff <<= 1;
+            if (backoff > SPIN_BACKOFF_MAX)
+                backoff = SPIN_BACKOFF_MAX;
+        } while (*(volatile sgx_spinlock_t *)lock);
     }
 
     return (0);
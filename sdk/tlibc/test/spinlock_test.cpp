@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Runs the tlibc sgx_spin_lock on host threads. Checks that:
+ *  - a held lock keeps a second thread out until it is released;
+ *  - contended threads never share the critical section.
+ * The cost per lock is printed per number of threads, next to the previous
+ * sgx_spin_lock: xchg first, then one pause per read while the lock is busy.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sgx_spinlock.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define BENCH_MAX       4
+#define BENCH_LOCKS     200000
+#define CS_WORK         16      /* loop iterations inside the critical section */
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t xchg_lock(sgx_spinlock_t *lock)
+{
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        while (*lock)
+            __asm__ __volatile__ ("pause" : : : "memory");
+    }
+    return 0;
+}
+
+static uint32_t xchg_unlock(sgx_spinlock_t *lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+typedef struct _lock_ops_t
+{
+    const char *name;
+    uint32_t (*lock)(sgx_spinlock_t *);
+    uint32_t (*unlock)(sgx_spinlock_t *);
+} lock_ops_t;
+
+static sgx_spinlock_t g_lock = SGX_SPINLOCK_INITIALIZER;
+
+/* held lock */
+static volatile int g_entered = 0;
+
+static void *enter_thread(void *arg)
+{
+    (void)arg;
+    CHECK(sgx_spin_lock(&g_lock) == 0);
+    g_entered = 1;
+    CHECK(sgx_spin_unlock(&g_lock) == 0);
+    return NULL;
+}
+
+static void check_held()
+{
+    pthread_t thread;
+
+    CHECK(sgx_spin_lock(&g_lock) == 0);
+    CHECK(g_lock == 1);
+    CHECK(pthread_create(&thread, NULL, enter_thread, NULL) == 0);
+
+    /* give the waiter plenty of time to get in by mistake */
+    uint64_t start = now_ns();
+    while (now_ns() - start < 20000000ULL)
+        sched_yield();
+    CHECK(g_entered == 0);
+    CHECK(g_lock == 1);
+
+    CHECK(sgx_spin_unlock(&g_lock) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(g_entered == 1);
+    CHECK(g_lock == 0);
+}
+
+/* contention */
+static const lock_ops_t *g_ops = NULL;
+static volatile int g_inside = 0;
+static volatile int g_overlaps = 0;
+static volatile uint64_t g_counter = 0;
+
+static void *bench_thread(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < BENCH_LOCKS; i++) {
+        CHECK(g_ops->lock(&g_lock) == 0);
+        if (__atomic_add_fetch(&g_inside, 1, __ATOMIC_SEQ_CST) != 1)
+            __atomic_add_fetch(&g_overlaps, 1, __ATOMIC_SEQ_CST);
+        for (int j = 0; j < CS_WORK; j++)
+            g_counter = g_counter + 1;
+        __atomic_sub_fetch(&g_inside, 1, __ATOMIC_SEQ_CST);
+        CHECK(g_ops->unlock(&g_lock) == 0);
+    }
+    return NULL;
+}
+
+static double run_contention(const lock_ops_t *ops, int count)
+{
+    pthread_t threads[BENCH_MAX];
+
+    g_ops = ops;
+    g_counter = 0;
+    uint64_t start = now_ns();
+    for (int i = 0; i < count; i++)
+        CHECK(pthread_create(&threads[i], NULL, bench_thread, NULL) == 0);
+    for (int i = 0; i < count; i++)
+        CHECK(pthread_join(threads[i], NULL) == 0);
+    uint64_t elapsed = now_ns() - start;
+
+    CHECK(g_overlaps == 0);
+    CHECK(g_counter == (uint64_t)count * BENCH_LOCKS * CS_WORK);
+    CHECK(g_lock == 0);
+    return (double)elapsed / ((double)count * BENCH_LOCKS);
+}
+
+int main()
+{
+    static const lock_ops_t sgx_ops = { "sgx_spin_lock", sgx_spin_lock, sgx_spin_unlock };
+    static const lock_ops_t xchg_ops = { "previous", xchg_lock, xchg_unlock };
+
+    check_held();
+
+    printf("spinlock_test: %d locks per thread, %ld cpus\n", BENCH_LOCKS,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    for (int count = 1; count <= BENCH_MAX; count *= 2) {
+        double sgx_ns = run_contention(&sgx_ops, count);
+        double xchg_ns = run_contention(&xchg_ops, count);
+        printf("  %d threads: %s %7.1f ns/lock, %s %7.1f ns/lock\n", count,
+               sgx_ops.name, sgx_ns, xchg_ops.name, xchg_ns);
+    }
+    return 0;
+}
@@ -34,33 +34,22 @@
 #include "stdlib.h"
 #include "string.h"
 
-/* AES-CTR 128-bit
- * Parameters:
- *   Return:
- *     sgx_status_t - SGX_SUCCESS or failure as defined in sgx_error.h
- *   Inputs:
- *     sgx_aes_128bit_key_t *p_key - Pointer to the key used in encryption/decryption operation
- *     uint8_t *p_src - Pointer to the input stream to be encrypted/decrypted
- *     uint32_t src_len - Length of the input stream to be encrypted/decrypted
- *     uint8_t *p_ctr - Pointer to the counter block
- *     uint32_t ctr_inc_bits - Number of bits in counter to be incremented
- *   Output:
- *     uint8_t *p_dst - Pointer to the cipher text. Size of buffer should be >= src_len.
+/* AES-CTR 128-bit keyed context
+ * The handle is the IppsAESSpec holding the expanded key, so it can be reused
+ * for any number of encrypt/decrypt calls under the same key.
  */
-sgx_status_t sgx_aes_ctr_encrypt(const sgx_aes_ctr_128bit_key_t *p_key, const uint8_t *p_src,
-                                const uint32_t src_len, uint8_t *p_ctr, const uint32_t ctr_inc_bits,
-                                uint8_t *p_dst)
+sgx_status_t sgx_aes_ctr_init(const sgx_aes_ctr_128bit_key_t *p_key,
+                              sgx_aes_state_handle_t *p_aes_ctr_handle)
 {
     IppStatus error_code = ippStsNoErr;
     IppsAESSpec* ptr_ctx = NULL;
     int ctx_size = 0;
 
-    if ((p_key == NULL) || (p_src == NULL) || (p_ctr == NULL) || (p_dst == NULL))
+    if ((p_key == NULL) || (p_aes_ctr_handle == NULL))
     {
         return SGX_ERROR_INVALID_PARAMETER;
     }
 
-    // AES-CTR-128 encryption
     error_code = ippsAESGetSize(&ctx_size);
     if (error_code != ippStsNoErr)
     {
@@ -87,33 +76,87 @@ sgx_status_t sgx_aes_ctr_encrypt(const sgx_aes_ctr_128bit_key_t *p_key, const ui
         default: return SGX_ERROR_UNEXPECTED;
         }
     }
-    error_code = ippsAESEncryptCTR(p_src, p_dst, src_len, ptr_ctx, p_ctr, ctr_inc_bits);
-    if (error_code != ippStsNoErr)
+    *p_aes_ctr_handle = ptr_ctx;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_aes_ctr_encrypt_ctx(sgx_aes_state_handle_t aes_ctr_handle, const uint8_t *p_src,
+                                     const uint32_t src_len, uint8_t *p_ctr, const uint32_t ctr_inc_bits,
+                                     uint8_t *p_dst)
+{
+    if ((aes_ctr_handle == NULL) || (p_src == NULL) || (p_ctr == NULL) || (p_dst == NULL))
     {
-        // Clear temp State before free.
-        memset_s(ptr_ctx, ctx_size, 0, ctx_size);
-        free(ptr_ctx);
-        switch (error_code)
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // p_ctr is advanced in place, ready for the next call on the same stream
+    IppStatus error_code = ippsAESEncryptCTR(p_src, p_dst, src_len, (IppsAESSpec*)aes_ctr_handle,
+                                             p_ctr, ctr_inc_bits);
+    switch (error_code)
+    {
+    case ippStsNoErr: return SGX_SUCCESS;
+    case ippStsCTRSizeErr:
+    case ippStsNullPtrErr:
+    case ippStsLengthErr: return SGX_ERROR_INVALID_PARAMETER;
+    default: return SGX_ERROR_UNEXPECTED;
+    }
+}
+
+sgx_status_t sgx_aes_ctr_decrypt_ctx(sgx_aes_state_handle_t aes_ctr_handle, const uint8_t *p_src,
+                                     const uint32_t src_len, uint8_t *p_ctr, const uint32_t ctr_inc_bits,
+                                     uint8_t *p_dst)
+{
+    if ((aes_ctr_handle == NULL) || (p_src == NULL) || (p_ctr == NULL) || (p_dst == NULL))
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    IppStatus error_code = ippsAESDecryptCTR(p_src, p_dst, src_len, (IppsAESSpec*)aes_ctr_handle,
+                                             p_ctr, ctr_inc_bits);
+    switch (error_code)
+    {
+    case ippStsNoErr: return SGX_SUCCESS;
+    case ippStsCTRSizeErr:
+    case ippStsNullPtrErr:
+    case ippStsLengthErr: return SGX_ERROR_INVALID_PARAMETER;
+    default: return SGX_ERROR_UNEXPECTED;
+    }
+}
+
+sgx_status_t sgx_aes_ctr_close(sgx_aes_state_handle_t aes_ctr_handle)
+{
+    int ctx_size = 0;
+    if (aes_ctr_handle != NULL)
+    {
+        if (ippsAESGetSize(&ctx_size) != ippStsNoErr)
         {
-        case ippStsCTRSizeErr:
-        case ippStsNullPtrErr:
-        case ippStsLengthErr: return SGX_ERROR_INVALID_PARAMETER;
-        default: return SGX_ERROR_UNEXPECTED;
+            return SGX_ERROR_UNEXPECTED;
         }
+        // Clear the key schedule before free.
+        memset_s(aes_ctr_handle, ctx_size, 0, ctx_size);
+        free(aes_ctr_handle);
     }
-    // Clear temp State before free.
-    memset_s(ptr_ctx, ctx_size, 0, ctx_size);
-    free(ptr_ctx);
     return SGX_SUCCESS;
 }
 
-sgx_status_t sgx_aes_ctr_decrypt(const sgx_aes_ctr_128bit_key_t *p_key, const uint8_t *p_src,
+/* AES-CTR 128-bit
+ * Parameters:
+ *   Return:
+ *     sgx_status_t - SGX_SUCCESS or failure as defined in sgx_error.h
+ *   Inputs:
+ *     sgx_aes_128bit_key_t *p_key - Pointer to the key used in encryption/decryption operation
+ *     uint8_t *p_src - Pointer to the input stream to be encrypted/decrypted
+ *     uint32_t src_len - Length of the input stream to be encrypted/decrypted
+ *     uint8_t *p_ctr - Pointer to the counter block
+ *     uint32_t ctr_inc_bits - Number of bits in counter to be incremented
+ *   Output:
+ *     uint8_t *p_dst - Pointer to the cipher text. Size of buffer should be >= src_len.
+ */
+sgx_status_t sgx_aes_ctr_encrypt(const sgx_aes_ctr_128bit_key_t *p_key, const uint8_t *p_src,
                                 const uint32_t src_len, uint8_t *p_ctr, const uint32_t ctr_inc_bits,
                                 uint8_t *p_dst)
 {
-    IppStatus error_code = ippStsNoErr;
-    IppsAESSpec* ptr_ctx = NULL;
-    int ctx_size = 0;
+    sgx_aes_state_handle_t aes_ctr_handle = NULL;
 
     if ((p_key == NULL) || (p_src == NULL) || (p_ctr == NULL) || (p_dst == NULL))
     {
@@ -121,48 +164,34 @@ sgx_status_t sgx_aes_ctr_decrypt(const sgx_aes_ctr_128bit_key_t *p_key, const ui
     }
 
     // AES-CTR-128 encryption
-    error_code = ippsAESGetSize(&ctx_size);
-    if (error_code != ippStsNoErr)
+    sgx_status_t ret = sgx_aes_ctr_init(p_key, &aes_ctr_handle);
+    if (ret != SGX_SUCCESS)
     {
-        return SGX_ERROR_UNEXPECTED;
-    }
-    ptr_ctx = (IppsAESSpec*)malloc(ctx_size);
-    if (ptr_ctx == NULL)
-    {
-        return SGX_ERROR_OUT_OF_MEMORY;
+        return ret;
     }
+    ret = sgx_aes_ctr_encrypt_ctx(aes_ctr_handle, p_src, src_len, p_ctr, ctr_inc_bits, p_dst);
+    sgx_aes_ctr_close(aes_ctr_handle);
+    return ret;
+}
 
-    // Init
-    error_code = ippsAESInit((const Ipp8u*)p_key, SGX_AESCTR_KEY_SIZE, ptr_ctx, ctx_size);
-    if (error_code != ippStsNoErr)
+sgx_status_t sgx_aes_ctr_decrypt(const sgx_aes_ctr_128bit_key_t *p_key, const uint8_t *p_src,
+                                const uint32_t src_len, uint8_t *p_ctr, const uint32_t ctr_inc_bits,
+                                uint8_t *p_dst)
+{
+    sgx_aes_state_handle_t aes_ctr_handle = NULL;
+
+    if ((p_key == NULL) || (p_src == NULL) || (p_ctr == NULL) || (p_dst == NULL))
     {
-        // Clear temp State before free.
-        memset_s(ptr_ctx, ctx_size, 0, ctx_size);
-        free(ptr_ctx);
-        switch (error_code)
-        {
-        case ippStsMemAllocErr: return SGX_ERROR_OUT_OF_MEMORY;
-        case ippStsNullPtrErr:
-        case ippStsLengthErr: return SGX_ERROR_INVALID_PARAMETER;
-        default: return SGX_ERROR_UNEXPECTED;
-        }
+        return SGX_ERROR_INVALID_PARAMETER;
     }
-    error_code = ippsAESDecryptCTR(p_src, p_dst, src_len, ptr_ctx, p_ctr, ctr_inc_bits);
-    if (error_code != ippStsNoErr)
+
+    // AES-CTR-128 decryption
+    sgx_status_t ret = sgx_aes_ctr_init(p_key, &aes_ctr_handle);
+    if (ret != SGX_SUCCESS)
     {
-        // Clear temp State before free.
-        memset_s(ptr_ctx, ctx_size, 0, ctx_size);
-        free(ptr_ctx);
-        switch (error_code)
-        {
-        case ippStsCTRSizeErr:
-        case ippStsNullPtrErr:
-        case ippStsLengthErr: return SGX_ERROR_INVALID_PARAMETER;
-        default: return SGX_ERROR_UNEXPECTED;
-        }
+        return ret;
     }
-    // Clear temp State before free.
-    memset_s(ptr_ctx, ctx_size, 0, ctx_size);
-    free(ptr_ctx);
-    return SGX_SUCCESS;
+    ret = sgx_aes_ctr_decrypt_ctx(aes_ctr_handle, p_src, src_len, p_ctr, ctr_inc_bits, p_dst);
+    sgx_aes_ctr_close(aes_ctr_handle);
+    return ret;
 }
@@ -70,6 +70,16 @@ sgx_status_t sgx_ecc256_open_context(sgx_ecc_state_handle_t* p_ecc_handle)
         *p_ecc_handle = NULL;
         return SGX_ERROR_UNEXPECTED;
     }
+    // bind the precomputed generator table, generator multiplications done with
+    // this context (key generation, ECDSA signing and verification) use the
+    // constant-time fixed-base comb instead of a generic scalar multiplication
+    ipp_ret = ippsECCPBindGxyTblStd256r1(p_ecc_state);
+    if (ipp_ret != ippStsNoErr)
+    {
+        CLEAR_FREE_MEM(p_ecc_state, ctx_size);
+        *p_ecc_handle = NULL;
+        return SGX_ERROR_UNEXPECTED;
+    }
     *p_ecc_handle = p_ecc_state;
     return SGX_SUCCESS;
 }
@@ -425,6 +435,12 @@ sgx_status_t sgx_ecc256_calculate_pub_from_priv(const sgx_ec256_private_t *p_att
             break;
         }
 
+        //use the precomputed generator table for the public key calculation
+        //
+        if (ippsECCPBindGxyTblStd256r1(p_ecc_state) != ippStsNoErr) {
+            break;
+        }
+
         //get point (public key) size
         //
         if (ippsECCPPointGetSize(ECC_FIELD_SIZE, &point_size) != ippStsNoErr) {
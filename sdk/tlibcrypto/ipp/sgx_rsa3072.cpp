@@ -32,30 +32,69 @@
 
 #include "ipp_wrapper.h"
 
+/* Keyed RSA 3072 context: the imported IPP key state and the scratch buffer
+ * used by the PKCS#1 v1.5 primitives, kept alive across sign/verify calls.
+ */
+typedef struct _rsa3072_ctx_t
+{
+    bool is_private;
+    void *p_key_state;
+    int key_state_size;
+    Ipp8u *p_scratch;
+    int scratch_size;
+} rsa3072_ctx_t;
+
+static sgx_status_t ipp_to_sgx_status(IppStatus ipp_ret)
+{
+    switch (ipp_ret)
+    {
+    case ippStsNoErr: return SGX_SUCCESS;
+    case ippStsNoMemErr:
+    case ippStsMemAllocErr: return SGX_ERROR_OUT_OF_MEMORY;
+    case ippStsNullPtrErr:
+    case ippStsLengthErr:
+    case ippStsOutOfRangeErr:
+    case ippStsSizeErr:
+    case ippStsBadArgErr: return SGX_ERROR_INVALID_PARAMETER;
+    default: return SGX_ERROR_UNEXPECTED;
+    }
+}
 
-sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
-    uint32_t data_size,
-    const sgx_rsa3072_key_t * p_key,
-    sgx_rsa3072_signature_t * p_signature)
+static void rsa3072_ctx_free(rsa3072_ctx_t *p_ctx)
 {
-    if ((p_data == NULL) || (data_size < 1) || (p_key == NULL) ||
-        (p_signature == NULL) )
+    if (p_ctx == NULL)
+    {
+        return;
+    }
+    // the private key state and the scratch buffer both hold key material
+    CLEAR_FREE_MEM(p_ctx->p_key_state, p_ctx->key_state_size);
+    CLEAR_FREE_MEM(p_ctx->p_scratch, p_ctx->scratch_size);
+    free(p_ctx);
+}
+
+sgx_status_t sgx_rsa3072_sign_ctx_init(const sgx_rsa3072_key_t *p_key,
+    sgx_rsa3072_state_handle_t *p_rsa_handle)
+{
+    if ((p_key == NULL) || (p_rsa_handle == NULL))
     {
         return SGX_ERROR_INVALID_PARAMETER;
     }
     IppStatus ipp_ret = ippStsNoErr;
-    IppHashAlgId hash_alg = ippHashAlg_SHA256;
-
+    rsa3072_ctx_t *p_ctx = NULL;
     IppsRSAPrivateKeyState* p_rsa_privatekey_ctx = NULL;
-    int private_key_ctx_size = 0;
-    int private_key_buffer_size = 0;
-    Ipp8u *temp_buff = NULL;
 
     IppsBigNumState* p_prikey_mod_bn = NULL;
     IppsBigNumState* p_prikey_d_bn = NULL;
 
     do
     {
+        p_ctx = (rsa3072_ctx_t*)calloc(1, sizeof(rsa3072_ctx_t));
+        if (!p_ctx) {
+            ipp_ret = ippStsMemAllocErr;
+            break;
+        }
+        p_ctx->is_private = true;
+
         // Initializa IPP BN from the private key
         ipp_ret = sgx_ipp_newBN((const Ipp32u *)p_key->mod, sizeof(p_key->mod), &p_prikey_mod_bn);
         ERROR_BREAK(ipp_ret);
@@ -65,83 +104,99 @@ sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
 
         // allocate private key context
         ipp_ret = ippsRSA_GetSizePrivateKeyType1(SGX_RSA3072_KEY_SIZE * 8, SGX_RSA3072_PRI_EXP_SIZE * 8,
-            &private_key_ctx_size);
+            &p_ctx->key_state_size);
         ERROR_BREAK(ipp_ret);
 
-        p_rsa_privatekey_ctx = (IppsRSAPrivateKeyState*)malloc(private_key_ctx_size);
+        p_rsa_privatekey_ctx = (IppsRSAPrivateKeyState*)malloc(p_ctx->key_state_size);
         if (!p_rsa_privatekey_ctx) {
             ipp_ret = ippStsMemAllocErr;
             break;
         }
+        p_ctx->p_key_state = p_rsa_privatekey_ctx;
 
         // initialize the private key context
         ipp_ret = ippsRSA_InitPrivateKeyType1(SGX_RSA3072_KEY_SIZE * 8, SGX_RSA3072_PRI_EXP_SIZE * 8,
-            p_rsa_privatekey_ctx, private_key_ctx_size);
+            p_rsa_privatekey_ctx, p_ctx->key_state_size);
         ERROR_BREAK(ipp_ret);
 
         ipp_ret = ippsRSA_SetPrivateKeyType1(p_prikey_mod_bn, p_prikey_d_bn, p_rsa_privatekey_ctx);
         ERROR_BREAK(ipp_ret);
 
         // allocate temp buffer for RSA calculation
-        ipp_ret = ippsRSA_GetBufferSizePrivateKey(&private_key_buffer_size, p_rsa_privatekey_ctx);
+        ipp_ret = ippsRSA_GetBufferSizePrivateKey(&p_ctx->scratch_size, p_rsa_privatekey_ctx);
         ERROR_BREAK(ipp_ret);
 
-        temp_buff = (Ipp8u*)malloc(private_key_buffer_size);
-        if (!temp_buff) {
+        p_ctx->p_scratch = (Ipp8u*)malloc(p_ctx->scratch_size);
+        if (!p_ctx->p_scratch) {
             ipp_ret = ippStsMemAllocErr;
             break;
         }
-
-        // sign the data buffer
-        ipp_ret = ippsRSASign_PKCS1v15(p_data, data_size, *p_signature, p_rsa_privatekey_ctx, NULL, hash_alg, temp_buff);
-
     } while (0);
 
     sgx_ipp_secure_free_BN(p_prikey_mod_bn, sizeof(p_key->mod));
     sgx_ipp_secure_free_BN(p_prikey_d_bn, sizeof(p_key->d));
-    CLEAR_FREE_MEM(p_rsa_privatekey_ctx, private_key_ctx_size);
-    CLEAR_FREE_MEM(temp_buff, private_key_buffer_size);
 
-    switch (ipp_ret)
+    if (ipp_ret != ippStsNoErr)
     {
-    case ippStsNoErr: return SGX_SUCCESS;
-    case ippStsNoMemErr:
-    case ippStsMemAllocErr: return SGX_ERROR_OUT_OF_MEMORY;
-    case ippStsNullPtrErr:
-    case ippStsLengthErr:
-    case ippStsOutOfRangeErr:
-    case ippStsSizeErr:
-    case ippStsBadArgErr: return SGX_ERROR_INVALID_PARAMETER;
-    default: return SGX_ERROR_UNEXPECTED;
+        rsa3072_ctx_free(p_ctx);
+        return ipp_to_sgx_status(ipp_ret);
     }
+    *p_rsa_handle = p_ctx;
+    return SGX_SUCCESS;
 }
 
-sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
+sgx_status_t sgx_rsa3072_sign_ctx(const uint8_t *p_data,
     uint32_t data_size,
-    const sgx_rsa3072_public_key_t *p_public,
-    const sgx_rsa3072_signature_t *p_signature,
-	sgx_rsa_result_t *p_result)
+    sgx_rsa3072_state_handle_t rsa_handle,
+    sgx_rsa3072_signature_t *p_signature)
 {
-    if ((p_data == NULL) || (data_size < 1) || (p_public == NULL) ||
-        (p_signature == NULL) || (p_result == NULL))
+    rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t*)rsa_handle;
+    if ((p_data == NULL) || (data_size < 1) || (p_ctx == NULL) ||
+        (!p_ctx->is_private) || (p_signature == NULL))
     {
         return SGX_ERROR_INVALID_PARAMETER;
     }
-    *p_result = SGX_RSA_INVALID_SIGNATURE;
 
-    IppStatus ipp_ret = ippStsNoErr;
-    IppHashAlgId hash_alg = ippHashAlg_SHA256;
+    // sign the data buffer
+    IppStatus ipp_ret = ippsRSASign_PKCS1v15(p_data, data_size, *p_signature,
+        (IppsRSAPrivateKeyState*)p_ctx->p_key_state, NULL, ippHashAlg_SHA256, p_ctx->p_scratch);
+    return ipp_to_sgx_status(ipp_ret);
+}
 
+sgx_status_t sgx_rsa3072_sign_ctx_close(sgx_rsa3072_state_handle_t rsa_handle)
+{
+    rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t*)rsa_handle;
+    if ((p_ctx == NULL) || (!p_ctx->is_private))
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    rsa3072_ctx_free(p_ctx);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_rsa3072_verify_ctx_init(const sgx_rsa3072_public_key_t *p_public,
+    sgx_rsa3072_state_handle_t *p_rsa_handle)
+{
+    if ((p_public == NULL) || (p_rsa_handle == NULL))
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    IppStatus ipp_ret = ippStsNoErr;
+    rsa3072_ctx_t *p_ctx = NULL;
     IppsRSAPublicKeyState* p_rsa_publickey_ctx = NULL;
-    Ipp8u *temp_buff = NULL;
 
     IppsBigNumState* p_pubkey_mod_bn = NULL;
     IppsBigNumState* p_pubkey_exp_bn = NULL;
 
-    int result = 0;
-
     do
     {
+        p_ctx = (rsa3072_ctx_t*)calloc(1, sizeof(rsa3072_ctx_t));
+        if (!p_ctx) {
+            ipp_ret = ippStsMemAllocErr;
+            break;
+        }
+        p_ctx->is_private = false;
+
         // Initializa IPP BN from the public key
         ipp_ret = sgx_ipp_newBN((const Ipp32u *)p_public->mod, sizeof(p_public->mod), &p_pubkey_mod_bn);
         ERROR_BREAK(ipp_ret);
@@ -150,63 +205,129 @@ sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
         ERROR_BREAK(ipp_ret);
 
         // allocate public key context
-        int public_key_ctx_size = 0;
-
         ipp_ret = ippsRSA_GetSizePublicKey(SGX_RSA3072_KEY_SIZE * 8, SGX_RSA3072_PUB_EXP_SIZE * 8,
-            &public_key_ctx_size);
+            &p_ctx->key_state_size);
         ERROR_BREAK(ipp_ret);
 
-        p_rsa_publickey_ctx = (IppsRSAPublicKeyState*)malloc(public_key_ctx_size);
+        p_rsa_publickey_ctx = (IppsRSAPublicKeyState*)malloc(p_ctx->key_state_size);
         if (!p_rsa_publickey_ctx) {
             ipp_ret = ippStsMemAllocErr;
             break;
         }
+        p_ctx->p_key_state = p_rsa_publickey_ctx;
 
         // initialize the public key context
         ipp_ret = ippsRSA_InitPublicKey(SGX_RSA3072_KEY_SIZE * 8, SGX_RSA3072_PUB_EXP_SIZE * 8,
-            p_rsa_publickey_ctx, public_key_ctx_size);
+            p_rsa_publickey_ctx, p_ctx->key_state_size);
         ERROR_BREAK(ipp_ret);
 
         ipp_ret = ippsRSA_SetPublicKey(p_pubkey_mod_bn, p_pubkey_exp_bn, p_rsa_publickey_ctx);
         ERROR_BREAK(ipp_ret);
 
         // allocate temp buffer for RSA calculation
-        int public_key_buffer_size = 0;
-
-        ipp_ret = ippsRSA_GetBufferSizePublicKey(&public_key_buffer_size, p_rsa_publickey_ctx);
+        ipp_ret = ippsRSA_GetBufferSizePublicKey(&p_ctx->scratch_size, p_rsa_publickey_ctx);
         ERROR_BREAK(ipp_ret);
 
-        temp_buff = (Ipp8u*)malloc(public_key_buffer_size);
-        if (!temp_buff) {
+        p_ctx->p_scratch = (Ipp8u*)malloc(p_ctx->scratch_size);
+        if (!p_ctx->p_scratch) {
             ipp_ret = ippStsMemAllocErr;
             break;
         }
-
-        // verify the signature
-        ipp_ret = ippsRSAVerify_PKCS1v15(p_data, data_size, *p_signature, &result, p_rsa_publickey_ctx, hash_alg, temp_buff);
     } while (0);
 
+    sgx_ipp_secure_free_BN(p_pubkey_mod_bn, sizeof(p_public->mod));
+    sgx_ipp_secure_free_BN(p_pubkey_exp_bn, sizeof(p_public->exp));
+
+    if (ipp_ret != ippStsNoErr)
+    {
+        rsa3072_ctx_free(p_ctx);
+        return ipp_to_sgx_status(ipp_ret);
+    }
+    *p_rsa_handle = p_ctx;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_rsa3072_verify_ctx(const uint8_t *p_data,
+    uint32_t data_size,
+    sgx_rsa3072_state_handle_t rsa_handle,
+    const sgx_rsa3072_signature_t *p_signature,
+    sgx_rsa_result_t *p_result)
+{
+    rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t*)rsa_handle;
+    if ((p_data == NULL) || (data_size < 1) || (p_ctx == NULL) ||
+        (p_ctx->is_private) || (p_signature == NULL) || (p_result == NULL))
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    *p_result = SGX_RSA_INVALID_SIGNATURE;
+
+    int result = 0;
+
+    // verify the signature
+    IppStatus ipp_ret = ippsRSAVerify_PKCS1v15(p_data, data_size, *p_signature, &result,
+        (IppsRSAPublicKeyState*)p_ctx->p_key_state, ippHashAlg_SHA256, p_ctx->p_scratch);
+
     if ((result != 0) && (ipp_ret == ippStsNoErr))
     {
         /* validation pass successfully */
         *p_result = SGX_RSA_VALID;
     }
+    return ipp_to_sgx_status(ipp_ret);
+}
 
-    sgx_ipp_secure_free_BN(p_pubkey_mod_bn, sizeof(p_public->mod));
-    sgx_ipp_secure_free_BN(p_pubkey_exp_bn, sizeof(p_public->exp));
-    SAFE_FREE(p_rsa_publickey_ctx);
-    SAFE_FREE(temp_buff);
+sgx_status_t sgx_rsa3072_verify_ctx_close(sgx_rsa3072_state_handle_t rsa_handle)
+{
+    rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t*)rsa_handle;
+    if ((p_ctx == NULL) || (p_ctx->is_private))
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    rsa3072_ctx_free(p_ctx);
+    return SGX_SUCCESS;
+}
 
-    switch (ipp_ret)
+sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
+    uint32_t data_size,
+    const sgx_rsa3072_key_t * p_key,
+    sgx_rsa3072_signature_t * p_signature)
+{
+    if ((p_data == NULL) || (data_size < 1) || (p_key == NULL) ||
+        (p_signature == NULL) )
     {
-    case ippStsNoErr: return SGX_SUCCESS;
-    case ippStsNoMemErr:
-    case ippStsMemAllocErr: return SGX_ERROR_OUT_OF_MEMORY;
-    case ippStsNullPtrErr:
-    case ippStsLengthErr:
-    case ippStsOutOfRangeErr:
-    case ippStsSizeErr:
-    case ippStsBadArgErr: return SGX_ERROR_INVALID_PARAMETER;
-    default: return SGX_ERROR_UNEXPECTED;
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    sgx_rsa3072_state_handle_t rsa_handle = NULL;
+
+    sgx_status_t ret = sgx_rsa3072_sign_ctx_init(p_key, &rsa_handle);
+    if (ret != SGX_SUCCESS)
+    {
+        return ret;
+    }
+    ret = sgx_rsa3072_sign_ctx(p_data, data_size, rsa_handle, p_signature);
+    sgx_rsa3072_sign_ctx_close(rsa_handle);
+    return ret;
+}
+
+sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
+    uint32_t data_size,
+    const sgx_rsa3072_public_key_t *p_public,
+    const sgx_rsa3072_signature_t *p_signature,
+	sgx_rsa_result_t *p_result)
+{
+    if ((p_data == NULL) || (data_size < 1) || (p_public == NULL) ||
+        (p_signature == NULL) || (p_result == NULL))
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    *p_result = SGX_RSA_INVALID_SIGNATURE;
+    sgx_rsa3072_state_handle_t rsa_handle = NULL;
+
+    sgx_status_t ret = sgx_rsa3072_verify_ctx_init(p_public, &rsa_handle);
+    if (ret != SGX_SUCCESS)
+    {
+        return ret;
     }
+    ret = sgx_rsa3072_verify_ctx(p_data, data_size, rsa_handle, p_signature, p_result);
+    sgx_rsa3072_verify_ctx_close(rsa_handle);
+    return ret;
 }
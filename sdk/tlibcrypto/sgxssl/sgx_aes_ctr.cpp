@@ -57,6 +57,142 @@ static void ctr128_inc(unsigned char *counter)
 	} while (n);
 }
 
+// advances the counter block by the ceil(src_len / 16) blocks used for src_len bytes,
+// as IPP does, so a stream split at multiples of 16 bytes gives the one-shot output
+//
+static void ctr128_advance(unsigned char *counter, uint32_t src_len)
+{
+	uint32_t blocks = src_len / 16 + (src_len % 16 != 0);
+	while (blocks-- > 0) {
+		ctr128_inc(counter);
+	}
+}
+
+/* AES-CTR 128-bit keyed context
+ * The handle is an EVP_CIPHER_CTX holding the expanded key; each call only
+ * reloads the counter block, so the key schedule is reused across calls.
+ */
+sgx_status_t sgx_aes_ctr_init(const sgx_aes_ctr_128bit_key_t *p_key,
+                              sgx_aes_state_handle_t *p_aes_ctr_handle)
+{
+	if ((p_key == NULL) || (p_aes_ctr_handle == NULL)) {
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+
+	EVP_CIPHER_CTX* ptr_ctx = NULL;
+
+	// Create and init ctx
+	//
+	if (!(ptr_ctx = EVP_CIPHER_CTX_new())) {
+		return SGX_ERROR_OUT_OF_MEMORY;
+	}
+
+	// Initialise cipher and key, the counter is supplied on every call
+	//
+	if (1 != EVP_EncryptInit_ex(ptr_ctx, EVP_aes_128_ctr(), NULL, (unsigned char*)p_key, NULL)) {
+		EVP_CIPHER_CTX_free(ptr_ctx);
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	*p_aes_ctr_handle = ptr_ctx;
+	return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_aes_ctr_encrypt_ctx(sgx_aes_state_handle_t aes_ctr_handle, const uint8_t *p_src,
+                                     const uint32_t src_len, uint8_t *p_ctr, const uint32_t ctr_inc_bits,
+                                     uint8_t *p_dst)
+{
+	if ((src_len > INT_MAX) || (aes_ctr_handle == NULL) || (p_src == NULL) || (p_ctr == NULL) || (p_dst == NULL)) {
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+
+	int len = 0;
+	EVP_CIPHER_CTX* ptr_ctx = (EVP_CIPHER_CTX*)aes_ctr_handle;
+
+	// OpenSSL assumes that the counter is in the x lower bits of the IV(ivec), and that the
+	// application has full control over overflow and the rest of the IV. This
+	// implementation takes NO responsibility for checking that the counter
+	// doesn't overflow into the rest of the IV when incremented.
+	//
+	if (ctr_inc_bits != SGXSSL_CTR_BITS) {
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+
+	// Load the counter block, keeping the expanded key
+	//
+	if (1 != EVP_EncryptInit_ex(ptr_ctx, NULL, NULL, NULL, p_ctr)) {
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	// Provide the message to be encrypted, and obtain the encrypted output.
+	//
+	if (1 != EVP_EncryptUpdate(ptr_ctx, p_dst, &len, p_src, src_len)) {
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	// Finalise the encryption
+	//
+	if (1 != EVP_EncryptFinal_ex(ptr_ctx, p_dst + len, &len)) {
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	// Encryption success, increment counter
+	//
+	ctr128_advance(p_ctr, src_len);
+	return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_aes_ctr_decrypt_ctx(sgx_aes_state_handle_t aes_ctr_handle, const uint8_t *p_src,
+                                     const uint32_t src_len, uint8_t *p_ctr, const uint32_t ctr_inc_bits,
+                                     uint8_t *p_dst)
+{
+	if ((src_len > INT_MAX) || (aes_ctr_handle == NULL) || (p_src == NULL) || (p_ctr == NULL) || (p_dst == NULL)) {
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+
+	int len = 0;
+	EVP_CIPHER_CTX* ptr_ctx = (EVP_CIPHER_CTX*)aes_ctr_handle;
+
+	if (ctr_inc_bits != SGXSSL_CTR_BITS) {
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+
+	// Load the counter block, keeping the expanded key
+	//
+	if (!EVP_DecryptInit_ex(ptr_ctx, NULL, NULL, NULL, p_ctr)) {
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	// Decrypt message, obtain the plaintext output
+	//
+	if (!EVP_DecryptUpdate(ptr_ctx, p_dst, &len, p_src, src_len)) {
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	// Finalise the decryption. A positive return value indicates success,
+	// anything else is a failure - the plaintext is not trustworthy.
+	//
+	if (EVP_DecryptFinal_ex(ptr_ctx, p_dst + len, &len) <= 0) {
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	// Success
+	// Increment counter
+	//
+	ctr128_advance(p_ctr, src_len);
+	return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_aes_ctr_close(sgx_aes_state_handle_t aes_ctr_handle)
+{
+	// EVP_CIPHER_CTX_free clears the key schedule
+	//
+	if (aes_ctr_handle != NULL) {
+		EVP_CIPHER_CTX_free((EVP_CIPHER_CTX*)aes_ctr_handle);
+	}
+	return SGX_SUCCESS;
+}
+
 /* AES-CTR 128-bit
  * Parameters:
  *   Return:
@@ -80,63 +216,19 @@ sgx_status_t sgx_aes_ctr_encrypt(const sgx_aes_ctr_128bit_key_t *p_key, const ui
 		return SGX_ERROR_INVALID_PARAMETER;
 	}
 
-	/* SGXSSL based crypto implementation */
-	sgx_status_t ret = SGX_ERROR_UNEXPECTED;
-	int len = 0;
-	EVP_CIPHER_CTX* ptr_ctx = NULL;
-
-	// OpenSSL assumes that the counter is in the x lower bits of the IV(ivec), and that the
-	// application has full control over overflow and the rest of the IV. This
-	// implementation takes NO responsibility for checking that the counter
-	// doesn't overflow into the rest of the IV when incremented.
-	//
 	if (ctr_inc_bits != SGXSSL_CTR_BITS)
 	{
 		return SGX_ERROR_INVALID_PARAMETER;
 	}
 
-
-	do {
-		// Create and init ctx
-		//
-		if (!(ptr_ctx = EVP_CIPHER_CTX_new())) {
-			ret = SGX_ERROR_OUT_OF_MEMORY;
-			break;
-		}
-
-		// Initialise encrypt, key
-		//
-		if (1 != EVP_EncryptInit_ex(ptr_ctx, EVP_aes_128_ctr(), NULL, (unsigned char*)p_key, p_ctr)) {
-			break;
-		}
-
-		// Provide the message to be encrypted, and obtain the encrypted output.
-		//
-		if (1 != EVP_EncryptUpdate(ptr_ctx, p_dst, &len, p_src, src_len)) {
-			break;
-		}
-
-		// Finalise the encryption
-		//
-		if (1 != EVP_EncryptFinal_ex(ptr_ctx, p_dst + len, &len)) {
-			break;
-		}
-
-		// Encryption success, increment counter
-		//
-		len = src_len;
-		while (len >= 0) {
-			ctr128_inc(p_ctr);
-			len -= 16;
-		}
-		ret = SGX_SUCCESS;
-	} while (0);
-
-	//clean up ctx and return
-	//
-	if (ptr_ctx) {
-		EVP_CIPHER_CTX_free(ptr_ctx);
+	/* SGXSSL based crypto implementation */
+	sgx_aes_state_handle_t aes_ctr_handle = NULL;
+	sgx_status_t ret = sgx_aes_ctr_init(p_key, &aes_ctr_handle);
+	if (ret != SGX_SUCCESS) {
+		return ret;
 	}
+	ret = sgx_aes_ctr_encrypt_ctx(aes_ctr_handle, p_src, src_len, p_ctr, ctr_inc_bits, p_dst);
+	sgx_aes_ctr_close(aes_ctr_handle);
 	return ret;
 }
 
@@ -150,61 +242,17 @@ sgx_status_t sgx_aes_ctr_decrypt(const sgx_aes_ctr_128bit_key_t *p_key, const ui
 		return SGX_ERROR_INVALID_PARAMETER;
 	}
 
-	/* SGXSSL based crypto implementation */
-	sgx_status_t ret = SGX_ERROR_UNEXPECTED;
-	int len = 0;
-	EVP_CIPHER_CTX* ptr_ctx = NULL;
-
-	// OpenSSL assumes that the counter is in the x lower bits of the IV(ivec), and that the
-	// application has full control over overflow and the rest of the IV. This
-	// implementation takes NO responsibility for checking that the counter
-	// doesn't overflow into the rest of the IV when incremented.
-	//
 	if (ctr_inc_bits != SGXSSL_CTR_BITS) {
 		return SGX_ERROR_INVALID_PARAMETER;
 	}
 
-	do {
-		// Create and initialise the context
-		//
-		if (!(ptr_ctx = EVP_CIPHER_CTX_new())) {
-			ret = SGX_ERROR_OUT_OF_MEMORY;
-			break;
-		}
-
-		// Initialise decrypt, key and CTR
-		//
-		if (!EVP_DecryptInit_ex(ptr_ctx, EVP_aes_128_ctr(), NULL, (unsigned char*)p_key, p_ctr)) {
-			break;
-		}
-
-		// Decrypt message, obtain the plaintext output
-		//
-		if (!EVP_DecryptUpdate(ptr_ctx, p_dst, &len, p_src, src_len)) {
-			break;
-		}
-
-		// Finalise the decryption. A positive return value indicates success,
-		// anything else is a failure - the plaintext is not trustworthy.
-		//
-		if (EVP_DecryptFinal_ex(ptr_ctx, p_dst + len, &len) <= 0) { // same notes as above - you can't write beyond src_len
-			break;
-		}
-		// Success
-		// Increment counter
-		//
-		len = src_len;
-		while (len >= 0) {
-			ctr128_inc(p_ctr);
-			len -= 16;
-		}
-		ret = SGX_SUCCESS;
-	} while (0);
-
-	//cleanup ctx, and return
-	//
-	if (ptr_ctx) {
-		EVP_CIPHER_CTX_free(ptr_ctx);
+	/* SGXSSL based crypto implementation */
+	sgx_aes_state_handle_t aes_ctr_handle = NULL;
+	sgx_status_t ret = sgx_aes_ctr_init(p_key, &aes_ctr_handle);
+	if (ret != SGX_SUCCESS) {
+		return ret;
 	}
+	ret = sgx_aes_ctr_decrypt_ctx(aes_ctr_handle, p_src, src_len, p_ctr, ctr_inc_bits, p_dst);
+	sgx_aes_ctr_close(aes_ctr_handle);
 	return ret;
 }
@@ -29,6 +29,7 @@
  *
  */
 
+#include "stdlib.h"
 #include "sgx_tcrypto.h"
 #include <openssl/bn.h>
 #include <openssl/rsa.h>
@@ -36,27 +37,78 @@
 #include <openssl/err.h>
 #include "se_tcrypto_common.h"
 
-sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
-	uint32_t data_size,
-	const sgx_rsa3072_key_t * p_key,
-	sgx_rsa3072_signature_t * p_signature)
+/* Keyed RSA 3072 context: the imported EVP key and a digest context that is
+ * reset and reused for every sign/verify call.
+ */
+typedef struct _rsa3072_ctx_t
 {
-	if ((p_data == NULL) || (data_size < 1) || (p_key == NULL) ||
-		(p_signature == NULL))
+	bool is_private;
+	EVP_PKEY *pkey;
+	EVP_MD_CTX *md_ctx;
+} rsa3072_ctx_t;
+
+static void rsa3072_ctx_free(rsa3072_ctx_t *p_ctx)
+{
+	if (p_ctx == NULL)
+		return;
+	if (p_ctx->md_ctx)
+		EVP_MD_CTX_free(p_ctx->md_ctx);
+	if (p_ctx->pkey)
+		EVP_PKEY_free(p_ctx->pkey);
+	free(p_ctx);
+}
+
+// wraps the RSA key into a new context, taking ownership of rsa_key on success
+//
+static sgx_status_t rsa3072_ctx_new(RSA *rsa_key, bool is_private, rsa3072_ctx_t **pp_ctx)
+{
+	rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t *)calloc(1, sizeof(rsa3072_ctx_t));
+	if (p_ctx == NULL) {
+		return SGX_ERROR_OUT_OF_MEMORY;
+	}
+	p_ctx->is_private = is_private;
+
+	// allocates an empty EVP_PKEY structure
+	//
+	p_ctx->pkey = EVP_PKEY_new();
+	if (p_ctx->pkey == NULL) {
+		rsa3072_ctx_free(p_ctx);
+		return SGX_ERROR_OUT_OF_MEMORY;
+	}
+
+	// allocates, initializes and returns a digest context
+	//
+	p_ctx->md_ctx = EVP_MD_CTX_new();
+	if (p_ctx->md_ctx == NULL) {
+		rsa3072_ctx_free(p_ctx);
+		return SGX_ERROR_OUT_OF_MEMORY;
+	}
+
+	// set the referenced key to rsa_key, however these use the supplied key internally and so key will be freed when the parent pkey is freed
+	//
+	if (EVP_PKEY_assign_RSA(p_ctx->pkey, rsa_key) != 1) {
+		rsa3072_ctx_free(p_ctx);
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+	*pp_ctx = p_ctx;
+	return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_rsa3072_sign_ctx_init(const sgx_rsa3072_key_t *p_key,
+	sgx_rsa3072_state_handle_t *p_rsa_handle)
+{
+	if ((p_key == NULL) || (p_rsa_handle == NULL))
 	{
 		return SGX_ERROR_INVALID_PARAMETER;
 	}
 
 	sgx_status_t retval = SGX_ERROR_UNEXPECTED;
 	RSA *priv_rsa_key = NULL;
-	EVP_PKEY* priv_pkey = NULL;
+	rsa3072_ctx_t *p_ctx = NULL;
 	BIGNUM *n = NULL;
 	BIGNUM *d = NULL;
 	BIGNUM *e = NULL;
-	EVP_MD_CTX* ctx = NULL;
-	const EVP_MD* sha256_md = NULL;
-	size_t siglen = SGX_RSA3072_KEY_SIZE;
-	int ret = 0;
 
 	do {
 		// converts the modulus value of rsa key, represented as positive integer in little-endian into a BIGNUM
@@ -91,32 +143,53 @@ sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
 		// sets the modulus, private exp and public exp values of the RSA key
 		//
 		if (RSA_set0_key(priv_rsa_key, n, e, d) != 1) {
-			BN_clear_free(n);
-			BN_clear_free(d);
-			BN_clear_free(e);
 			break;
 		}
+		n = NULL;
+		d = NULL;
+		e = NULL;
 
-		// allocates an empty EVP_PKEY structure
-		//
-		priv_pkey = EVP_PKEY_new();
-		if (priv_pkey == NULL) {
-			retval = SGX_ERROR_OUT_OF_MEMORY;
+		retval = rsa3072_ctx_new(priv_rsa_key, true, &p_ctx);
+		if (retval != SGX_SUCCESS) {
 			break;
 		}
+		priv_rsa_key = NULL;
+	} while (0);
 
-		// set the referenced key to pub_rsa_key, however these use the supplied key internally and so key will be freed when the parent pkey is freed
-		//
-		if (EVP_PKEY_assign_RSA(priv_pkey, priv_rsa_key) != 1) {
-			RSA_free(priv_rsa_key);
-			break;
-		}
+	if (priv_rsa_key)
+		RSA_free(priv_rsa_key);
+	if (n)
+		BN_clear_free(n);
+	if (d)
+		BN_clear_free(d);
+	if (e)
+		BN_clear_free(e);
+
+	if (retval == SGX_SUCCESS)
+		*p_rsa_handle = p_ctx;
+	return retval;
+}
 
-		// allocates, initializes and returns a digest context
+sgx_status_t sgx_rsa3072_sign_ctx(const uint8_t *p_data,
+	uint32_t data_size,
+	sgx_rsa3072_state_handle_t rsa_handle,
+	sgx_rsa3072_signature_t *p_signature)
+{
+	rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t *)rsa_handle;
+	if ((p_data == NULL) || (data_size < 1) || (p_ctx == NULL) ||
+		(!p_ctx->is_private) || (p_signature == NULL))
+	{
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+
+	sgx_status_t retval = SGX_ERROR_UNEXPECTED;
+	const EVP_MD* sha256_md = NULL;
+	size_t siglen = SGX_RSA3072_KEY_SIZE;
+
+	do {
+		// drops the state of the previous operation, keeping the allocation
 		//
-		ctx = EVP_MD_CTX_new();
-		if (NULL == ctx) {
-			retval = SGX_ERROR_OUT_OF_MEMORY;
+		if (EVP_MD_CTX_reset(p_ctx->md_ctx) != 1) {
 			break;
 		}
 
@@ -129,20 +202,19 @@ sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
 
 		// sets up signing context ctx to use digest type
 		//
-		if (EVP_DigestSignInit(ctx, NULL, sha256_md, NULL, priv_pkey) <= 0) {
+		if (EVP_DigestSignInit(p_ctx->md_ctx, NULL, sha256_md, NULL, p_ctx->pkey) <= 0) {
 			break;
 		}
 
 		// hashes data_size bytes of data at p_data into the signature context ctx
 		//
-		if (EVP_DigestSignUpdate(ctx, (const void *)p_data, data_size) <= 0) {
+		if (EVP_DigestSignUpdate(p_ctx->md_ctx, (const void *)p_data, data_size) <= 0) {
 			break;
 		}
 
 		// signs the data in ctx places the signature in p_signature.
 		//
-		ret = EVP_DigestSignFinal(ctx, (unsigned char *)p_signature, &siglen);//fails
-		if (ret <= 0) {
+		if (EVP_DigestSignFinal(p_ctx->md_ctx, (unsigned char *)p_signature, &siglen) <= 0) {
 			break;
 		}
 
@@ -155,52 +227,33 @@ sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
 		retval = SGX_SUCCESS;
 	} while (0);
 
-	if (ctx)
-		EVP_MD_CTX_free(ctx);
-	if (priv_pkey) {
-		EVP_PKEY_free(priv_pkey);
-		priv_rsa_key = NULL;
-		n = NULL;
-		d = NULL;
-		e = NULL;
-	}
-	if (priv_rsa_key) {
-		RSA_free(priv_rsa_key);
-		n = NULL;
-		d = NULL;
-		e = NULL;
-	}
-	if (n)
-		BN_clear_free(n);
-	if (d)
-		BN_clear_free(d);
-	if (e)
-		BN_clear_free(e);
-
 	return retval;
 }
 
-sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
-	uint32_t data_size,
-	const sgx_rsa3072_public_key_t *p_public,
-	const sgx_rsa3072_signature_t *p_signature,
-	sgx_rsa_result_t *p_result)
+sgx_status_t sgx_rsa3072_sign_ctx_close(sgx_rsa3072_state_handle_t rsa_handle)
 {
-	if ((p_data == NULL) || (data_size < 1) || (p_public == NULL) ||
-		(p_signature == NULL) || (p_result == NULL))
+	rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t *)rsa_handle;
+	if ((p_ctx == NULL) || (!p_ctx->is_private))
+	{
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+	rsa3072_ctx_free(p_ctx);
+	return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_rsa3072_verify_ctx_init(const sgx_rsa3072_public_key_t *p_public,
+	sgx_rsa3072_state_handle_t *p_rsa_handle)
+{
+	if ((p_public == NULL) || (p_rsa_handle == NULL))
 	{
 		return SGX_ERROR_INVALID_PARAMETER;
 	}
-	*p_result = SGX_RSA_INVALID_SIGNATURE;
 
 	sgx_status_t retval = SGX_ERROR_UNEXPECTED;
-	int verified = 0;
 	RSA *pub_rsa_key = NULL;
-	EVP_PKEY *pub_pkey = NULL;
+	rsa3072_ctx_t *p_ctx = NULL;
 	BIGNUM *n = NULL;
 	BIGNUM *e = NULL;
-	const EVP_MD* sha256_md = NULL;
-	EVP_MD_CTX *ctx = NULL;
 
 	do {
 		// converts the modulus value of rsa key, represented as positive integer in little-endian into a BIGNUM
@@ -228,31 +281,52 @@ sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
 		// sets the modulus and public exp values of the RSA key
 		//
 		if (RSA_set0_key(pub_rsa_key, n, e, NULL) != 1) {
-			BN_clear_free(n);
-			BN_clear_free(e);
 			break;
 		}
+		n = NULL;
+		e = NULL;
 
-		// allocates an empty EVP_PKEY structure
-		//
-		pub_pkey = EVP_PKEY_new();
-		if (pub_pkey == NULL) {
-			retval = SGX_ERROR_OUT_OF_MEMORY;
+		retval = rsa3072_ctx_new(pub_rsa_key, false, &p_ctx);
+		if (retval != SGX_SUCCESS) {
 			break;
 		}
+		pub_rsa_key = NULL;
+	} while (0);
 
-		// set the referenced key to pub_rsa_key, however these use the supplied key internally and so key will be freed when the parent pkey is freed
-		//
-		if (EVP_PKEY_assign_RSA(pub_pkey, pub_rsa_key) != 1) {
-			RSA_free(pub_rsa_key);
-			break;
-		}
+	if (pub_rsa_key)
+		RSA_free(pub_rsa_key);
+	if (n)
+		BN_clear_free(n);
+	if (e)
+		BN_clear_free(e);
+
+	if (retval == SGX_SUCCESS)
+		*p_rsa_handle = p_ctx;
+	return retval;
+}
 
-		// allocates, initializes and returns a digest context
+sgx_status_t sgx_rsa3072_verify_ctx(const uint8_t *p_data,
+	uint32_t data_size,
+	sgx_rsa3072_state_handle_t rsa_handle,
+	const sgx_rsa3072_signature_t *p_signature,
+	sgx_rsa_result_t *p_result)
+{
+	rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t *)rsa_handle;
+	if ((p_data == NULL) || (data_size < 1) || (p_ctx == NULL) ||
+		(p_ctx->is_private) || (p_signature == NULL) || (p_result == NULL))
+	{
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+	*p_result = SGX_RSA_INVALID_SIGNATURE;
+
+	sgx_status_t retval = SGX_ERROR_UNEXPECTED;
+	int verified = 0;
+	const EVP_MD* sha256_md = NULL;
+
+	do {
+		// drops the state of the previous operation, keeping the allocation
 		//
-		ctx = EVP_MD_CTX_new();
-		if (ctx == NULL) {
-			retval = SGX_ERROR_OUT_OF_MEMORY;
+		if (EVP_MD_CTX_reset(p_ctx->md_ctx) != 1) {
 			break;
 		}
 
@@ -265,21 +339,23 @@ sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
 
 		// sets up verification context ctx to use digest type
 		//
-		if (EVP_DigestVerifyInit(ctx, NULL, sha256_md, NULL, pub_pkey) <= 0) {
+		if (EVP_DigestVerifyInit(p_ctx->md_ctx, NULL, sha256_md, NULL, p_ctx->pkey) <= 0) {
 			break;
 		}
 
 		// hashes data_size bytes of data at p_data into the verification context ctx.
 		// this function can be called several times on the same ctx to hash additional data
 		//
-		if (EVP_DigestVerifyUpdate(ctx, (const void *)p_data, data_size) <= 0) {
+		if (EVP_DigestVerifyUpdate(p_ctx->md_ctx, (const void *)p_data, data_size) <= 0) {
 			break;
 		}
 
 		// verifies the data in ctx against the signature in p_signature of length SGX_RSA3072_KEY_SIZE
 		//
-		verified = EVP_DigestVerifyFinal(ctx, (const unsigned char *)p_signature, SGX_RSA3072_KEY_SIZE);
-		if (verified) {
+		// returns 1 for a valid signature, 0 for an invalid one and a negative value on error
+		//
+		verified = EVP_DigestVerifyFinal(p_ctx->md_ctx, (const unsigned char *)p_signature, SGX_RSA3072_KEY_SIZE);
+		if (verified == 1) {
 			*p_result = SGX_RSA_VALID;
 		}
 		else if (verified != 0) {
@@ -289,23 +365,60 @@ sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
 		retval = SGX_SUCCESS;
 	} while (0);
 
-	if (ctx)
-		EVP_MD_CTX_free(ctx);
-	if (pub_pkey) {
-		EVP_PKEY_free(pub_pkey);
-		pub_rsa_key = NULL;
-		n = NULL;
-		e = NULL;
+	return retval;
+}
+
+sgx_status_t sgx_rsa3072_verify_ctx_close(sgx_rsa3072_state_handle_t rsa_handle)
+{
+	rsa3072_ctx_t *p_ctx = (rsa3072_ctx_t *)rsa_handle;
+	if ((p_ctx == NULL) || (p_ctx->is_private))
+	{
+		return SGX_ERROR_INVALID_PARAMETER;
 	}
-	if (pub_rsa_key) {
-		RSA_free(pub_rsa_key);
-		n = NULL;
-		e = NULL;
+	rsa3072_ctx_free(p_ctx);
+	return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_rsa3072_sign(const uint8_t * p_data,
+	uint32_t data_size,
+	const sgx_rsa3072_key_t * p_key,
+	sgx_rsa3072_signature_t * p_signature)
+{
+	if ((p_data == NULL) || (data_size < 1) || (p_key == NULL) ||
+		(p_signature == NULL))
+	{
+		return SGX_ERROR_INVALID_PARAMETER;
 	}
-	if (n)
-		BN_clear_free(n);
-	if (e)
-		BN_clear_free(e);
+	sgx_rsa3072_state_handle_t rsa_handle = NULL;
+
+	sgx_status_t retval = sgx_rsa3072_sign_ctx_init(p_key, &rsa_handle);
+	if (retval != SGX_SUCCESS)
+		return retval;
+	retval = sgx_rsa3072_sign_ctx(p_data, data_size, rsa_handle, p_signature);
+	sgx_rsa3072_sign_ctx_close(rsa_handle);
+
+	return retval;
+}
+
+sgx_status_t sgx_rsa3072_verify(const uint8_t *p_data,
+	uint32_t data_size,
+	const sgx_rsa3072_public_key_t *p_public,
+	const sgx_rsa3072_signature_t *p_signature,
+	sgx_rsa_result_t *p_result)
+{
+	if ((p_data == NULL) || (data_size < 1) || (p_public == NULL) ||
+		(p_signature == NULL) || (p_result == NULL))
+	{
+		return SGX_ERROR_INVALID_PARAMETER;
+	}
+	*p_result = SGX_RSA_INVALID_SIGNATURE;
+	sgx_rsa3072_state_handle_t rsa_handle = NULL;
+
+	sgx_status_t retval = sgx_rsa3072_verify_ctx_init(p_public, &rsa_handle);
+	if (retval != SGX_SUCCESS)
+		return retval;
+	retval = sgx_rsa3072_verify_ctx(p_data, data_size, rsa_handle, p_signature, p_result);
+	sgx_rsa3072_verify_ctx_close(rsa_handle);
 
 	return retval;
 }
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Encrypts a stream of records of 64 bytes to 16KB, each with its own call,
+ * once with the one-shot sgx_aes_ctr_encrypt and once with a keyed context.
+ * Checks that both give the same cipher text and final counter, and that
+ * the context decrypts it back record by record. The records per second of
+ * both are printed per record size.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sgx_tcrypto.h"
+#ifndef USE_SGXSSL
+#include "ippcp.h"
+#endif
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define CTR_INC_BITS    128
+#define STREAM_SIZE     (2 * 1024 * 1024)   /* bytes per record size and method */
+
+static const sgx_aes_ctr_128bit_key_t g_key = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static const uint8_t g_ctr0[16] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0x00
+};
+
+static const uint32_t g_record_sizes[] = { 64, 256, 1024, 4096, 16384 };
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void run_records(sgx_aes_state_handle_t handle, uint32_t record_size,
+                        const uint8_t *src, uint8_t *oneshot, uint8_t *keyed, uint8_t *plain)
+{
+    uint32_t records = STREAM_SIZE / record_size;
+    uint8_t ctr[16], ctr_ctx[16];
+
+    memcpy(ctr, g_ctr0, sizeof(ctr));
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < records; i++)
+        CHECK(sgx_aes_ctr_encrypt(&g_key, src + i * record_size, record_size, ctr, CTR_INC_BITS,
+                                  oneshot + i * record_size) == SGX_SUCCESS);
+    uint64_t oneshot_ns = now_ns() - start;
+
+    memcpy(ctr_ctx, g_ctr0, sizeof(ctr_ctx));
+    start = now_ns();
+    for (uint32_t i = 0; i < records; i++)
+        CHECK(sgx_aes_ctr_encrypt_ctx(handle, src + i * record_size, record_size, ctr_ctx, CTR_INC_BITS,
+                                      keyed + i * record_size) == SGX_SUCCESS);
+    uint64_t keyed_ns = now_ns() - start;
+
+    CHECK(memcmp(oneshot, keyed, STREAM_SIZE) == 0);
+    CHECK(memcmp(ctr, ctr_ctx, sizeof(ctr)) == 0);
+
+    memcpy(ctr_ctx, g_ctr0, sizeof(ctr_ctx));
+    for (uint32_t i = 0; i < records; i++)
+        CHECK(sgx_aes_ctr_decrypt_ctx(handle, keyed + i * record_size, record_size, ctr_ctx, CTR_INC_BITS,
+                                      plain + i * record_size) == SGX_SUCCESS);
+    CHECK(memcmp(plain, src, STREAM_SIZE) == 0);
+    CHECK(memcmp(ctr, ctr_ctx, sizeof(ctr)) == 0);
+
+    printf("  %5u bytes: one-shot %9.0f records/s, keyed %9.0f records/s (x%.2f)\n", record_size,
+           (double)records * 1e9 / (double)oneshot_ns, (double)records * 1e9 / (double)keyed_ns,
+           (double)oneshot_ns / (double)keyed_ns);
+}
+
+int main(void)
+{
+#ifndef USE_SGXSSL
+    CHECK(ippcpInit() == ippStsNoErr);
+#endif
+    uint8_t *src = (uint8_t *)malloc(STREAM_SIZE);
+    uint8_t *oneshot = (uint8_t *)malloc(STREAM_SIZE);
+    uint8_t *keyed = (uint8_t *)malloc(STREAM_SIZE);
+    uint8_t *plain = (uint8_t *)malloc(STREAM_SIZE);
+    CHECK(src != NULL && oneshot != NULL && keyed != NULL && plain != NULL);
+    for (size_t i = 0; i < STREAM_SIZE; i++)
+        src[i] = (uint8_t)(i * 13 + 5);
+
+    sgx_aes_state_handle_t handle = NULL;
+    CHECK(sgx_aes_ctr_init(&g_key, &handle) == SGX_SUCCESS);
+
+#ifdef USE_SGXSSL
+    printf("aes_ctr_record_test (sgxssl): %d bytes per record size\n", STREAM_SIZE);
+#else
+    printf("aes_ctr_record_test (ipp): %d bytes per record size\n", STREAM_SIZE);
+#endif
+    for (size_t i = 0; i < sizeof(g_record_sizes) / sizeof(g_record_sizes[0]); i++)
+        run_records(handle, g_record_sizes[i], src, oneshot, keyed, plain);
+
+    CHECK(sgx_aes_ctr_close(handle) == SGX_SUCCESS);
+    free(src);
+    free(oneshot);
+    free(keyed);
+    free(plain);
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Checks that an AES-CTR stream split into calls of whole blocks gives the
+ * same output and the same final counter block as one call over the whole
+ * stream, for the one-shot functions and for a keyed context, and that the
+ * counter is advanced by exactly ceil(src_len / 16) blocks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sgx_tcrypto.h"
+#ifndef USE_SGXSSL
+#include "ippcp.h"
+#endif
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define CTR_INC_BITS    128
+#define STREAM_SIZE     1000    /* ends with a partial block */
+
+static const sgx_aes_ctr_128bit_key_t g_key = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+/* the low bytes carry over on the first blocks */
+static const uint8_t g_ctr0[16] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xff, 0xfe
+};
+
+/* chunks in bytes, all multiples of 16 except the last */
+static const uint32_t g_chunks[] = { 16, 32, 64, 16, 128, 736, 8 };
+
+static uint8_t g_src[STREAM_SIZE];
+
+static void ctr_add(uint8_t *ctr, uint32_t blocks)
+{
+    while (blocks-- > 0)
+    {
+        for (int n = 15; n >= 0 && ++ctr[n] == 0; n--)
+            ;
+    }
+}
+
+static void check_counter_advance(sgx_aes_state_handle_t handle)
+{
+    static const uint32_t sizes[] = { 1, 15, 16, 17, 32, 33, 1000 };
+    uint8_t dst[STREAM_SIZE];
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        uint8_t ctr[16], expected[16];
+        memcpy(ctr, g_ctr0, sizeof(ctr));
+        memcpy(expected, g_ctr0, sizeof(expected));
+        ctr_add(expected, (sizes[i] + 15) / 16);
+
+        CHECK(sgx_aes_ctr_encrypt(&g_key, g_src, sizes[i], ctr, CTR_INC_BITS, dst) == SGX_SUCCESS);
+        CHECK(memcmp(ctr, expected, sizeof(ctr)) == 0);
+
+        memcpy(ctr, g_ctr0, sizeof(ctr));
+        CHECK(sgx_aes_ctr_encrypt_ctx(handle, g_src, sizes[i], ctr, CTR_INC_BITS, dst) == SGX_SUCCESS);
+        CHECK(memcmp(ctr, expected, sizeof(ctr)) == 0);
+    }
+}
+
+int main(void)
+{
+#ifndef USE_SGXSSL
+    CHECK(ippcpInit() == ippStsNoErr);
+#endif
+    for (size_t i = 0; i < sizeof(g_src); i++)
+        g_src[i] = (uint8_t)(i * 13 + 5);
+
+    sgx_aes_state_handle_t handle = NULL;
+    CHECK(sgx_aes_ctr_init(&g_key, &handle) == SGX_SUCCESS);
+
+    check_counter_advance(handle);
+
+    /* one call over the whole stream */
+    uint8_t whole[STREAM_SIZE], whole_ctr[16];
+    memcpy(whole_ctr, g_ctr0, sizeof(whole_ctr));
+    CHECK(sgx_aes_ctr_encrypt(&g_key, g_src, STREAM_SIZE, whole_ctr, CTR_INC_BITS, whole) == SGX_SUCCESS);
+
+    /* the same stream in chunks, with the one-shot function and with the context */
+    uint8_t split[STREAM_SIZE], split_ctx[STREAM_SIZE];
+    uint8_t ctr[16], ctr_ctx[16];
+    memcpy(ctr, g_ctr0, sizeof(ctr));
+    memcpy(ctr_ctx, g_ctr0, sizeof(ctr_ctx));
+    uint32_t offset = 0;
+    for (size_t i = 0; i < sizeof(g_chunks) / sizeof(g_chunks[0]); i++)
+    {
+        CHECK(sgx_aes_ctr_encrypt(&g_key, g_src + offset, g_chunks[i], ctr, CTR_INC_BITS,
+                                  split + offset) == SGX_SUCCESS);
+        CHECK(sgx_aes_ctr_encrypt_ctx(handle, g_src + offset, g_chunks[i], ctr_ctx, CTR_INC_BITS,
+                                      split_ctx + offset) == SGX_SUCCESS);
+        offset += g_chunks[i];
+    }
+    CHECK(offset == STREAM_SIZE);
+    CHECK(memcmp(split, whole, sizeof(whole)) == 0);
+    CHECK(memcmp(split_ctx, whole, sizeof(whole)) == 0);
+    CHECK(memcmp(ctr, whole_ctr, sizeof(ctr)) == 0);
+    CHECK(memcmp(ctr_ctx, whole_ctr, sizeof(ctr_ctx)) == 0);
+
+    /* decrypting in chunks gives the plain text back */
+    uint8_t plain[STREAM_SIZE];
+    memcpy(ctr_ctx, g_ctr0, sizeof(ctr_ctx));
+    offset = 0;
+    for (size_t i = 0; i < sizeof(g_chunks) / sizeof(g_chunks[0]); i++)
+    {
+        CHECK(sgx_aes_ctr_decrypt_ctx(handle, whole + offset, g_chunks[i], ctr_ctx, CTR_INC_BITS,
+                                      plain + offset) == SGX_SUCCESS);
+        offset += g_chunks[i];
+    }
+    CHECK(memcmp(plain, g_src, sizeof(g_src)) == 0);
+    CHECK(memcmp(ctr_ctx, whole_ctr, sizeof(ctr_ctx)) == 0);
+
+    CHECK(sgx_aes_ctr_close(handle) == SGX_SUCCESS);
+
+#ifdef USE_SGXSSL
+    printf("aes_ctr_split_test (sgxssl): %d bytes in %zu chunks\n", STREAM_SIZE, sizeof(g_chunks) / sizeof(g_chunks[0]));
+#else
+    printf("aes_ctr_split_test (ipp): %d bytes in %zu chunks\n", STREAM_SIZE, sizeof(g_chunks) / sizeof(g_chunks[0]));
+#endif
+    return 0;
+}
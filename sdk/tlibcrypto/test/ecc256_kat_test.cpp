@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Known answer tests for the P-256 functions: the public key of a fixed
+ * private key, and an ECDSA signature over fixed data (RFC 6979, A.2.5).
+ * With the IPP backend the checks are repeated on a context without the
+ * bound generator table, which must give the same answers. Ends with a
+ * handshake rate: a key pair, a shared DH key and a sign/verify per loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sgx_tcrypto.h"
+#ifndef USE_SGXSSL
+#include "ippcp.h"
+#endif
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define HANDSHAKES  200
+
+/* RFC 6979 A.2.5, big endian */
+static const char g_priv_hex[] = "C9AFA9D845BA75166B5C215767B1D6934E50C3DB36E89B127B8A622B120F6721";
+static const char g_pubx_hex[] = "60FED4BA255A9D31C961EB74C6356D68C049B8923B61FA6CE669622E60F29FB6";
+static const char g_puby_hex[] = "7903FE1008B8BC99A41AE9E95628BC64F2F1B20C2D7E9F5177A3C294D4462299";
+/* SHA-256, message "sample" */
+static const char g_sigr_hex[] = "EFD48B2AACB6A8FD1140DD9CD45E81D69D2C877B56AAF991C34D0EA84EAF3716";
+static const char g_sigs_hex[] = "F7CB1C942D657C41D436C7A1B6E29F65F3E900DBB9AFF4064DC4AB2F843ACDA8";
+static const uint8_t g_msg[] = { 's', 'a', 'm', 'p', 'l', 'e' };
+
+/* big endian hex to the little endian byte order of the sgx_ec256 types */
+static void hex_to_le(const char *hex, uint8_t *out)
+{
+    for (int i = 0; i < SGX_ECP256_KEY_SIZE; i++)
+    {
+        unsigned int byte = 0;
+        CHECK(sscanf(hex + 2 * i, "%2x", &byte) == 1);
+        out[SGX_ECP256_KEY_SIZE - 1 - i] = (uint8_t)byte;
+    }
+}
+
+static void load_signature(sgx_ec256_signature_t *sig)
+{
+    uint8_t le[SGX_ECP256_KEY_SIZE];
+    hex_to_le(g_sigr_hex, le);
+    memcpy(sig->x, le, sizeof(sig->x));
+    hex_to_le(g_sigs_hex, le);
+    memcpy(sig->y, le, sizeof(sig->y));
+}
+
+static void check_fixed_vectors(sgx_ecc_state_handle_t handle, const sgx_ec256_public_t *pub)
+{
+    uint8_t result = SGX_EC_INVALID_SIGNATURE;
+    sgx_ec256_signature_t sig;
+    load_signature(&sig);
+
+    int valid = 0;
+    CHECK(sgx_ecc256_check_point(pub, handle, &valid) == SGX_SUCCESS);
+    CHECK(valid == 1);
+
+    CHECK(sgx_ecdsa_verify(g_msg, sizeof(g_msg), pub, &sig, &result, handle) == SGX_SUCCESS);
+    CHECK(result == SGX_EC_VALID);
+
+    /* a flipped bit in r, in s or in the message is rejected */
+    sig.x[0] ^= 1;
+    result = SGX_EC_VALID;
+    sgx_status_t ret = sgx_ecdsa_verify(g_msg, sizeof(g_msg), pub, &sig, &result, handle);
+    CHECK(ret != SGX_SUCCESS || result != SGX_EC_VALID);
+    sig.x[0] ^= 1;
+    sig.y[7] ^= 0x80000000;
+    result = SGX_EC_VALID;
+    ret = sgx_ecdsa_verify(g_msg, sizeof(g_msg), pub, &sig, &result, handle);
+    CHECK(ret != SGX_SUCCESS || result != SGX_EC_VALID);
+    sig.y[7] ^= 0x80000000;
+    uint8_t msg[sizeof(g_msg)];
+    memcpy(msg, g_msg, sizeof(msg));
+    msg[0] ^= 1;
+    result = SGX_EC_VALID;
+    ret = sgx_ecdsa_verify(msg, sizeof(msg), pub, &sig, &result, handle);
+    CHECK(ret != SGX_SUCCESS || result != SGX_EC_VALID);
+}
+
+static void check_sign_verify(sgx_ecc_state_handle_t handle, sgx_ec256_private_t *priv,
+                              const sgx_ec256_public_t *pub)
+{
+    sgx_ec256_signature_t sig;
+    uint8_t result = SGX_EC_INVALID_SIGNATURE;
+
+    CHECK(sgx_ecdsa_sign(g_msg, sizeof(g_msg), priv, &sig, handle) == SGX_SUCCESS);
+    CHECK(sgx_ecdsa_verify(g_msg, sizeof(g_msg), pub, &sig, &result, handle) == SGX_SUCCESS);
+    CHECK(result == SGX_EC_VALID);
+}
+
+#ifndef USE_SGXSSL
+/* the same setup as sgx_ecc256_open_context, without ippsECCPBindGxyTblStd256r1 */
+static sgx_ecc_state_handle_t open_unbound_context(void)
+{
+    int ctx_size = 0;
+    CHECK(ippsECCPGetSize(256, &ctx_size) == ippStsNoErr);
+    IppsECCPState *p_ecc_state = (IppsECCPState *)malloc(ctx_size);
+    CHECK(p_ecc_state != NULL);
+    CHECK(ippsECCPInit(256, p_ecc_state) == ippStsNoErr);
+    CHECK(ippsECCPSetStd256r1(p_ecc_state) == ippStsNoErr);
+    return p_ecc_state;
+}
+#endif
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e6 + (double)(end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static double handshake_rate(sgx_ecc_state_handle_t handle)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < HANDSHAKES; i++)
+    {
+        sgx_ec256_private_t priv_a, priv_b;
+        sgx_ec256_public_t pub_a, pub_b;
+        sgx_ec256_dh_shared_t shared_a, shared_b;
+        sgx_ec256_signature_t sig;
+        uint8_t result = SGX_EC_INVALID_SIGNATURE;
+
+        CHECK(sgx_ecc256_create_key_pair(&priv_a, &pub_a, handle) == SGX_SUCCESS);
+        CHECK(sgx_ecc256_create_key_pair(&priv_b, &pub_b, handle) == SGX_SUCCESS);
+        CHECK(sgx_ecc256_compute_shared_dhkey(&priv_a, &pub_b, &shared_a, handle) == SGX_SUCCESS);
+        CHECK(sgx_ecc256_compute_shared_dhkey(&priv_b, &pub_a, &shared_b, handle) == SGX_SUCCESS);
+        CHECK(memcmp(&shared_a, &shared_b, sizeof(shared_a)) == 0);
+        CHECK(sgx_ecdsa_sign((const uint8_t *)&pub_b, sizeof(pub_b), &priv_a, &sig, handle) == SGX_SUCCESS);
+        CHECK(sgx_ecdsa_verify((const uint8_t *)&pub_b, sizeof(pub_b), &pub_a, &sig, &result, handle) == SGX_SUCCESS);
+        CHECK(result == SGX_EC_VALID);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return HANDSHAKES * 1e6 / elapsed_us(&start, &end);
+}
+
+int main(void)
+{
+#ifndef USE_SGXSSL
+    CHECK(ippcpInit() == ippStsNoErr);
+#endif
+    sgx_ec256_private_t priv;
+    sgx_ec256_public_t expected, pub;
+    hex_to_le(g_priv_hex, priv.r);
+    hex_to_le(g_pubx_hex, expected.gx);
+    hex_to_le(g_puby_hex, expected.gy);
+
+    CHECK(sgx_ecc256_calculate_pub_from_priv(&priv, &pub) == SGX_SUCCESS);
+    CHECK(memcmp(&pub, &expected, sizeof(pub)) == 0);
+
+    sgx_ecc_state_handle_t handle = NULL;
+    CHECK(sgx_ecc256_open_context(&handle) == SGX_SUCCESS);
+    check_fixed_vectors(handle, &expected);
+    check_sign_verify(handle, &priv, &expected);
+    double rate = handshake_rate(handle);
+    CHECK(sgx_ecc256_close_context(handle) == SGX_SUCCESS);
+
+#ifdef USE_SGXSSL
+    printf("ecc256_kat_test (sgxssl): %.0f handshakes/s\n", rate);
+#else
+    sgx_ecc_state_handle_t unbound = open_unbound_context();
+    check_fixed_vectors(unbound, &expected);
+    check_sign_verify(unbound, &priv, &expected);
+    double unbound_rate = handshake_rate(unbound);
+    free(unbound);
+
+    printf("ecc256_kat_test (ipp): %.0f handshakes/s, %.0f without the bound table\n", rate, unbound_rate);
+#endif
+    return 0;
+}
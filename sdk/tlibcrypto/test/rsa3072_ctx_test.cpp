@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Checks that the keyed RSA-3072 contexts give the same results as the
+ * one-shot functions: PKCS#1 v1.5 signatures are deterministic, so both
+ * must produce the same bytes, and both must accept and reject the same
+ * signatures. Each context is reused for every message.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sgx_tcrypto.h"
+#ifndef USE_SGXSSL
+#include "ippcp.h"
+#endif
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+/* Little-endian RSA-3072 test key, e = 65537. Only for tests. */
+static const sgx_rsa3072_key_t g_test_key = {
+    {
+        0xd1, 0x1e, 0x7b, 0xb2, 0x66, 0xc9, 0x94, 0xf4, 0x9a, 0x0d, 0x3c, 0x3f,
+        0xe6, 0x80, 0x02, 0xbb, 0xeb, 0xb8, 0x95, 0x35, 0xc2, 0x3c, 0xc2, 0x79,
+        0xb4, 0x9d, 0x4b, 0x9b, 0x4a, 0x15, 0x10, 0x06, 0xea, 0xd7, 0x36, 0x7a,
+        0xc6, 0x95, 0xb8, 0xa1, 0x8f, 0x26, 0x32, 0x1f, 0x4f, 0x70, 0x3a, 0x30,
+        0xa7, 0x51, 0xf8, 0xd2, 0xad, 0xba, 0xf8, 0x03, 0x73, 0x11, 0x38, 0x41,
+        0x67, 0xa1, 0xbf, 0xd1, 0x3b, 0xd0, 0xd2, 0xff, 0xa2, 0x70, 0x10, 0xfb,
+        0xbd, 0xae, 0x29, 0xa3, 0xfe, 0x3e, 0x24, 0x2d, 0xaa, 0xeb, 0x6b, 0x5c,
+        0xa1, 0x17, 0x8e, 0x86, 0x3e, 0x29, 0x7d, 0xaf, 0x9a, 0x51, 0xbc, 0x47,
+        0x4a, 0x51, 0x29, 0xf0, 0x42, 0x0b, 0x05, 0x0a, 0x47, 0x11, 0xc3, 0x13,
+        0xbb, 0x4d, 0x31, 0x7f, 0xd4, 0x45, 0xc3, 0xab, 0xbf, 0x14, 0x84, 0x2d,
+        0xb9, 0x7c, 0x52, 0x2f, 0xad, 0x38, 0x21, 0x9e, 0x55, 0x6f, 0x78, 0x46,
+        0xb8, 0x29, 0xc8, 0xdb, 0x1e, 0x48, 0x22, 0x8a, 0x26, 0x4d, 0xc6, 0x21,
+        0x6e, 0xfb, 0xc3, 0x8e, 0x6e, 0x87, 0x80, 0x08, 0x21, 0xe8, 0x27, 0x08,
+        0x3e, 0x6d, 0x84, 0xf5, 0x09, 0x24, 0xca, 0xe4, 0x16, 0x79, 0x9e, 0x03,
+        0x62, 0xf3, 0x4e, 0x44, 0x10, 0x5d, 0x7e, 0x73, 0x59, 0x39, 0xa8, 0xda,
+        0x15, 0x72, 0xdd, 0x6a, 0x2f, 0x17, 0x11, 0xe5, 0x7b, 0x7b, 0x93, 0x05,
+        0xfe, 0x43, 0x51, 0x4d, 0xf5, 0xa0, 0x8b, 0x77, 0xa1, 0x20, 0x74, 0xa1,
+        0xd5, 0x82, 0xf9, 0x22, 0x15, 0xf4, 0x98, 0xef, 0xa7, 0x07, 0xd2, 0x0c,
+        0xa7, 0x41, 0xc9, 0x66, 0xc7, 0x05, 0x8c, 0x31, 0x2b, 0x8e, 0x09, 0x11,
+        0xbe, 0x8e, 0xa4, 0x3c, 0x35, 0xe9, 0x98, 0x99, 0xbb, 0x06, 0x74, 0xf7,
+        0x5f, 0x34, 0xe4, 0x6a, 0x39, 0xe1, 0x25, 0x06, 0xea, 0x18, 0x89, 0x08,
+        0x44, 0x85, 0x59, 0xc2, 0x25, 0x7a, 0xf1, 0xc5, 0x30, 0xe7, 0x04, 0xd4,
+        0x84, 0x7c, 0x5b, 0x41, 0xd6, 0x88, 0xf5, 0x2f, 0x58, 0xcf, 0xd0, 0x28,
+        0x74, 0x0a, 0xaf, 0x7b, 0x6b, 0x47, 0x20, 0x4a, 0x3d, 0x00, 0x8c, 0x73,
+        0x10, 0x1d, 0x94, 0xb9, 0xb0, 0x7f, 0x3b, 0x61, 0x69, 0xc6, 0x51, 0xa5,
+        0x95, 0x9a, 0xf5, 0x29, 0xfa, 0x08, 0xcc, 0x63, 0x9b, 0x52, 0x50, 0xca,
+        0x49, 0xe5, 0x06, 0x88, 0x31, 0x54, 0x52, 0x3b, 0xb5, 0xd0, 0x8a, 0x18,
+        0xa1, 0xa7, 0x1a, 0x46, 0x88, 0xbc, 0x0a, 0x07, 0x9d, 0x8f, 0x1a, 0x17,
+        0x22, 0xcb, 0xc9, 0xe6, 0x29, 0xaa, 0x08, 0x67, 0xae, 0xe6, 0x44, 0x4e,
+        0xc1, 0x08, 0x15, 0xe8, 0x4e, 0x88, 0xfc, 0x06, 0x34, 0xe8, 0xed, 0xf1,
+        0x8c, 0x5e, 0x86, 0xe7, 0x85, 0x21, 0xc9, 0xc7, 0x3d, 0x0e, 0xb6, 0x33,
+        0x2e, 0xd2, 0x15, 0xc9, 0xb4, 0x36, 0xae, 0x97, 0x14, 0xf6, 0x6d, 0xd6
+    },
+    {
+        0xc5, 0xec, 0xeb, 0xde, 0xd3, 0xc6, 0xa7, 0xf8, 0x5c, 0xfb, 0x4f, 0x66,
+        0xff, 0x83, 0x51, 0x92, 0xa9, 0x23, 0xe1, 0x31, 0xff, 0x12, 0x6f, 0xe6,
+        0x96, 0x7e, 0xd6, 0xe6, 0xc5, 0x65, 0x60, 0x4e, 0x86, 0xad, 0x7b, 0x28,
+        0xd2, 0x40, 0xb9, 0x59, 0xd8, 0x41, 0xc2, 0x79, 0x12, 0xc7, 0x70, 0x53,
+        0x5d, 0x36, 0x2a, 0xd3, 0xab, 0x5f, 0xfc, 0xf8, 0x0c, 0x77, 0xb9, 0x54,
+        0x81, 0xb0, 0xdc, 0x32, 0xec, 0xf9, 0xd5, 0xfc, 0x30, 0x7a, 0xcc, 0x1c,
+        0x3a, 0x8b, 0x7d, 0x39, 0x29, 0x7d, 0x33, 0xb5, 0x8e, 0xa9, 0x62, 0xad,
+        0x35, 0xaa, 0xea, 0x16, 0x43, 0x66, 0xc5, 0x6c, 0x1f, 0x3e, 0xc6, 0x76,
+        0xfe, 0x4e, 0x26, 0x11, 0x13, 0x25, 0x22, 0xa8, 0x4a, 0x02, 0xa9, 0x93,
+        0xc3, 0x17, 0x4c, 0xbc, 0x42, 0xc5, 0x72, 0xd3, 0x0b, 0x3b, 0xea, 0x54,
+        0xb1, 0xb5, 0x67, 0xbc, 0xd4, 0xf4, 0x3f, 0x17, 0x62, 0x51, 0x09, 0xdc,
+        0x06, 0x1d, 0x9c, 0x43, 0x5e, 0x64, 0xf7, 0x55, 0x79, 0xb7, 0xba, 0x31,
+        0x35, 0x47, 0x45, 0x21, 0xb1, 0x41, 0x53, 0x27, 0x33, 0x02, 0xc9, 0x24,
+        0xdc, 0x53, 0x48, 0x8b, 0xc4, 0xa2, 0x2c, 0x98, 0xd8, 0x94, 0xc5, 0x39,
+        0xfe, 0x7d, 0x29, 0x57, 0x24, 0x19, 0x49, 0xa4, 0x68, 0xae, 0x5d, 0xc7,
+        0x99, 0xaa, 0xac, 0x23, 0x8a, 0x51, 0x4b, 0xa6, 0x8c, 0x74, 0x8f, 0x9f,
+        0x26, 0x3f, 0x2f, 0x79, 0x10, 0x77, 0xc5, 0x76, 0x7b, 0x61, 0xe2, 0xc9,
+        0x6d, 0xe4, 0x9f, 0x4b, 0xd1, 0xec, 0x13, 0x13, 0x80, 0xa5, 0x67, 0x76,
+        0x3c, 0xfc, 0x33, 0xf9, 0x99, 0x50, 0x37, 0x3f, 0x67, 0xda, 0x8e, 0xb2,
+        0x2e, 0xfe, 0x0c, 0xa1, 0x28, 0x7f, 0x49, 0xaf, 0x26, 0x11, 0x00, 0xe0,
+        0x29, 0x55, 0xa7, 0x00, 0x0e, 0xcb, 0x0c, 0x77, 0x58, 0xbd, 0xeb, 0x67,
+        0xdd, 0xb5, 0xd5, 0xd9, 0x79, 0x62, 0x2a, 0x00, 0x90, 0x4b, 0x9a, 0x26,
+        0xfb, 0xa7, 0x5b, 0xd2, 0xad, 0x4c, 0x73, 0x51, 0xfb, 0x82, 0xda, 0x01,
+        0x1c, 0xe9, 0x6f, 0x14, 0xf3, 0xb6, 0x54, 0xd8, 0xcf, 0x98, 0x3f, 0x9f,
+        0xb7, 0x99, 0x24, 0xaf, 0x29, 0xab, 0x8e, 0x49, 0x06, 0x22, 0xaf, 0xf7,
+        0x9a, 0x62, 0x27, 0x03, 0xea, 0xff, 0x2a, 0x38, 0x94, 0x0c, 0x30, 0x40,
+        0x1a, 0x91, 0xdf, 0xc6, 0x6b, 0x53, 0x43, 0x01, 0x07, 0x8c, 0xbf, 0x74,
+        0x5e, 0x38, 0x30, 0xba, 0x34, 0x6c, 0xab, 0x6e, 0x11, 0xfc, 0xde, 0x33,
+        0x7f, 0xa3, 0x8d, 0xfd, 0x24, 0x7f, 0x7d, 0x93, 0x37, 0x5d, 0x09, 0xa4,
+        0xbf, 0x55, 0x60, 0x5e, 0x64, 0xd1, 0x04, 0x88, 0xf6, 0x00, 0xc3, 0x5b,
+        0xf7, 0xcf, 0xc4, 0xa2, 0x35, 0xac, 0x09, 0x54, 0xf7, 0x2a, 0x3b, 0x24,
+        0xb2, 0xfd, 0x52, 0x8b, 0xba, 0xfb, 0xa5, 0x8a, 0x9b, 0xeb, 0x04, 0x44
+    },
+    {
+        0x01, 0x00, 0x01, 0x00
+    }
+};
+
+static const uint32_t g_sizes[] = { 1, 3, 64, 65, 1000, 4096 };
+#define MSG_COUNT (sizeof(g_sizes) / sizeof(g_sizes[0]))
+
+static uint8_t g_msg[4096];
+
+static void verify_both(const uint8_t *p_data, uint32_t size, const sgx_rsa3072_public_key_t *p_public,
+                        sgx_rsa3072_state_handle_t verify_ctx, const sgx_rsa3072_signature_t *p_signature,
+                        sgx_rsa_result_t expected)
+{
+    sgx_rsa_result_t one_shot = SGX_RSA_VALID, keyed = SGX_RSA_VALID;
+    CHECK(sgx_rsa3072_verify(p_data, size, p_public, p_signature, &one_shot) == SGX_SUCCESS);
+    CHECK(sgx_rsa3072_verify_ctx(p_data, size, verify_ctx, p_signature, &keyed) == SGX_SUCCESS);
+    CHECK(one_shot == expected);
+    CHECK(keyed == expected);
+}
+
+int main(void)
+{
+#ifndef USE_SGXSSL
+    CHECK(ippcpInit() == ippStsNoErr);
+#endif
+    for (size_t i = 0; i < sizeof(g_msg); i++)
+        g_msg[i] = (uint8_t)(i * 7 + 1);
+
+    sgx_rsa3072_public_key_t pub;
+    memcpy(pub.mod, g_test_key.mod, sizeof(pub.mod));
+    memcpy(pub.exp, g_test_key.e, sizeof(pub.exp));
+
+    sgx_rsa3072_state_handle_t sign_ctx = NULL, verify_ctx = NULL;
+    CHECK(sgx_rsa3072_sign_ctx_init(&g_test_key, &sign_ctx) == SGX_SUCCESS);
+    CHECK(sgx_rsa3072_verify_ctx_init(&pub, &verify_ctx) == SGX_SUCCESS);
+
+    for (size_t i = 0; i < MSG_COUNT; i++)
+    {
+        sgx_rsa3072_signature_t one_shot, keyed;
+        CHECK(sgx_rsa3072_sign(g_msg, g_sizes[i], &g_test_key, &one_shot) == SGX_SUCCESS);
+        CHECK(sgx_rsa3072_sign_ctx(g_msg, g_sizes[i], sign_ctx, &keyed) == SGX_SUCCESS);
+        CHECK(memcmp(one_shot, keyed, sizeof(one_shot)) == 0);
+
+        verify_both(g_msg, g_sizes[i], &pub, verify_ctx, &keyed, SGX_RSA_VALID);
+
+        /* a changed signature and a changed message are both rejected,
+         * and the context still verifies the next message */
+        keyed[i * 37] ^= 0x01;
+        verify_both(g_msg, g_sizes[i], &pub, verify_ctx, &keyed, SGX_RSA_INVALID_SIGNATURE);
+        keyed[i * 37] ^= 0x01;
+        g_msg[0] ^= 0x80;
+        verify_both(g_msg, g_sizes[i], &pub, verify_ctx, &keyed, SGX_RSA_INVALID_SIGNATURE);
+        g_msg[0] ^= 0x80;
+    }
+
+    /* a signature not below the modulus can't be valid */
+    sgx_rsa3072_signature_t too_big;
+    memset(too_big, 0xff, sizeof(too_big));
+    verify_both(g_msg, 64, &pub, verify_ctx, &too_big, SGX_RSA_INVALID_SIGNATURE);
+
+    /* a context only does the operation it was created for */
+    sgx_rsa3072_signature_t sig;
+    sgx_rsa_result_t result;
+    CHECK(sgx_rsa3072_sign_ctx(g_msg, 64, verify_ctx, &sig) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(sgx_rsa3072_verify_ctx(g_msg, 64, sign_ctx, &sig, &result) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(sgx_rsa3072_sign_ctx_close(verify_ctx) == SGX_ERROR_INVALID_PARAMETER);
+    CHECK(sgx_rsa3072_verify_ctx_close(sign_ctx) == SGX_ERROR_INVALID_PARAMETER);
+
+    CHECK(sgx_rsa3072_sign_ctx_close(sign_ctx) == SGX_SUCCESS);
+    CHECK(sgx_rsa3072_verify_ctx_close(verify_ctx) == SGX_SUCCESS);
+
+#ifdef USE_SGXSSL
+    printf("rsa3072_ctx_test (sgxssl): %zu messages\n", MSG_COUNT);
+#else
+    printf("rsa3072_ctx_test (ipp): %zu messages\n", MSG_COUNT);
+#endif
+    return 0;
+}
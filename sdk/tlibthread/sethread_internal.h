@@ -71,11 +71,33 @@ typedef struct _thread_data_t *pTD;
     (head)->m_last = SGX_THREAD_T_NULL;                     \
 } while (0)
 
+/* Unlink elm wherever it is in the queue, no-op if it is not queued */
+#define QUEUE_REMOVE(head, elm) do {                            \
+    sgx_thread_t _prev = SGX_THREAD_T_NULL, _cur;               \
+    QUEUE_FOREACH(_cur, head) {                                 \
+        if (_cur == (elm)) break;                               \
+        _prev = _cur;                                           \
+    }                                                           \
+    if (_cur != SGX_THREAD_T_NULL) {                            \
+        if (_prev == SGX_THREAD_T_NULL)                         \
+            QUEUE_REMOVE_HEAD(head);                            \
+        else {                                                  \
+            ((pTD)_prev)->m_next = ((pTD)_cur)->m_next;         \
+            if ((head)->m_last == _cur)                         \
+                (head)->m_last = _prev;                         \
+        }                                                       \
+    }                                                           \
+} while (0)
+
 #define QUEUE_COUNT_ALL(var, head, total) do {      \
     QUEUE_FOREACH(var, head)                        \
         (total)++;                                  \
 } while(0)                                          \
 
+/* Mutex control word */
+#define MUTEX_TYPE(mutex)   ((mutex)->m_control & SGX_THREAD_MUTEX_TYPE_MASK)
+#define MUTEX_SPIN(mutex)   ((mutex)->m_control >> SGX_THREAD_MUTEX_SPIN_SHIFT)
+
 /* Spinlock */
 #define SPIN_LOCK(_lck)     sgx_spin_lock((sgx_spinlock_t *)_lck);
 #define SPIN_UNLOCK(_lck)   sgx_spin_unlock((sgx_spinlock_t *)_lck);
@@ -37,6 +37,28 @@
 #include "util.h"
 #include "sethread_internal.h"
 
+static inline void _mm_pause(void)
+{
+    __asm__ __volatile__ ("pause" : : : "memory");
+}
+
+/* mutex_spin_wait:
+ *  wait inside the enclave for the owner to release the mutex. Gives up
+ *  after 'spin' rounds, or when another thread is already parked on the
+ *  mutex since the mutex would be handed over to that thread first.
+ */
+static void mutex_spin_wait(sgx_thread_mutex_t *mutex, uint32_t spin)
+{
+    volatile sgx_thread_t *owner = &mutex->m_owner;
+    volatile sgx_thread_t *first = &mutex->m_queue.m_first;
+
+    while (spin-- != 0) {
+        if (*owner == SGX_THREAD_T_NULL || *first != SGX_THREAD_T_NULL)
+            break;
+        _mm_pause();
+    }
+}
+
 int sgx_thread_mutex_init(sgx_thread_mutex_t *mutex, const sgx_thread_mutexattr_t *unused)
 {
     UNUSED(unused);
@@ -76,17 +98,18 @@ int sgx_thread_mutex_lock(sgx_thread_mutex_t *mutex)
     CHECK_PARAMETER(mutex);
 
     sgx_thread_t self = (sgx_thread_t)get_thread_data();
+    uint32_t spin = MUTEX_SPIN(mutex);
 
     while (1) {
         SPIN_LOCK(&mutex->m_lock);
 
-        if(mutex->m_control != SGX_THREAD_MUTEX_RECURSIVE
-            && mutex->m_control != SGX_THREAD_MUTEX_NONRECURSIVE) {
+        if(MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_RECURSIVE
+            && MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_NONRECURSIVE) {
             SPIN_UNLOCK(&mutex->m_lock);
             return EINVAL;
         }
         
-        if (mutex->m_control == SGX_THREAD_MUTEX_RECURSIVE
+        if (MUTEX_TYPE(mutex) == SGX_THREAD_MUTEX_RECURSIVE
             && mutex->m_owner == self) {
             mutex->m_refcount++;
             SPIN_UNLOCK(&mutex->m_lock);
@@ -111,8 +134,17 @@ int sgx_thread_mutex_lock(sgx_thread_mutex_t *mutex)
             if (waiter == self) break;
         }
         
-        if (waiter == SGX_THREAD_T_NULL)
+        if (waiter == SGX_THREAD_T_NULL) {
+            /* OPT: a short critical section is likely to end before an
+             * OCALL round trip would, spin once before sleeping outside. */
+            if (spin != 0) {
+                SPIN_UNLOCK(&mutex->m_lock);
+                mutex_spin_wait(mutex, spin);
+                spin = 0;
+                continue;
+            }
             QUEUE_INSERT_TAIL(&mutex->m_queue, self);
+        }
 
         SPIN_UNLOCK(&mutex->m_lock);
 
@@ -131,13 +163,13 @@ int sgx_thread_mutex_trylock(sgx_thread_mutex_t *mutex)
 
     SPIN_LOCK(&mutex->m_lock);
 
-    if(mutex->m_control != SGX_THREAD_MUTEX_RECURSIVE
-        && mutex->m_control != SGX_THREAD_MUTEX_NONRECURSIVE) {
+    if(MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_RECURSIVE
+        && MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_NONRECURSIVE) {
         SPIN_UNLOCK(&mutex->m_lock);
         return EINVAL;
     }
     
-    if (mutex->m_control == SGX_THREAD_MUTEX_RECURSIVE
+    if (MUTEX_TYPE(mutex) == SGX_THREAD_MUTEX_RECURSIVE
         && mutex->m_owner == self) {
         mutex->m_refcount++;
         SPIN_UNLOCK(&mutex->m_lock);
@@ -162,6 +194,27 @@ int sgx_thread_mutex_trylock(sgx_thread_mutex_t *mutex)
     return EBUSY;
 }
 
+int sgx_thread_mutex_setspin(sgx_thread_mutex_t *mutex, uint32_t spin_count)
+{
+    CHECK_PARAMETER(mutex);
+
+    if (spin_count > SGX_THREAD_MUTEX_SPIN_MAX)
+        spin_count = SGX_THREAD_MUTEX_SPIN_MAX;
+
+    SPIN_LOCK(&mutex->m_lock);
+
+    if(MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_RECURSIVE
+        && MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_NONRECURSIVE) {
+        SPIN_UNLOCK(&mutex->m_lock);
+        return EINVAL;
+    }
+
+    mutex->m_control = MUTEX_TYPE(mutex) | (spin_count << SGX_THREAD_MUTEX_SPIN_SHIFT);
+
+    SPIN_UNLOCK(&mutex->m_lock);
+    return 0;
+}
+
 /* sgx_thread_mutex_unlock_lazy:
  *  check and modify mutex object, but not wake the pending thread up.
  */
@@ -173,8 +226,8 @@ int sgx_thread_mutex_unlock_lazy(sgx_thread_mutex_t *mutex, sgx_thread_t *pwaite
 
     SPIN_LOCK(&mutex->m_lock);
     
-    if(mutex->m_control != SGX_THREAD_MUTEX_RECURSIVE
-        && mutex->m_control != SGX_THREAD_MUTEX_NONRECURSIVE) {
+    if(MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_RECURSIVE
+        && MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_NONRECURSIVE) {
         SPIN_UNLOCK(&mutex->m_lock);
         return EINVAL;
     }
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "util.h"
+#include "sethread_internal.h"
+
+/* Writers are preferred: once a writer is waiting, new readers queue up
+ * behind it. Waiting writers stay in m_writer_queue until they get the
+ * lock, the head of the queue is the one woken up on release. Waiting
+ * readers are all dequeued and woken together when no writer is left.
+ */
+
+int sgx_thread_rwlock_init(sgx_thread_rwlock_t *rwlock, const sgx_thread_rwlockattr_t *unused)
+{
+    UNUSED(unused);
+    CHECK_PARAMETER(rwlock);
+
+    rwlock->m_reader_count = 0;
+    rwlock->m_owner = SGX_THREAD_T_NULL;
+    rwlock->m_lock = SGX_SPINLOCK_INITIALIZER;
+
+    QUEUE_INIT(&rwlock->m_reader_queue);
+    QUEUE_INIT(&rwlock->m_writer_queue);
+
+    return 0;
+}
+
+int sgx_thread_rwlock_destroy(sgx_thread_rwlock_t *rwlock)
+{
+    CHECK_PARAMETER(rwlock);
+
+    SPIN_LOCK(&rwlock->m_lock);
+    if (rwlock->m_owner != SGX_THREAD_T_NULL
+        || rwlock->m_reader_count != 0
+        || QUEUE_FIRST(&rwlock->m_reader_queue) != SGX_THREAD_T_NULL
+        || QUEUE_FIRST(&rwlock->m_writer_queue) != SGX_THREAD_T_NULL) {
+        SPIN_UNLOCK(&rwlock->m_lock);
+        return EBUSY;
+    }
+    SPIN_UNLOCK(&rwlock->m_lock);
+
+    return 0;
+}
+
+static int rwlock_rdlock(sgx_thread_rwlock_t *rwlock, bool block)
+{
+    CHECK_PARAMETER(rwlock);
+
+    sgx_thread_t self = (sgx_thread_t)get_thread_data();
+
+    while (1) {
+        SPIN_LOCK(&rwlock->m_lock);
+
+        if (rwlock->m_owner == self) {
+            SPIN_UNLOCK(&rwlock->m_lock);
+            return EDEADLK;
+        }
+
+        sgx_thread_t waiter = SGX_THREAD_T_NULL;
+        QUEUE_FOREACH(waiter, &rwlock->m_reader_queue) {
+            if (waiter == self) break;
+        }
+
+        /* still queued means the wake up was not meant for this lock */
+        if (waiter == SGX_THREAD_T_NULL
+            && rwlock->m_owner == SGX_THREAD_T_NULL
+            && QUEUE_FIRST(&rwlock->m_writer_queue) == SGX_THREAD_T_NULL) {
+            if (rwlock->m_reader_count == UINT32_MAX) {
+                SPIN_UNLOCK(&rwlock->m_lock);
+                return EAGAIN;
+            }
+            rwlock->m_reader_count++;
+            SPIN_UNLOCK(&rwlock->m_lock);
+            return 0;
+        }
+
+        if (!block) {
+            SPIN_UNLOCK(&rwlock->m_lock);
+            return EBUSY;
+        }
+
+        if (waiter == SGX_THREAD_T_NULL)
+            QUEUE_INSERT_TAIL(&rwlock->m_reader_queue, self);
+
+        SPIN_UNLOCK(&rwlock->m_lock);
+
+        int err = 0;
+        sgx_thread_wait_untrusted_event_ocall(&err, TD2TCS(self));
+    }
+
+    /* NOTREACHED */
+}
+
+static int rwlock_wrlock(sgx_thread_rwlock_t *rwlock, bool block)
+{
+    CHECK_PARAMETER(rwlock);
+
+    sgx_thread_t self = (sgx_thread_t)get_thread_data();
+
+    while (1) {
+        SPIN_LOCK(&rwlock->m_lock);
+
+        if (rwlock->m_owner == self) {
+            SPIN_UNLOCK(&rwlock->m_lock);
+            return EDEADLK;
+        }
+
+        if (rwlock->m_owner == SGX_THREAD_T_NULL
+            && rwlock->m_reader_count == 0
+            && (QUEUE_FIRST(&rwlock->m_writer_queue) == self
+            || QUEUE_FIRST(&rwlock->m_writer_queue) == SGX_THREAD_T_NULL)) {
+
+            if (QUEUE_FIRST(&rwlock->m_writer_queue) == self)
+                QUEUE_REMOVE_HEAD(&rwlock->m_writer_queue);
+
+            rwlock->m_owner = self;
+            SPIN_UNLOCK(&rwlock->m_lock);
+            return 0;
+        }
+
+        if (!block) {
+            SPIN_UNLOCK(&rwlock->m_lock);
+            return EBUSY;
+        }
+
+        sgx_thread_t waiter = SGX_THREAD_T_NULL;
+        QUEUE_FOREACH(waiter, &rwlock->m_writer_queue) {
+            if (waiter == self) break;
+        }
+
+        if (waiter == SGX_THREAD_T_NULL)
+            QUEUE_INSERT_TAIL(&rwlock->m_writer_queue, self);
+
+        SPIN_UNLOCK(&rwlock->m_lock);
+
+        int err = 0;
+        sgx_thread_wait_untrusted_event_ocall(&err, TD2TCS(self));
+    }
+
+    /* NOTREACHED */
+}
+
+int sgx_thread_rwlock_rdlock(sgx_thread_rwlock_t *rwlock)
+{
+    return rwlock_rdlock(rwlock, true);
+}
+
+int sgx_thread_rwlock_tryrdlock(sgx_thread_rwlock_t *rwlock)
+{
+    return rwlock_rdlock(rwlock, false);
+}
+
+int sgx_thread_rwlock_wrlock(sgx_thread_rwlock_t *rwlock)
+{
+    return rwlock_wrlock(rwlock, true);
+}
+
+int sgx_thread_rwlock_trywrlock(sgx_thread_rwlock_t *rwlock)
+{
+    return rwlock_wrlock(rwlock, false);
+}
+
+int sgx_thread_rwlock_unlock(sgx_thread_rwlock_t *rwlock)
+{
+    CHECK_PARAMETER(rwlock);
+
+    sgx_thread_t self = (sgx_thread_t)get_thread_data();
+    sgx_thread_t waiter = SGX_THREAD_T_NULL;
+    const void **waiters = NULL;
+    size_t n_waiter = 0;
+    int err = 0;
+
+    SPIN_LOCK(&rwlock->m_lock);
+
+    if (rwlock->m_owner == self) {
+        rwlock->m_owner = SGX_THREAD_T_NULL;
+    } else if (rwlock->m_owner == SGX_THREAD_T_NULL && rwlock->m_reader_count != 0) {
+        rwlock->m_reader_count--;
+    } else {
+        SPIN_UNLOCK(&rwlock->m_lock);
+        return EPERM;
+    }
+
+    if (rwlock->m_reader_count != 0) {
+        SPIN_UNLOCK(&rwlock->m_lock);
+        return 0;
+    }
+
+    /* the lock is free now, hand it over to the first waiting writer,
+     * the writer removes itself from the queue once it owns the lock.
+     */
+    if ((waiter = QUEUE_FIRST(&rwlock->m_writer_queue)) != SGX_THREAD_T_NULL) {
+        SPIN_UNLOCK(&rwlock->m_lock);
+        sgx_thread_set_untrusted_event_ocall(&err, TD2TCS(waiter));
+        return 0;
+    }
+
+    /* no writer is waiting, let all pending readers in */
+    QUEUE_COUNT_ALL(waiter, &rwlock->m_reader_queue, n_waiter);
+    if (n_waiter == 0) {
+        SPIN_UNLOCK(&rwlock->m_lock);
+        return 0;
+    }
+
+    if (n_waiter == 1) {
+        waiter = QUEUE_FIRST(&rwlock->m_reader_queue);
+        QUEUE_REMOVE_HEAD(&rwlock->m_reader_queue);
+        SPIN_UNLOCK(&rwlock->m_lock);
+        sgx_thread_set_untrusted_event_ocall(&err, TD2TCS(waiter));
+        return 0;
+    }
+
+    waiters = (const void **)malloc(n_waiter * sizeof(const void *));
+    if (waiters == NULL) {
+        /* wake the readers one by one instead, each with its own OCALL. A
+         * reader woken while a writer has queued meanwhile just queues again.
+         */
+        while (n_waiter-- != 0
+            && (waiter = QUEUE_FIRST(&rwlock->m_reader_queue)) != SGX_THREAD_T_NULL) {
+            QUEUE_REMOVE_HEAD(&rwlock->m_reader_queue);
+            SPIN_UNLOCK(&rwlock->m_lock);
+            sgx_thread_set_untrusted_event_ocall(&err, TD2TCS(waiter));
+            SPIN_LOCK(&rwlock->m_lock);
+        }
+        SPIN_UNLOCK(&rwlock->m_lock);
+        return 0;
+    }
+
+    const void **tmp = waiters;
+    while ((waiter = QUEUE_FIRST(&rwlock->m_reader_queue)) != SGX_THREAD_T_NULL) {
+        QUEUE_REMOVE_HEAD(&rwlock->m_reader_queue);
+        *tmp++ = TD2TCS(waiter);
+    }
+
+    SPIN_UNLOCK(&rwlock->m_lock);
+
+    sgx_thread_set_multiple_untrusted_events_ocall(&err, waiters, n_waiter);
+    free(waiters);
+    return 0;
+}
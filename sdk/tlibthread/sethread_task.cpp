@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <errno.h>
+
+#include "util.h"
+#include "sethread_internal.h"
+#include "sgx_task.h"
+
+/* Every worker owns a deque, the owner pushes and pops at the bottom while
+ * thieves take from the top. Slot 0 is shared by the threads which are not
+ * workers, slots 1 to SGX_TASK_MAX_WORKERS are handed to workers in any
+ * order and given back when they leave. The deques are short: a parallel_for only keeps O(log n) pending
+ * chunks per thread, and a task which doesn't fit is run right away.
+ */
+#define TASK_DEQUE_SIZE     64      /* power of 2 */
+#define TASK_SPIN_DEFAULT   4096
+
+typedef struct _task_t
+{
+    sgx_task_fn_t       fn;
+    void                *arg;
+    sgx_task_range_fn_t body;       /* set for a parallel_for chunk */
+    size_t              begin;
+    size_t              end;
+    size_t              grain;
+    sgx_task_group_t    *group;
+} task_t;
+
+typedef struct _task_deque_t
+{
+    sgx_spinlock_t      lock;
+    volatile size_t     top;
+    volatile size_t     bottom;
+    task_t              tasks[TASK_DEQUE_SIZE];
+} task_deque_t;
+
+static task_deque_t g_deques[SGX_TASK_MAX_WORKERS + 1];
+static volatile uint32_t g_slots_used = 0;     /* bit n set while slot n has a worker */
+se_static_assert(SGX_TASK_MAX_WORKERS < 32);
+static volatile uint32_t g_running = 0;        /* workers inside sgx_task_worker_run */
+static volatile uint32_t g_sleepers = 0;
+static volatile int g_stop = 0;
+static unsigned int g_spin_count = TASK_SPIN_DEFAULT;
+static sgx_thread_mutex_t g_park_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+static sgx_thread_cond_t g_park_cond = SGX_THREAD_COND_INITIALIZER;
+
+static __thread uint32_t t_slot = 0;
+static __thread uint32_t t_seed = 0;
+
+static inline void _mm_pause(void)
+{
+    __asm__ __volatile__ ("pause" : : : "memory");
+}
+
+static bool deque_push(task_deque_t *deque, const task_t *task)
+{
+    bool ret = false;
+
+    SPIN_LOCK(&deque->lock);
+    if (deque->bottom - deque->top < TASK_DEQUE_SIZE) {
+        deque->tasks[deque->bottom & (TASK_DEQUE_SIZE - 1)] = *task;
+        deque->bottom++;
+        ret = true;
+    }
+    SPIN_UNLOCK(&deque->lock);
+    return ret;
+}
+
+static bool deque_take(task_deque_t *deque, task_t *task, bool steal)
+{
+    bool ret = false;
+
+    if (deque->bottom == deque->top)
+        return false;
+
+    SPIN_LOCK(&deque->lock);
+    if (deque->bottom != deque->top) {
+        if (steal) {
+            *task = deque->tasks[deque->top & (TASK_DEQUE_SIZE - 1)];
+            deque->top++;
+        } else {
+            deque->bottom--;
+            *task = deque->tasks[deque->bottom & (TASK_DEQUE_SIZE - 1)];
+        }
+        ret = true;
+    }
+    SPIN_UNLOCK(&deque->lock);
+    return ret;
+}
+
+static bool has_task(void)
+{
+    for (uint32_t i = 0; i <= SGX_TASK_MAX_WORKERS; i++) {
+        if (g_deques[i].bottom != g_deques[i].top)
+            return true;
+    }
+    return false;
+}
+
+static bool find_task(task_t *task)
+{
+    if (deque_take(&g_deques[t_slot], task, false))
+        return true;
+
+    /* steal, starting from a random victim. Free slots are scanned too, they
+     * are empty and cost one load each. */
+    uint32_t count = SGX_TASK_MAX_WORKERS + 1;
+    if (t_seed == 0)
+        t_seed = (uint32_t)sgx_thread_self() | 1;
+    t_seed ^= t_seed << 13;
+    t_seed ^= t_seed >> 17;
+    t_seed ^= t_seed << 5;
+
+    uint32_t start = t_seed % count;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t victim = (start + i) % count;
+        if (victim != t_slot && deque_take(&g_deques[victim], task, true))
+            return true;
+    }
+    return false;
+}
+
+static void run_task(task_t *task);
+
+static void submit_task(const task_t *task)
+{
+    __atomic_add_fetch(&task->group->m_pending, 1, __ATOMIC_SEQ_CST);
+
+    if (!deque_push(&g_deques[t_slot], task)) {
+        task_t copy = *task;
+        run_task(&copy);
+        return;
+    }
+
+    /* pairs with the increment of g_sleepers in thread_park() */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (g_sleepers != 0) {
+        sgx_thread_mutex_lock(&g_park_mutex);
+        sgx_thread_cond_signal(&g_park_cond);
+        sgx_thread_mutex_unlock(&g_park_mutex);
+    }
+}
+
+static void run_task(task_t *task)
+{
+    if (task->body != NULL) {
+        /* keep the left half, publish the right halves for thieves */
+        while (task->end - task->begin > task->grain) {
+            task_t right = *task;
+            right.begin = task->begin + (task->end - task->begin) / 2;
+            task->end = right.begin;
+            submit_task(&right);
+        }
+        task->body(task->begin, task->end, task->arg);
+    } else {
+        task->fn(task->arg);
+    }
+
+    /* wake the threads sleeping in sgx_task_group_wait(), the sub_fetch pairs
+     * with the increment of g_sleepers in thread_park() */
+    if (__atomic_sub_fetch(&task->group->m_pending, 1, __ATOMIC_SEQ_CST) == 0
+        && g_sleepers != 0) {
+        sgx_thread_mutex_lock(&g_park_mutex);
+        sgx_thread_cond_broadcast(&g_park_cond);
+        sgx_thread_mutex_unlock(&g_park_mutex);
+    }
+}
+
+/* Workers and group waiters sleep on the same condition: a new task wakes
+ * one of them, a finished group wakes all of them. group is NULL for a
+ * worker.
+ */
+static void thread_park(sgx_task_group_t *group)
+{
+    sgx_thread_mutex_lock(&g_park_mutex);
+    __atomic_add_fetch(&g_sleepers, 1, __ATOMIC_SEQ_CST);
+    if (!g_stop && !has_task() && (group == NULL || group->m_pending != 0))
+        sgx_thread_cond_wait(&g_park_cond, &g_park_mutex);
+    __atomic_sub_fetch(&g_sleepers, 1, __ATOMIC_SEQ_CST);
+    sgx_thread_mutex_unlock(&g_park_mutex);
+}
+
+int sgx_task_runtime_init(unsigned int spin_count)
+{
+    sgx_thread_mutex_lock(&g_park_mutex);
+    if (g_running != 0 || has_task()) {
+        sgx_thread_mutex_unlock(&g_park_mutex);
+        return EBUSY;
+    }
+
+    g_spin_count = spin_count ? spin_count : TASK_SPIN_DEFAULT;
+    g_stop = 0;
+    sgx_thread_mutex_unlock(&g_park_mutex);
+    return 0;
+}
+
+int sgx_task_runtime_shutdown(void)
+{
+    sgx_thread_mutex_lock(&g_park_mutex);
+    g_stop = 1;
+    sgx_thread_cond_broadcast(&g_park_cond);
+    sgx_thread_mutex_unlock(&g_park_mutex);
+    return 0;
+}
+
+int sgx_task_worker_run(void)
+{
+    if (t_slot != 0) return EDEADLK;
+
+    sgx_thread_mutex_lock(&g_park_mutex);
+    uint32_t slot = 1;
+    while (slot <= SGX_TASK_MAX_WORKERS && (g_slots_used & (1U << slot)) != 0)
+        slot++;
+    if (g_stop || slot > SGX_TASK_MAX_WORKERS) {
+        sgx_thread_mutex_unlock(&g_park_mutex);
+        return g_stop ? ECANCELED : EAGAIN;
+    }
+    g_slots_used |= 1U << slot;
+    t_slot = slot;
+    g_running++;
+    sgx_thread_mutex_unlock(&g_park_mutex);
+
+    task_t task;
+    unsigned int idle = 0;
+    while (!g_stop) {
+        if (find_task(&task)) {
+            run_task(&task);
+            idle = 0;
+        } else if (++idle < g_spin_count) {
+            _mm_pause();
+        } else {
+            thread_park(NULL);
+            idle = 0;
+        }
+    }
+
+    /* run what is left in the own deque, the next owner of the slot must
+     * find it empty */
+    while (deque_take(&g_deques[t_slot], &task, false))
+        run_task(&task);
+
+    sgx_thread_mutex_lock(&g_park_mutex);
+    g_slots_used &= ~(1U << t_slot);
+    t_slot = 0;
+    g_running--;
+    sgx_thread_mutex_unlock(&g_park_mutex);
+    return 0;
+}
+
+int sgx_task_spawn(sgx_task_group_t *group, sgx_task_fn_t fn, void *arg)
+{
+    CHECK_PARAMETER(group);
+    if (fn == NULL || !sgx_is_within_enclave((void *)fn, 1)) return EINVAL;
+
+    task_t task = {fn, arg, NULL, 0, 0, 0, group};
+    submit_task(&task);
+    return 0;
+}
+
+int sgx_task_group_wait(sgx_task_group_t *group)
+{
+    CHECK_PARAMETER(group);
+
+    task_t task;
+    unsigned int idle = 0;
+    while (group->m_pending != 0) {
+        if (find_task(&task)) {
+            run_task(&task);
+            idle = 0;
+        } else if (++idle < g_spin_count) {
+            _mm_pause();
+        } else {
+            /* the tasks left are running on other threads */
+            thread_park(group);
+            idle = 0;
+        }
+    }
+    return 0;
+}
+
+int sgx_task_parallel_for(size_t begin, size_t end, size_t grain, sgx_task_range_fn_t body, void *arg)
+{
+    if (body == NULL || !sgx_is_within_enclave((void *)body, 1)) return EINVAL;
+    if (begin >= end) return 0;
+
+    sgx_task_group_t group = SGX_TASK_GROUP_INITIALIZER;
+    task_t task = {NULL, arg, body, begin, end, grain ? grain : 1, &group};
+
+    group.m_pending = 1;
+    run_task(&task);
+    return sgx_task_group_wait(&group);
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Timed waits. They are kept apart from sethread_mutex.cpp and
+ * sethread_cond.cpp so that only an enclave calling them links in
+ * sgx_thread_wait_untrusted_event_timeout_ocall and has to import it from
+ * sgx_tstdc.edl.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "util.h"
+#include "sethread_internal.h"
+
+/* Generated OCALL */
+extern "C" sgx_status_t sgx_thread_wait_untrusted_event_timeout_ocall(int* retval, const void *self, uint64_t timeout_us, uint64_t *remaining_us);
+
+/* Wait outside for at most *timeout_us, which is updated with the time left,
+ * 0 after a timeout or when the wait could not be done.
+ */
+static void wait_untrusted_event_timeout(sgx_thread_t self, uint64_t *timeout_us)
+{
+    int err = 0;
+    uint64_t remaining_us = 0;
+
+    if (*timeout_us != 0
+        && sgx_thread_wait_untrusted_event_timeout_ocall(&err, TD2TCS(self), *timeout_us, &remaining_us) == SGX_SUCCESS
+        && err == 0
+        && remaining_us <= *timeout_us)
+        *timeout_us = remaining_us;
+    else
+        *timeout_us = 0;
+}
+
+int sgx_thread_mutex_timedlock(sgx_thread_mutex_t *mutex, uint64_t timeout_us)
+{
+    CHECK_PARAMETER(mutex);
+
+    sgx_thread_t self = (sgx_thread_t)get_thread_data();
+
+    while (1) {
+        SPIN_LOCK(&mutex->m_lock);
+
+        if(MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_RECURSIVE
+            && MUTEX_TYPE(mutex) != SGX_THREAD_MUTEX_NONRECURSIVE) {
+            SPIN_UNLOCK(&mutex->m_lock);
+            return EINVAL;
+        }
+
+        if (MUTEX_TYPE(mutex) == SGX_THREAD_MUTEX_RECURSIVE
+            && mutex->m_owner == self) {
+            mutex->m_refcount++;
+            SPIN_UNLOCK(&mutex->m_lock);
+            return 0;
+        }
+
+        if (mutex->m_owner == SGX_THREAD_T_NULL
+            && (QUEUE_FIRST(&mutex->m_queue) == self
+            || QUEUE_FIRST(&mutex->m_queue) == SGX_THREAD_T_NULL)) {
+
+            if (QUEUE_FIRST(&mutex->m_queue) == self)
+                QUEUE_REMOVE_HEAD(&mutex->m_queue);
+
+            mutex->m_owner = self;
+            mutex->m_refcount++;
+            SPIN_UNLOCK(&mutex->m_lock);
+            return 0;
+        }
+
+        if (timeout_us == 0) {
+            /* give up, but if the mutex was just released for this thread
+             * pass the wake up on to the next waiter */
+            QUEUE_REMOVE(&mutex->m_queue, self);
+            sgx_thread_t waiter = SGX_THREAD_T_NULL;
+            if (mutex->m_owner == SGX_THREAD_T_NULL)
+                waiter = QUEUE_FIRST(&mutex->m_queue);
+            SPIN_UNLOCK(&mutex->m_lock);
+
+            int err = 0;
+            if (waiter != SGX_THREAD_T_NULL)
+                sgx_thread_set_untrusted_event_ocall(&err, TD2TCS(waiter));
+            return ETIMEDOUT;
+        }
+
+        sgx_thread_t waiter = SGX_THREAD_T_NULL;
+        QUEUE_FOREACH(waiter, &mutex->m_queue) {
+            if (waiter == self) break;
+        }
+
+        if (waiter == SGX_THREAD_T_NULL)
+            QUEUE_INSERT_TAIL(&mutex->m_queue, self);
+
+        SPIN_UNLOCK(&mutex->m_lock);
+
+        wait_untrusted_event_timeout(self, &timeout_us);
+    }
+
+    /* NOTREACHED */
+}
+
+int sgx_thread_cond_timedwait(sgx_thread_cond_t *cond, sgx_thread_mutex_t *mutex, uint64_t timeout_us)
+{
+    CHECK_PARAMETER(cond);
+    CHECK_PARAMETER(mutex);
+
+    sgx_thread_t self = (sgx_thread_t)get_thread_data();
+    int timedout = 0;
+
+    SPIN_LOCK(&cond->m_lock);
+    QUEUE_INSERT_TAIL(&cond->m_queue, self);
+
+    sgx_thread_t waiter = SGX_THREAD_T_NULL;
+    int ret = sgx_thread_mutex_unlock_lazy(mutex, &waiter);
+    if (ret != 0) {
+        QUEUE_REMOVE(&cond->m_queue, self);
+        SPIN_UNLOCK(&cond->m_lock);
+        return ret;
+    }
+
+    while (1) {
+        sgx_thread_t tmp = SGX_THREAD_T_NULL;
+
+        SPIN_UNLOCK(&cond->m_lock);
+        if (waiter != SGX_THREAD_T_NULL) {
+            sgx_thread_set_untrusted_event_ocall(&ret, TD2TCS(waiter));
+            waiter = SGX_THREAD_T_NULL;
+        }
+        wait_untrusted_event_timeout(self, &timeout_us);
+        SPIN_LOCK(&cond->m_lock);
+
+        QUEUE_FOREACH(tmp, &cond->m_queue) {
+            if (tmp == self) break;
+        }
+        if (tmp == SGX_THREAD_T_NULL) break;     /* signaled, even if the time is up */
+        if (timeout_us == 0) {
+            QUEUE_REMOVE(&cond->m_queue, self);
+            timedout = 1;
+            break;
+        }
+    }
+
+    SPIN_UNLOCK(&cond->m_lock);
+    sgx_thread_mutex_lock(mutex);
+
+    return timedout ? ETIMEDOUT : 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Runs sgx_thread_mutex on host threads, see trts_mock.cpp for the tRTS
+ * parts. Checks that:
+ *  - trylock, unlock by a non-owner, destroy while held and setspin keep
+ *    their return codes, and the spin count is clamped to the maximum;
+ *  - a locker that spins on a mutex held for long gives up and parks,
+ *    and is woken when the mutex is released;
+ *  - contended threads never share the critical section.
+ * The cost per lock and the number of parks are printed per spin count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sgx_thread.h"
+#include "thread_data.h"
+#include "trts_mock.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define BENCH_THREADS   4
+#define BENCH_LOCKS     50000
+#define CS_WORK         32      /* loop iterations inside the critical section */
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static sgx_thread_mutex_t g_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+
+/* API */
+static void *trylock_thread(void *arg)
+{
+    *(int *)arg = sgx_thread_mutex_trylock(&g_mutex);
+    return NULL;
+}
+
+static void *unlock_thread(void *arg)
+{
+    *(int *)arg = sgx_thread_mutex_unlock(&g_mutex);
+    return NULL;
+}
+
+static int run_on_thread(void *(*func)(void *))
+{
+    pthread_t thread;
+    int ret = -1;
+    CHECK(pthread_create(&thread, NULL, func, &ret) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    return ret;
+}
+
+static void check_api()
+{
+    sgx_thread_mutex_t adaptive = SGX_THREAD_ADAPTIVE_MUTEX_INITIALIZER(100);
+    CHECK((adaptive.m_control >> SGX_THREAD_MUTEX_SPIN_SHIFT) == 100);
+    CHECK(sgx_thread_mutex_lock(&adaptive) == 0);
+    CHECK(sgx_thread_mutex_trylock(&adaptive) == EBUSY);
+    CHECK(sgx_thread_mutex_unlock(&adaptive) == 0);
+
+    CHECK(sgx_thread_mutex_init(&g_mutex, NULL) == 0);
+    CHECK(sgx_thread_mutex_setspin(&g_mutex, SGX_THREAD_MUTEX_SPIN_MAX + 1) == 0);
+    CHECK((g_mutex.m_control >> SGX_THREAD_MUTEX_SPIN_SHIFT) == SGX_THREAD_MUTEX_SPIN_MAX);
+    CHECK((g_mutex.m_control & SGX_THREAD_MUTEX_TYPE_MASK) == SGX_THREAD_MUTEX_NONRECURSIVE);
+
+    CHECK(sgx_thread_mutex_unlock(&g_mutex) == EPERM);
+    CHECK(sgx_thread_mutex_lock(&g_mutex) == 0);
+    CHECK(run_on_thread(trylock_thread) == EBUSY);
+    CHECK(run_on_thread(unlock_thread) == EPERM);
+    CHECK(sgx_thread_mutex_destroy(&g_mutex) == EBUSY);
+    CHECK(sgx_thread_mutex_unlock(&g_mutex) == 0);
+    CHECK(sgx_thread_mutex_destroy(&g_mutex) == 0);
+    CHECK(sgx_thread_mutex_setspin(&g_mutex, 1) == EINVAL);
+}
+
+/* bounded spin */
+static volatile sgx_thread_t g_locker = SGX_THREAD_T_NULL;
+
+static void *locker_thread(void *arg)
+{
+    g_locker = (sgx_thread_t)get_thread_data();
+    *(int *)arg = sgx_thread_mutex_lock(&g_mutex);
+    if (*(int *)arg == 0)
+        *(int *)arg = sgx_thread_mutex_unlock(&g_mutex);
+    return NULL;
+}
+
+static void check_bounded_spin()
+{
+    pthread_t thread;
+    int ret = -1;
+
+    CHECK(sgx_thread_mutex_init(&g_mutex, NULL) == 0);
+    CHECK(sgx_thread_mutex_setspin(&g_mutex, SGX_THREAD_MUTEX_SPIN_MAX) == 0);
+    CHECK(sgx_thread_mutex_lock(&g_mutex) == 0);
+    CHECK(pthread_create(&thread, NULL, locker_thread, &ret) == 0);
+
+    /* the locker must end up parked while the mutex stays held */
+    uint64_t start = now_ns();
+    while ((g_locker == SGX_THREAD_T_NULL || !mock_thread_parked(g_locker))
+           && now_ns() - start < 5000000000ULL)
+        sched_yield();
+    CHECK(g_locker != SGX_THREAD_T_NULL && mock_thread_parked(g_locker));
+    CHECK(g_mutex.m_queue.m_first == g_locker);
+
+    CHECK(sgx_thread_mutex_unlock(&g_mutex) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(ret == 0);
+    CHECK(sgx_thread_mutex_destroy(&g_mutex) == 0);
+}
+
+/* contention */
+static volatile int g_inside = 0;
+static volatile int g_overlaps = 0;
+static volatile uint64_t g_counter = 0;
+
+static void *bench_thread(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < BENCH_LOCKS; i++) {
+        CHECK(sgx_thread_mutex_lock(&g_mutex) == 0);
+        if (__atomic_add_fetch(&g_inside, 1, __ATOMIC_SEQ_CST) != 1)
+            __atomic_add_fetch(&g_overlaps, 1, __ATOMIC_SEQ_CST);
+        for (int j = 0; j < CS_WORK; j++)
+            g_counter = g_counter + 1;
+        __atomic_sub_fetch(&g_inside, 1, __ATOMIC_SEQ_CST);
+        CHECK(sgx_thread_mutex_unlock(&g_mutex) == 0);
+    }
+    return NULL;
+}
+
+static void run_contention(uint32_t spin)
+{
+    pthread_t threads[BENCH_THREADS];
+
+    CHECK(sgx_thread_mutex_init(&g_mutex, NULL) == 0);
+    CHECK(sgx_thread_mutex_setspin(&g_mutex, spin) == 0);
+    g_counter = 0;
+    uint64_t waits = g_wait_ocalls;
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_THREADS; i++)
+        CHECK(pthread_create(&threads[i], NULL, bench_thread, NULL) == 0);
+    for (int i = 0; i < BENCH_THREADS; i++)
+        CHECK(pthread_join(threads[i], NULL) == 0);
+    uint64_t elapsed = now_ns() - start;
+
+    CHECK(g_overlaps == 0);
+    CHECK(g_counter == (uint64_t)BENCH_THREADS * BENCH_LOCKS * CS_WORK);
+    CHECK(sgx_thread_mutex_destroy(&g_mutex) == 0);
+
+    uint64_t locks = (uint64_t)BENCH_THREADS * BENCH_LOCKS;
+    printf("  spin %5u: %8.1f ns/lock, %7.2f parks per 1000 locks\n", spin,
+           (double)elapsed / (double)locks, (double)(g_wait_ocalls - waits) * 1000.0 / (double)locks);
+}
+
+int main()
+{
+    check_api();
+    check_bounded_spin();
+
+    printf("mutex_test: %d threads x %d locks, %ld cpus\n", BENCH_THREADS, BENCH_LOCKS,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    run_contention(0);
+    run_contention(100);
+    run_contention(1000);
+    run_contention(SGX_THREAD_MUTEX_SPIN_MAX);
+    return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Runs sgx_thread_rwlock on host threads, see trts_mock.cpp for the tRTS
+ * parts. Checks that:
+ *  - readers share the lock, writers get it alone, and the EBUSY, EDEADLK
+ *    and EPERM returns are kept;
+ *  - a waiting writer blocks new readers, gets the lock before them once
+ *    the readers left, and the parked readers are all woken after it;
+ *  - under a mixed load a writer never sees anyone else inside.
+ * The read throughput is printed per number of reader threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sgx_thread.h"
+#include "thread_data.h"
+#include "trts_mock.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define PARKED_READERS  3
+#define MIXED_READERS   3
+#define MIXED_WRITERS   2
+#define MIXED_ROUNDS    20000
+#define BENCH_MAX       4
+#define BENCH_READS     200000
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void wait_parked(volatile sgx_thread_t *thread)
+{
+    uint64_t start = now_ns();
+    while ((*thread == SGX_THREAD_T_NULL || !mock_thread_parked(*thread))
+           && now_ns() - start < 5000000000ULL)
+        sched_yield();
+    CHECK(*thread != SGX_THREAD_T_NULL && mock_thread_parked(*thread));
+}
+
+static sgx_thread_rwlock_t g_rwlock = SGX_THREAD_RWLOCK_INITIALIZER;
+
+/* API */
+static void *tryrdlock_thread(void *arg)
+{
+    *(int *)arg = sgx_thread_rwlock_tryrdlock(&g_rwlock);
+    if (*(int *)arg == 0)
+        CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    return NULL;
+}
+
+static void *trywrlock_thread(void *arg)
+{
+    *(int *)arg = sgx_thread_rwlock_trywrlock(&g_rwlock);
+    if (*(int *)arg == 0)
+        CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    return NULL;
+}
+
+static int run_on_thread(void *(*func)(void *))
+{
+    pthread_t thread;
+    int ret = -1;
+    CHECK(pthread_create(&thread, NULL, func, &ret) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    return ret;
+}
+
+static void check_api()
+{
+    CHECK(sgx_thread_rwlock_init(&g_rwlock, NULL) == 0);
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == EPERM);
+
+    CHECK(sgx_thread_rwlock_rdlock(&g_rwlock) == 0);
+    CHECK(sgx_thread_rwlock_rdlock(&g_rwlock) == 0);
+    CHECK(run_on_thread(tryrdlock_thread) == 0);
+    CHECK(run_on_thread(trywrlock_thread) == EBUSY);
+    CHECK(sgx_thread_rwlock_trywrlock(&g_rwlock) == EBUSY);
+    CHECK(sgx_thread_rwlock_destroy(&g_rwlock) == EBUSY);
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    CHECK(g_rwlock.m_reader_count == 0);
+
+    CHECK(sgx_thread_rwlock_wrlock(&g_rwlock) == 0);
+    CHECK(sgx_thread_rwlock_wrlock(&g_rwlock) == EDEADLK);
+    CHECK(sgx_thread_rwlock_rdlock(&g_rwlock) == EDEADLK);
+    CHECK(run_on_thread(tryrdlock_thread) == EBUSY);
+    CHECK(run_on_thread(trywrlock_thread) == EBUSY);
+    CHECK(sgx_thread_rwlock_destroy(&g_rwlock) == EBUSY);
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == EPERM);
+    CHECK(sgx_thread_rwlock_destroy(&g_rwlock) == 0);
+}
+
+/* writer preference */
+static volatile sgx_thread_t g_writer = SGX_THREAD_T_NULL;
+static volatile sgx_thread_t g_readers[PARKED_READERS];
+static volatile int g_order = 0;
+static volatile int g_writer_order = 0;
+static volatile int g_reader_order[PARKED_READERS];
+
+static void *writer_thread(void *arg)
+{
+    (void)arg;
+    g_writer = (sgx_thread_t)get_thread_data();
+    CHECK(sgx_thread_rwlock_wrlock(&g_rwlock) == 0);
+    g_writer_order = __atomic_add_fetch(&g_order, 1, __ATOMIC_SEQ_CST);
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    return NULL;
+}
+
+static void *reader_thread(void *arg)
+{
+    size_t i = (size_t)arg;
+    g_readers[i] = (sgx_thread_t)get_thread_data();
+    CHECK(sgx_thread_rwlock_rdlock(&g_rwlock) == 0);
+    g_reader_order[i] = __atomic_add_fetch(&g_order, 1, __ATOMIC_SEQ_CST);
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    return NULL;
+}
+
+static void check_writer_preference()
+{
+    pthread_t writer, readers[PARKED_READERS];
+
+    CHECK(sgx_thread_rwlock_init(&g_rwlock, NULL) == 0);
+    CHECK(sgx_thread_rwlock_rdlock(&g_rwlock) == 0);
+
+    CHECK(pthread_create(&writer, NULL, writer_thread, NULL) == 0);
+    wait_parked(&g_writer);
+    CHECK(g_rwlock.m_writer_queue.m_first == g_writer);
+
+    /* the queued writer keeps new readers out */
+    CHECK(run_on_thread(tryrdlock_thread) == EBUSY);
+    for (size_t i = 0; i < PARKED_READERS; i++) {
+        CHECK(pthread_create(&readers[i], NULL, reader_thread, (void *)i) == 0);
+        wait_parked(&g_readers[i]);
+    }
+    CHECK(g_order == 0);
+
+    /* the last reader out lets the writer in, the writer the readers */
+    CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    CHECK(pthread_join(writer, NULL) == 0);
+    for (size_t i = 0; i < PARKED_READERS; i++)
+        CHECK(pthread_join(readers[i], NULL) == 0);
+
+    CHECK(g_writer_order == 1);
+    for (size_t i = 0; i < PARKED_READERS; i++)
+        CHECK(g_reader_order[i] > 1);
+    CHECK(sgx_thread_rwlock_destroy(&g_rwlock) == 0);
+}
+
+/* mixed load */
+static volatile int g_active_readers = 0;
+static volatile int g_active_writers = 0;
+static volatile int g_violations = 0;
+
+static void *mixed_reader(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < MIXED_ROUNDS; i++) {
+        CHECK(sgx_thread_rwlock_rdlock(&g_rwlock) == 0);
+        __atomic_add_fetch(&g_active_readers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&g_active_writers, __ATOMIC_SEQ_CST) != 0)
+            __atomic_add_fetch(&g_violations, 1, __ATOMIC_SEQ_CST);
+        __atomic_sub_fetch(&g_active_readers, 1, __ATOMIC_SEQ_CST);
+        CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    }
+    return NULL;
+}
+
+static void *mixed_writer(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < MIXED_ROUNDS / 10; i++) {
+        CHECK(sgx_thread_rwlock_wrlock(&g_rwlock) == 0);
+        if (__atomic_add_fetch(&g_active_writers, 1, __ATOMIC_SEQ_CST) != 1
+            || __atomic_load_n(&g_active_readers, __ATOMIC_SEQ_CST) != 0)
+            __atomic_add_fetch(&g_violations, 1, __ATOMIC_SEQ_CST);
+        sched_yield();
+        __atomic_sub_fetch(&g_active_writers, 1, __ATOMIC_SEQ_CST);
+        CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    }
+    return NULL;
+}
+
+static void check_mixed_load()
+{
+    pthread_t threads[MIXED_READERS + MIXED_WRITERS];
+
+    CHECK(sgx_thread_rwlock_init(&g_rwlock, NULL) == 0);
+    for (int i = 0; i < MIXED_READERS + MIXED_WRITERS; i++)
+        CHECK(pthread_create(&threads[i], NULL, i < MIXED_READERS ? mixed_reader : mixed_writer, NULL) == 0);
+    for (int i = 0; i < MIXED_READERS + MIXED_WRITERS; i++)
+        CHECK(pthread_join(threads[i], NULL) == 0);
+    CHECK(g_violations == 0);
+    CHECK(sgx_thread_rwlock_destroy(&g_rwlock) == 0);
+}
+
+/* reader scaling */
+static void *bench_reader(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < BENCH_READS; i++) {
+        CHECK(sgx_thread_rwlock_rdlock(&g_rwlock) == 0);
+        CHECK(sgx_thread_rwlock_unlock(&g_rwlock) == 0);
+    }
+    return NULL;
+}
+
+static void run_readers(int count)
+{
+    pthread_t threads[BENCH_MAX];
+
+    CHECK(sgx_thread_rwlock_init(&g_rwlock, NULL) == 0);
+    uint64_t start = now_ns();
+    for (int i = 0; i < count; i++)
+        CHECK(pthread_create(&threads[i], NULL, bench_reader, NULL) == 0);
+    for (int i = 0; i < count; i++)
+        CHECK(pthread_join(threads[i], NULL) == 0);
+    uint64_t elapsed = now_ns() - start;
+    CHECK(sgx_thread_rwlock_destroy(&g_rwlock) == 0);
+
+    printf("  %d readers: %8.2f M reads/s\n", count,
+           (double)count * BENCH_READS * 1000.0 / (double)elapsed);
+}
+
+int main()
+{
+    check_api();
+    check_writer_preference();
+    uint64_t waits = g_wait_ocalls;
+    check_mixed_load();
+
+    printf("rwlock_test: %d readers + %d writers, %.2f parks per 1000 locks, %ld cpus\n",
+           MIXED_READERS, MIXED_WRITERS,
+           (double)(g_wait_ocalls - waits) * 1000.0 / (MIXED_ROUNDS * (MIXED_READERS + MIXED_WRITERS / 10.0)),
+           sysconf(_SC_NPROCESSORS_ONLN));
+    for (int count = 1; count <= BENCH_MAX; count *= 2)
+        run_readers(count);
+    return 0;
+}
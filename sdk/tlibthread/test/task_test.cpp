@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Runs the work-stealing task runtime on host threads. The tRTS primitives
+ * it calls are mocked with pthreads, the runtime only uses one mutex and one
+ * condition variable. Checks that:
+ *  - at most SGX_TASK_MAX_WORKERS threads become workers at a time;
+ *  - workers leaving in any order give their slots back, so the runtime
+ *    can be restarted with a different set of workers;
+ *  - parallel_for visits every index once and fork/join computes the
+ *    right result, with and without workers.
+ * The time of both is printed per number of workers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sgx_task.h"
+#include "sgx_thread.h"
+#include "sgx_spinlock.h"
+#include "sgx_trts.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define FOR_ITEMS       (1 << 20)
+#define FOR_GRAIN       1024
+#define FIB_N           24
+#define FIB_CUTOFF      10
+#define FIB_RESULT      46368
+
+/* Mocked tRTS primitives */
+static pthread_mutex_t g_host_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_host_cond = PTHREAD_COND_INITIALIZER;
+
+extern "C" {
+int sgx_thread_mutex_lock(sgx_thread_mutex_t *) { return pthread_mutex_lock(&g_host_mutex); }
+int sgx_thread_mutex_unlock(sgx_thread_mutex_t *) { return pthread_mutex_unlock(&g_host_mutex); }
+int sgx_thread_cond_wait(sgx_thread_cond_t *, sgx_thread_mutex_t *) { return pthread_cond_wait(&g_host_cond, &g_host_mutex); }
+int sgx_thread_cond_signal(sgx_thread_cond_t *) { return pthread_cond_signal(&g_host_cond); }
+int sgx_thread_cond_broadcast(sgx_thread_cond_t *) { return pthread_cond_broadcast(&g_host_cond); }
+sgx_thread_t sgx_thread_self(void) { return (sgx_thread_t)pthread_self(); }
+int sgx_is_within_enclave(const void *, size_t) { return 1; }
+
+uint32_t sgx_spin_lock(sgx_spinlock_t *lock)
+{
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0)
+        sched_yield();
+    return 0;
+}
+
+uint32_t sgx_spin_unlock(sgx_spinlock_t *lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Workers */
+static volatile int g_joined_busy = 0;     /* EAGAIN returns */
+
+static void *worker_thread(void *arg)
+{
+    int ret = sgx_task_worker_run();
+    if (ret == EAGAIN)
+        __atomic_add_fetch(&g_joined_busy, 1, __ATOMIC_SEQ_CST);
+    *(int *)arg = ret;
+    return NULL;
+}
+
+typedef struct _workers_t
+{
+    unsigned int count;
+    pthread_t threads[SGX_TASK_MAX_WORKERS + 1];
+    int rets[SGX_TASK_MAX_WORKERS + 1];
+} workers_t;
+
+static void start_workers(workers_t *workers, unsigned int count)
+{
+    CHECK(sgx_task_runtime_init(64) == 0);
+    workers->count = count;
+    for (unsigned int i = 0; i < count; i++)
+        CHECK(pthread_create(&workers->threads[i], NULL, worker_thread, &workers->rets[i]) == 0);
+}
+
+static void stop_workers(workers_t *workers)
+{
+    CHECK(sgx_task_runtime_shutdown() == 0);
+    for (unsigned int i = 0; i < workers->count; i++)
+        CHECK(pthread_join(workers->threads[i], NULL) == 0);
+}
+
+/* parallel_for */
+static unsigned char g_visits[FOR_ITEMS];
+
+static void for_body(size_t begin, size_t end, void *arg)
+{
+    (void)arg;
+    for (size_t i = begin; i < end; i++)
+        __atomic_add_fetch(&g_visits[i], 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t run_parallel_for()
+{
+    memset(g_visits, 0, sizeof(g_visits));
+    uint64_t start = now_ns();
+    CHECK(sgx_task_parallel_for(0, FOR_ITEMS, FOR_GRAIN, for_body, NULL) == 0);
+    uint64_t elapsed = now_ns() - start;
+    for (size_t i = 0; i < FOR_ITEMS; i++)
+        CHECK(g_visits[i] == 1);
+    return elapsed;
+}
+
+/* fork/join */
+typedef struct _fib_t
+{
+    unsigned int n;
+    unsigned long result;
+} fib_t;
+
+static unsigned long fib_serial(unsigned int n)
+{
+    return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+static void fib_task(void *arg)
+{
+    fib_t *fib = (fib_t *)arg;
+    if (fib->n < FIB_CUTOFF) {
+        fib->result = fib_serial(fib->n);
+        return;
+    }
+    sgx_task_group_t group = SGX_TASK_GROUP_INITIALIZER;
+    fib_t left = {fib->n - 1, 0}, right = {fib->n - 2, 0};
+    CHECK(sgx_task_spawn(&group, fib_task, &left) == 0);
+    fib_task(&right);
+    CHECK(sgx_task_group_wait(&group) == 0);
+    fib->result = left.result + right.result;
+}
+
+static uint64_t run_fork_join()
+{
+    fib_t fib = {FIB_N, 0};
+    uint64_t start = now_ns();
+    fib_task(&fib);
+    uint64_t elapsed = now_ns() - start;
+    CHECK(fib.result == FIB_RESULT);
+    return elapsed;
+}
+
+int main()
+{
+    workers_t workers;
+
+    /* one thread more than there are slots, exactly one is refused */
+    start_workers(&workers, SGX_TASK_MAX_WORKERS + 1);
+    uint64_t start = now_ns();
+    while (g_joined_busy == 0 && now_ns() - start < 5000000000ULL)
+        sched_yield();
+    CHECK(g_joined_busy == 1);
+    run_parallel_for();
+    run_fork_join();
+    stop_workers(&workers);
+    int refused = 0;
+    for (unsigned int i = 0; i < workers.count; i++) {
+        CHECK(workers.rets[i] == 0 || workers.rets[i] == EAGAIN);
+        refused += workers.rets[i] == EAGAIN;
+    }
+    CHECK(refused == 1);
+
+    /* a stopped runtime takes no workers until it is restarted */
+    CHECK(sgx_task_worker_run() == ECANCELED);
+
+    /* the slots were all given back, whatever order the workers left in */
+    g_joined_busy = 0;
+    start_workers(&workers, SGX_TASK_MAX_WORKERS);
+    run_parallel_for();
+    stop_workers(&workers);
+    CHECK(g_joined_busy == 0);
+    for (unsigned int i = 0; i < workers.count; i++)
+        CHECK(workers.rets[i] == 0);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("task_test: %d items, grain %d / fib(%d)\n", FOR_ITEMS, FOR_GRAIN, FIB_N);
+    for (unsigned int count = 0; count <= SGX_TASK_MAX_WORKERS && count < (unsigned int)cpus; count = count ? count * 2 : 1) {
+        start_workers(&workers, count);
+        uint64_t for_ns = run_parallel_for();
+        uint64_t fib_ns = run_fork_join();
+        stop_workers(&workers);
+        printf("  %2u workers: parallel_for %8.3f ms, fork/join %8.3f ms\n",
+               count, (double)for_ns / 1e6, (double)fib_ns / 1e6);
+    }
+    return 0;
+}
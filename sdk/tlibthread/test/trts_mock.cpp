@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include "sgx_trts.h"
+#include "sgx_spinlock.h"
+#include "../sethread_internal.h"
+#include "trts_mock.h"
+
+typedef struct _host_thread_t
+{
+    thread_data_t   td;             /* first, so the TD is the thread too */
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             signaled;
+    int             parked;
+} host_thread_t;
+
+volatile uint64_t g_wait_ocalls = 0;
+volatile uint64_t g_set_ocalls = 0;
+
+static __thread host_thread_t *t_self = NULL;
+
+static host_thread_t *tcs_to_thread(const void *tcs)
+{
+    return (host_thread_t *)((size_t)tcs - (size_t)STATIC_STACK_SIZE - (size_t)SE_GUARD_PAGE_SIZE);
+}
+
+static void set_event(const void *tcs)
+{
+    host_thread_t *thread = tcs_to_thread(tcs);
+    pthread_mutex_lock(&thread->lock);
+    thread->signaled = 1;
+    pthread_cond_signal(&thread->cond);
+    pthread_mutex_unlock(&thread->lock);
+}
+
+/* threads are never freed, a released waiter may still be signaled */
+extern "C" thread_data_t *get_thread_data(void)
+{
+    if (t_self == NULL) {
+        t_self = (host_thread_t *)calloc(1, sizeof(host_thread_t));
+        if (t_self == NULL)
+            abort();
+        pthread_mutex_init(&t_self->lock, NULL);
+        pthread_cond_init(&t_self->cond, NULL);
+        /* so that TD2TCS() gives an address that maps back to the thread */
+        t_self->td.stack_base_addr = (sys_word_t)t_self;
+    }
+    return &t_self->td;
+}
+
+int mock_thread_parked(sgx_thread_t thread)
+{
+    return __atomic_load_n(&((host_thread_t *)thread)->parked, __ATOMIC_SEQ_CST);
+}
+
+extern "C" {
+int sgx_is_within_enclave(const void *, size_t) { return 1; }
+
+uint32_t sgx_spin_lock(sgx_spinlock_t *lock)
+{
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0)
+        sched_yield();
+    return 0;
+}
+
+uint32_t sgx_spin_unlock(sgx_spinlock_t *lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+sgx_status_t sgx_thread_wait_untrusted_event_ocall(int *retval, const void *self)
+{
+    host_thread_t *thread = tcs_to_thread(self);
+    __atomic_add_fetch(&g_wait_ocalls, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&thread->lock);
+    __atomic_store_n(&thread->parked, 1, __ATOMIC_SEQ_CST);
+    while (!thread->signaled)
+        pthread_cond_wait(&thread->cond, &thread->lock);
+    thread->signaled = 0;
+    __atomic_store_n(&thread->parked, 0, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&thread->lock);
+    *retval = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_thread_set_untrusted_event_ocall(int *retval, const void *waiter)
+{
+    __atomic_add_fetch(&g_set_ocalls, 1, __ATOMIC_SEQ_CST);
+    set_event(waiter);
+    *retval = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_thread_set_multiple_untrusted_events_ocall(int *retval, const void **waiters, size_t total)
+{
+    __atomic_add_fetch(&g_set_ocalls, 1, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < total; i++)
+        set_event(waiters[i]);
+    *retval = 0;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t sgx_thread_setwait_untrusted_events_ocall(int *retval, const void *waiter, const void *self)
+{
+    sgx_thread_set_untrusted_event_ocall(retval, waiter);
+    return sgx_thread_wait_untrusted_event_ocall(retval, self);
+}
+}
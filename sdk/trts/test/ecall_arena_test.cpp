@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Checks the per-TCS ECALL arena the trusted bridges allocate from:
+ *  - a run of switchless ECALLs, which trts_ecall() never sees, keeps
+ *    reusing the same arena space when each dispatch rewinds to its mark,
+ *    and falls back to malloc() once the arena is used up without it;
+ *  - a nested ECALL gives back only what it took;
+ *  - every thread has an arena of its own.
+ * The thread data and the spinlock of the tRTS are mocked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "thread_data.h"
+#include "sgx_edger8r.h"
+#include "sgx_spinlock.h"
+
+#define CHECK(cond) do {                                                \
+    if (!(cond)) {                                                      \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                        \
+    }                                                                   \
+} while (0)
+
+#define ARENA_SIZE      0x1000
+#define BUF_SIZE        200     /* 208 bytes once aligned */
+#define DISPATCHES      1000
+
+/* Mocked tRTS, a page-aligned fake TD per host thread */
+static __thread thread_data_t *t_td = NULL;
+
+extern "C" thread_data_t *get_thread_data(void)
+{
+    if (t_td == NULL) {
+        CHECK(posix_memalign((void **)&t_td, 0x1000, 0x1000) == 0);
+        memset(t_td, 0, sizeof(*t_td));
+        t_td->self_addr = (sys_word_t)t_td;
+    }
+    return t_td;
+}
+
+extern "C" uint32_t sgx_spin_lock(sgx_spinlock_t *lock)
+{
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0)
+        ;
+    return 0;
+}
+
+extern "C" uint32_t sgx_spin_unlock(sgx_spinlock_t *lock)
+{
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int in_arena(const void *base, const void *ptr)
+{
+    return (uintptr_t)ptr - (uintptr_t)base < ARENA_SIZE;
+}
+
+/* What a trusted bridge does with two [in] buffers */
+static void bridge(void **a, void **b)
+{
+    *a = sgx_ecall_arena_alloc(BUF_SIZE);
+    *b = sgx_ecall_arena_alloc(BUF_SIZE);
+    CHECK(*a != NULL && *b != NULL);
+    memset(*a, 0xa5, BUF_SIZE);
+    memset(*b, 0x5a, BUF_SIZE);
+}
+
+static void *arena_thread(void *arg)
+{
+    void **base = (void **)arg;
+
+    /* the first buffer of a thread is the start of its arena */
+    CHECK(sgx_ecall_arena_mark() == 0);
+    void *first = NULL, *second = NULL;
+    bridge(&first, &second);
+    *base = first;
+    CHECK(in_arena(first, second) && second != first);
+    sgx_ecall_arena_rewind(0);
+
+    /* dispatched like the switchless worker does it, the same space is
+     * reused by every call */
+    for (int i = 0; i < DISPATCHES; i++) {
+        size_t mark = sgx_ecall_arena_mark();
+        void *a = NULL, *b = NULL;
+        bridge(&a, &b);
+        CHECK(a == first && b == second);
+        sgx_ecall_arena_free(b);
+        sgx_ecall_arena_free(a);
+        sgx_ecall_arena_rewind(mark);
+    }
+    CHECK(sgx_ecall_arena_mark() == 0);
+
+    /* a nested ECALL keeps the buffers of the outer one */
+    size_t outer = sgx_ecall_arena_mark();
+    void *a = NULL, *b = NULL;
+    bridge(&a, &b);
+    size_t inner = sgx_ecall_arena_mark();
+    CHECK(inner == outer + 2 * 208);
+    void *c = NULL, *d = NULL;
+    bridge(&c, &d);
+    CHECK(in_arena(first, c) && c != a && c != b);
+    sgx_ecall_arena_rewind(inner);
+    CHECK(sgx_ecall_arena_mark() == inner);
+    CHECK(((uint8_t *)a)[0] == 0xa5 && ((uint8_t *)b)[0] == 0x5a);
+    sgx_ecall_arena_rewind(outer);
+
+    /* without the rewind the arena runs out and malloc() takes over */
+    int in = 0, out = 0;
+    for (int i = 0; i < DISPATCHES; i++) {
+        bridge(&a, &b);
+        in += in_arena(first, a) + in_arena(first, b);
+        out += !in_arena(first, a) + !in_arena(first, b);
+        sgx_ecall_arena_free(a);
+        sgx_ecall_arena_free(b);
+    }
+    CHECK(in == ARENA_SIZE / 208);
+    CHECK(out == 2 * DISPATCHES - in);
+    sgx_ecall_arena_rewind(0);
+    return NULL;
+}
+
+int main(void)
+{
+    void *base0 = NULL, *base1 = NULL;
+    pthread_t thread;
+
+    CHECK(pthread_create(&thread, NULL, arena_thread, &base0) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(pthread_create(&thread, NULL, arena_thread, &base1) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(base0 != NULL && base1 != NULL && base0 != base1);
+
+    printf("ecall_arena_test: %d dispatches of 2 x %d bytes kept in one arena\n", DISPATCHES, BUF_SIZE);
+    return 0;
+}
@@ -39,10 +39,10 @@
 #include "global_data.h"
 #include "trts_internal.h"
 #include "internal/rts.h"
+#include "sgx_spinlock.h"
 
 #ifdef SE_SIM
 #include "t_instructions.h"    /* for `g_global_data_sim' */
-#include "sgx_spinlock.h"
 #include "se_cpu_feature.h"
 #endif
 
@@ -122,6 +122,124 @@ int sgx_is_outside_enclave(const void *addr, size_t size)
     return 0;
 }
 
+// Untrusted regions registered for zero-copy [shared] ECALL parameters.
+#define SHARED_REGION_MAX 16
+
+typedef struct _shared_region_t
+{
+    size_t start;
+    size_t end;     // inclusive, 0 marks a free slot
+} shared_region_t;
+
+static shared_region_t g_shared_regions[SHARED_REGION_MAX];
+static sgx_spinlock_t g_shared_region_lock = SGX_SPINLOCK_INITIALIZER;
+
+// sgx_register_shared_region()
+// Parameters:
+//      addr - the start address of the untrusted region
+//      size - the size of the region
+// Return Value:
+//      SGX_SUCCESS - the region is registered
+//      SGX_ERROR_INVALID_PARAMETER - the region is empty, wraps around, is not
+//          strictly outside the enclave or overlaps a registered region
+//      SGX_ERROR_OUT_OF_MEMORY - no free slot is left
+//
+sgx_status_t sgx_register_shared_region(const void *addr, size_t size)
+{
+    size_t start = reinterpret_cast<size_t>(addr);
+    if(addr == NULL || size == 0 || start + size - 1 < start
+        || !sgx_is_outside_enclave(addr, size))
+    {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    size_t end = start + size - 1;
+    sgx_status_t ret = SGX_ERROR_OUT_OF_MEMORY;
+    int free_slot = -1;
+
+    sgx_spin_lock(&g_shared_region_lock);
+    for(int i = 0; i < SHARED_REGION_MAX; i++)
+    {
+        if(g_shared_regions[i].end == 0)
+        {
+            if(free_slot < 0)
+                free_slot = i;
+        }
+        else if(start <= g_shared_regions[i].end && end >= g_shared_regions[i].start)
+        {
+            free_slot = -1;
+            ret = SGX_ERROR_INVALID_PARAMETER;
+            break;
+        }
+    }
+    if(free_slot >= 0)
+    {
+        g_shared_regions[free_slot].start = start;
+        g_shared_regions[free_slot].end = end;
+        ret = SGX_SUCCESS;
+    }
+    sgx_spin_unlock(&g_shared_region_lock);
+    return ret;
+}
+
+// sgx_unregister_shared_region()
+// Parameters:
+//      addr - the start address passed to sgx_register_shared_region()
+// Return Value:
+//      SGX_SUCCESS - the region is removed
+//      SGX_ERROR_INVALID_PARAMETER - no region starts at addr
+//
+sgx_status_t sgx_unregister_shared_region(const void *addr)
+{
+    size_t start = reinterpret_cast<size_t>(addr);
+    sgx_status_t ret = SGX_ERROR_INVALID_PARAMETER;
+
+    sgx_spin_lock(&g_shared_region_lock);
+    for(int i = 0; i < SHARED_REGION_MAX; i++)
+    {
+        if(g_shared_regions[i].end != 0 && g_shared_regions[i].start == start)
+        {
+            g_shared_regions[i].start = 0;
+            g_shared_regions[i].end = 0;
+            ret = SGX_SUCCESS;
+            break;
+        }
+    }
+    sgx_spin_unlock(&g_shared_region_lock);
+    return ret;
+}
+
+// sgx_is_within_shared_region()
+// Parameters:
+//      addr - the start address of the buffer
+//      size - the size of the buffer
+// Return Value:
+//      1 - the buffer lies entirely within one registered shared region
+//      0 - the buffer is not covered by a single region, or wraps around
+//
+int sgx_is_within_shared_region(const void *addr, size_t size)
+{
+    size_t start = reinterpret_cast<size_t>(addr);
+    size_t end = size > 0 ? start + size - 1 : start;
+    int ret = 0;
+
+    if(end < start)
+    {
+        return 0;
+    }
+    sgx_spin_lock(&g_shared_region_lock);
+    for(int i = 0; i < SHARED_REGION_MAX; i++)
+    {
+        if(g_shared_regions[i].end != 0
+            && start >= g_shared_regions[i].start && end <= g_shared_regions[i].end)
+        {
+            ret = 1;
+            break;
+        }
+    }
+    sgx_spin_unlock(&g_shared_region_lock);
+    return ret;
+}
+
 // sgx_ocalloc()
 // Parameters:
 //      size - bytes to allocate on the outside stack
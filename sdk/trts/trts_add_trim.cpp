@@ -356,6 +356,24 @@ int apply_pages_within_exception(void *start_address, size_t page_count)
 
 }
 
+#ifndef SE_SIM
+// Commit a trimmed range with one EDMM_TRIM_COMMIT_BATCH, or page by page
+// with EDMM_TRIM_COMMIT if the uRTS predates the batch OCALL.
+static int trim_commit_range(size_t start, size_t end)
+{
+    edmm_trim_range_t range = { start, end };
+
+    sgx_status_t status = trim_range_commit_batch_ocall(&range, 1);
+    if (status == SGX_ERROR_INVALID_FUNCTION)
+    {
+        status = SGX_SUCCESS;
+        for (size_t addr = start; addr < end && status == SGX_SUCCESS; addr += SE_PAGE_SIZE)
+            status = trim_range_commit_ocall(addr);
+    }
+    return (int)status;
+}
+#endif
+
 // High level API to EACCEPT pages
 int apply_EPC_pages(void *start_address, size_t page_count)
 {
@@ -411,21 +429,16 @@ int trim_EPC_pages(void *start_address, size_t page_count)
 
     // trim ocall
     rc = trim_range_ocall(start, end);
-    assert(rc == 0);
+    if (rc != 0)
+        return rc;
 
     rc = sgx_accept_forward(SI_FLAG_TRIM | SI_FLAG_MODIFIED, start, end);
-    assert(rc == 0);
-    
-    // trim commit ocall
-    size_t i = start;
-    while (i < end)
-    {
-        rc = trim_range_commit_ocall(i);
-        assert(rc == 0);
-        i += SE_PAGE_SIZE;
-    }
+    if (rc != 0)
+        return rc;
 
-    return rc;
+    // trim commit ocall, the pages are removed before the caller can
+    // apply them again
+    return trim_commit_range(start, end);
 #endif
 }
 
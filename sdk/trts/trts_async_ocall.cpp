@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "sgx_edger8r.h"
+#include "sgx_trts.h"
+#include "sgx_spinlock.h"
+#include "thread_data.h"
+#include "trts_internal.h"
+#include "internal/rts.h"
+
+/* [async] OCALLs are marshaled into a slot of a ring allocated by the uRTS
+ * and return once the slot is marked ready, a uRTS worker runs them in the
+ * order the slots were reserved. When the ring is full, unsupported by the
+ * uRTS or the marshaling structure is too large for a slot, the OCALL is
+ * made synchronously after the queued ones are flushed.
+ */
+#define ASYNC_RING_UNKNOWN      0
+#define ASYNC_RING_SETTING_UP   1
+#define ASYNC_RING_AVAILABLE    2
+#define ASYNC_RING_UNAVAILABLE  3
+
+static volatile int g_async_ring_state = ASYNC_RING_UNKNOWN;
+static async_ocall_ring_t *g_async_ring = NULL;
+static sgx_spinlock_t g_async_lock = SGX_SPINLOCK_INITIALIZER;
+// Slots reserved so far, kept inside the enclave so the order cannot be
+// changed from outside.
+static uint64_t g_async_tail = 0;
+// The thread holding each reserved slot, and the number of such slots.
+static thread_data_t *g_async_owner[ASYNC_OCALL_RING_SLOTS];
+static volatile uint32_t g_async_reserved = 0;
+
+// The uRTS id of the OCALL table passed by the current root ECALL of the
+// thread, asked for on its first [async] OCALL.
+#define ASYNC_TABLE_UNKNOWN     (ASYNC_OCALL_TABLE_NONE - 1)
+static __thread uint32_t t_async_table = ASYNC_TABLE_UNKNOWN;
+
+void async_ocall_root_ecall()
+{
+    t_async_table = ASYNC_TABLE_UNKNOWN;
+}
+
+static bool async_table_ready()
+{
+    if (t_async_table != ASYNC_TABLE_UNKNOWN)
+        return t_async_table != ASYNC_OCALL_TABLE_NONE;
+
+    uint32_t table = ASYNC_OCALL_TABLE_NONE;
+    ms_async_ocall_table_t *ms = reinterpret_cast<ms_async_ocall_table_t *>(sgx_ocalloc(sizeof(ms_async_ocall_table_t)));
+    if (ms != NULL)
+    {
+        ms->table = ASYNC_OCALL_TABLE_NONE;
+        sgx_status_t status = sgx_ocall(ASYNC_OCALL_TABLE, ms);
+        if (status == SGX_SUCCESS)
+            table = ms->table;
+        else if (status == SGX_ERROR_INVALID_FUNCTION)
+            table = 0;  // the uRTS runs every queued OCALL with the table of the ring
+    }
+    sgx_ocfree();
+    // the uRTS is out of table ids, this ECALL uses synchronous OCALLs
+    if (table >= ASYNC_OCALL_MAX_TABLES)
+        table = ASYNC_OCALL_TABLE_NONE;
+    t_async_table = table;
+    return table != ASYNC_OCALL_TABLE_NONE;
+}
+
+static bool async_ring_ready()
+{
+    int state = g_async_ring_state;
+    if (state == ASYNC_RING_AVAILABLE)
+        return true;
+    if (state != ASYNC_RING_UNKNOWN)
+        return false;
+    // Only one thread asks the uRTS for the ring, the others use the
+    // synchronous path meanwhile.
+    if (!__sync_bool_compare_and_swap(&g_async_ring_state, ASYNC_RING_UNKNOWN, ASYNC_RING_SETTING_UP))
+        return g_async_ring_state == ASYNC_RING_AVAILABLE;
+
+    state = ASYNC_RING_UNAVAILABLE;
+    ms_async_ocall_setup_t *ms = reinterpret_cast<ms_async_ocall_setup_t *>(sgx_ocalloc(sizeof(ms_async_ocall_setup_t)));
+    if (ms != NULL)
+    {
+        ms->ring = NULL;
+        // A uRTS without [async] support fails it with SGX_ERROR_INVALID_FUNCTION.
+        if (sgx_ocall(ASYNC_OCALL_SETUP, ms) == SGX_SUCCESS)
+        {
+            async_ocall_ring_t *ring = ms->ring;
+            if (ring != NULL && sgx_is_outside_enclave(ring, sizeof(async_ocall_ring_t)))
+            {
+                g_async_ring = ring;
+                state = ASYNC_RING_AVAILABLE;
+            }
+        }
+    }
+    sgx_ocfree();
+    __sync_synchronize();
+    g_async_ring_state = state;
+    return state == ASYNC_RING_AVAILABLE;
+}
+
+static void *async_ring_reserve(size_t size)
+{
+    if (size > ASYNC_OCALL_SLOT_DATA_SIZE || !async_ring_ready() || !async_table_ready())
+        return NULL;
+
+    void *data = NULL;
+    sgx_spin_lock(&g_async_lock);
+    size_t i = static_cast<size_t>(g_async_tail % ASYNC_OCALL_RING_SLOTS);
+    async_ocall_slot_t *slot = &g_async_ring->slots[i];
+    if (slot->state == ASYNC_OCALL_SLOT_FREE)
+    {
+        slot->state = ASYNC_OCALL_SLOT_RESERVED;
+        slot->table = t_async_table;
+        g_async_owner[i] = get_thread_data();
+        g_async_tail++;
+        g_async_reserved++;
+        data = slot->data;
+    }
+    sgx_spin_unlock(&g_async_lock);
+    return data;
+}
+
+// Return the index of the slot reserved by the calling thread whose data
+// starts at ms, or ASYNC_OCALL_RING_SLOTS if ms is not in the ring.
+static size_t async_ring_find(const void *ms)
+{
+    if (ms == NULL || g_async_ring_state != ASYNC_RING_AVAILABLE)
+        return ASYNC_OCALL_RING_SLOTS;
+
+    size_t offset = reinterpret_cast<size_t>(ms) - reinterpret_cast<size_t>(g_async_ring->slots);
+    size_t i = offset / sizeof(async_ocall_slot_t);
+    if (reinterpret_cast<size_t>(ms) < reinterpret_cast<size_t>(g_async_ring->slots)
+        || i >= ASYNC_OCALL_RING_SLOTS
+        || ms != g_async_ring->slots[i].data
+        || g_async_owner[i] != get_thread_data())
+    {
+        return ASYNC_OCALL_RING_SLOTS;
+    }
+    return i;
+}
+
+static void async_ring_release(size_t i, uint32_t state)
+{
+    __sync_synchronize();
+    g_async_ring->slots[i].state = state;
+    sgx_spin_lock(&g_async_lock);
+    g_async_owner[i] = NULL;
+    g_async_reserved--;
+    sgx_spin_unlock(&g_async_lock);
+}
+
+// sgx_async_ocalloc()
+// Parameters:
+//      size - bytes of the marshaling structure and the buffers following it
+// Return Value:
+//      the data of a free ring slot, or space on the outside stack
+//      NULL - fail to allocate
+//
+void *sgx_async_ocalloc(size_t size)
+{
+    void *data = async_ring_reserve(size);
+    if (data != NULL)
+        return data;
+    return sgx_ocalloc(size);
+}
+
+// sgx_async_ocfree()
+// Cancel the slot the calling thread has reserved but not queued, if any,
+// and restore the outside stack as sgx_ocfree() does.
+//
+void sgx_async_ocfree()
+{
+    if (g_async_reserved != 0)
+    {
+        thread_data_t *thread_data = get_thread_data();
+        for (size_t i = 0; i < ASYNC_OCALL_RING_SLOTS; i++)
+        {
+            if (g_async_owner[i] == thread_data)
+                async_ring_release(i, ASYNC_OCALL_SLOT_CANCELLED);
+        }
+    }
+    sgx_ocfree();
+}
+
+// sgx_async_ocall()
+// Parameters:
+//      index - the index in the ocall table
+//      ms - the marshaling structure returned by sgx_async_ocalloc()
+// Return Value:
+//      SGX_SUCCESS once the OCALL is queued, or the status of the
+//      synchronous OCALL
+//
+sgx_status_t sgx_async_ocall(const unsigned int index, void *ms)
+{
+    size_t i = ASYNC_OCALL_RING_SLOTS;
+
+    if (ms == NULL)
+    {
+        void *data = async_ring_reserve(0);
+        if (data != NULL)
+            i = async_ring_find(data);
+    }
+    else
+    {
+        i = async_ring_find(ms);
+    }
+
+    if (i < ASYNC_OCALL_RING_SLOTS)
+    {
+        g_async_ring->slots[i].index = index;
+        async_ring_release(i, ASYNC_OCALL_SLOT_READY);
+        return SGX_SUCCESS;
+    }
+
+    // Keep the order with the OCALLs still in the ring.
+    if (g_async_ring_state == ASYNC_RING_AVAILABLE && g_async_ring->head != g_async_tail)
+    {
+        sgx_status_t status = sgx_ocall(ASYNC_OCALL_FLUSH, NULL);
+        if (status != SGX_SUCCESS)
+            return status;
+    }
+    return sgx_ocall(index, ms);
+}
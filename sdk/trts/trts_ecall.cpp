@@ -37,6 +37,7 @@
 #include "util.h"
 #include "xsave.h"
 #include "sgx_trts.h"
+#include "sgx_edger8r.h"
 #include "sgx_lfence.h"
 #include "sgx_spinlock.h"
 #include "global_init.h"
@@ -51,6 +52,7 @@
 #include "pthread_imp.h"
 #include "sgx_random_buffers.h"
 #include "se_page_attr.h"
+#include <stdlib.h>
 
 __attribute__((weak)) sgx_status_t _pthread_thread_run(void* ms) {UNUSED(ms); return SGX_SUCCESS;}
 __attribute__((weak)) bool _pthread_enabled() {return false;}
@@ -267,7 +269,12 @@ static sgx_status_t trts_ecall(uint32_t ordinal, void *ms)
 
         sgx_lfence();
 
+        //nested ECALLs only give back what they took from the arena
+        size_t arena_mark = sgx_ecall_arena_mark();
+
         status = func(ms);
+
+        sgx_ecall_arena_rewind(arena_mark);
     }
     
     return status;
@@ -363,6 +370,7 @@ sgx_status_t do_ecall(int index, void *ms, void *tcs)
     if(thread_data->stack_base_addr == thread_data->last_sp)
     {
         //root ecall
+        async_ocall_root_ecall();
         if(_pthread_enabled())
         {
             jmp_buf     buf = {0};
@@ -377,6 +385,8 @@ sgx_status_t do_ecall(int index, void *ms, void *tcs)
                 //Important: manually reset the last_sp
                 thread_data->last_sp = thread_data->stack_base_addr;
                 status = SGX_PTHREAD_EXIT;
+                //trts_ecall() didn't get the chance to rewind the arena
+                sgx_ecall_arena_rewind(0);
             }
             if(ECMD_ECALL_PTHREAD == index || SGX_PTHREAD_EXIT == status)
             {
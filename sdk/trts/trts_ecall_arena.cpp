@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2011-2020 Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of Intel Corporation nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "thread_data.h"
+#include "util.h"
+#include "sgx_edger8r.h"
+#include "sgx_spinlock.h"
+#include <stdlib.h>
+
+/* Per-TCS bump arena for the buffers of the trusted bridges, see
+ * SGX_ECALL_ARENA_THRESHOLD in the edger8r generated code. The arena can't
+ * be kept in TLS since TLS is re-initialized when a TCS is reused, so it
+ * is looked up by the TD address in a table which only ever grows.
+ */
+#define ECALL_ARENA_SIZE    0x1000
+#define ECALL_ARENA_ALIGN   16
+#define ECALL_ARENA_SLOTS   256     /* power of 2 */
+
+typedef struct _ecall_arena_t
+{
+    volatile size_t owner;          /* self_addr of the owner TD, 0 if free */
+    size_t          top;
+    uint8_t         *base;
+} ecall_arena_t;
+
+static ecall_arena_t g_ecall_arenas[ECALL_ARENA_SLOTS];
+static sgx_spinlock_t g_ecall_arena_lock = SGX_SPINLOCK_INITIALIZER;
+
+static ecall_arena_t *get_ecall_arena(bool create)
+{
+    size_t owner = (size_t)get_thread_data()->self_addr;
+    size_t start = owner >> SE_PAGE_SHIFT;
+
+    for (size_t i = 0; i < ECALL_ARENA_SLOTS; i++)
+    {
+        ecall_arena_t *arena = &g_ecall_arenas[(start + i) & (ECALL_ARENA_SLOTS - 1)];
+        if (arena->owner == owner)
+            return arena;
+        if (arena->owner != 0)
+            continue;
+        if (!create)
+            return NULL;
+
+        sgx_spin_lock(&g_ecall_arena_lock);
+        if (arena->owner == 0)
+        {
+            arena->base = (uint8_t *)malloc(ECALL_ARENA_SIZE);
+            arena->top = 0;
+            if (arena->base != NULL)
+                arena->owner = owner;
+            sgx_spin_unlock(&g_ecall_arena_lock);
+            return arena->base != NULL ? arena : NULL;
+        }
+        sgx_spin_unlock(&g_ecall_arena_lock);
+    }
+    return NULL;
+}
+
+extern "C" void *sgx_ecall_arena_alloc(size_t size)
+{
+    size_t aligned = ROUND_TO(size, ECALL_ARENA_ALIGN);
+    ecall_arena_t *arena = get_ecall_arena(true);
+
+    if (arena == NULL || aligned < size || aligned > ECALL_ARENA_SIZE - arena->top)
+        return malloc(size);
+
+    void *ptr = arena->base + arena->top;
+    arena->top += aligned;
+    return ptr;
+}
+
+extern "C" void sgx_ecall_arena_free(void *ptr)
+{
+    ecall_arena_t *arena = get_ecall_arena(false);
+
+    //arena buffers are given back when the ECALL returns
+    if (arena != NULL && (uint8_t *)ptr >= arena->base && (uint8_t *)ptr < arena->base + ECALL_ARENA_SIZE)
+        return;
+    free(ptr);
+}
+
+extern "C" size_t sgx_ecall_arena_mark(void)
+{
+    ecall_arena_t *arena = get_ecall_arena(false);
+    return arena != NULL ? arena->top : 0;
+}
+
+extern "C" void sgx_ecall_arena_rewind(size_t mark)
+{
+    ecall_arena_t *arena = get_ecall_arena(false);
+    if (arena != NULL && mark <= arena->top)
+        arena->top = mark;
+}
@@ -58,6 +58,7 @@ sgx_status_t do_ecall_add_thread(void *ms);
 sgx_status_t do_uninit_enclave(void *tcs);
 int check_static_stack_canary(void *tcs);
 sgx_status_t _pthread_thread_run(void* ms);
+void async_ocall_root_ecall();
 
 #ifdef __cplusplus
 }
@@ -53,7 +53,7 @@ extern "C" sgx_status_t __morestack(const unsigned int index, void *ms);
 sgx_status_t sgx_ocall(const unsigned int index, void *ms)
 {
     // the OCALL index should be within the ocall table range
-    // -2, -3 and -4 -5 should be allowed to test SDK 2.0 features
+    // the builtin OCALLs (-2 to -8) should be allowed to test SDK 2.0 features
     if((index != 0) && !is_builtin_ocall((int)index) &&
             static_cast<size_t>(index) >= g_dyn_entry_table.nr_ocall)
     {
@@ -53,6 +53,11 @@ typedef struct ms_trim_range_commit_ocall_t {
     size_t ms_addr;
 } ms_trim_range_commit_ocall_t;
 
+typedef struct ms_trim_range_commit_batch_ocall_t {
+    size_t ms_count;
+    /* followed by ms_count edmm_trim_range_t */
+} ms_trim_range_commit_batch_ocall_t;
+
 sgx_status_t SGXAPI trim_range_ocall(size_t fromaddr, size_t toaddr)
 {
     sgx_status_t status = SGX_SUCCESS;
@@ -84,3 +89,23 @@ sgx_status_t SGXAPI trim_range_commit_ocall(size_t addr)
     return status;
 }
 
+sgx_status_t SGXAPI trim_range_commit_batch_ocall(const edmm_trim_range_t *ranges, size_t count)
+{
+    sgx_status_t status = SGX_SUCCESS;
+
+    if (ranges == NULL || count == 0 || count > EDMM_TRIM_COMMIT_MAX_RANGES)
+        return SGX_ERROR_INVALID_PARAMETER;
+
+    ms_trim_range_commit_batch_ocall_t* ms;
+    OCALLOC(ms, ms_trim_range_commit_batch_ocall_t*, sizeof(*ms) + count * sizeof(edmm_trim_range_t));
+
+    ms->ms_count = count;
+    edmm_trim_range_t* ms_ranges = SGX_CAST(edmm_trim_range_t*, ms + 1);
+    for (size_t i = 0; i < count; i++)
+        ms_ranges[i] = ranges[i];
+    status = sgx_ocall(EDMM_TRIM_COMMIT_BATCH, ms);
+
+
+    sgx_ocfree();
+    return status;
+}
@@ -40,6 +40,7 @@
 
 
 #include <stdlib.h> // for size_t
+#include "internal/rts.h" // for edmm_trim_range_t
 
 #define SGX_CAST(type, item) ((type)(item))
 
@@ -49,6 +50,7 @@ extern "C" {
 
 sgx_status_t SGXAPI trim_range_ocall(size_t fromaddr, size_t toaddr);
 sgx_status_t SGXAPI trim_range_commit_ocall(size_t addr);
+sgx_status_t SGXAPI trim_range_commit_batch_ocall(const edmm_trim_range_t *ranges, size_t count);
 
 #ifdef __cplusplus
 }